@@ -0,0 +1,150 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+/* Replacement of the global operators new and delete counting the allocations of the benchmarks, in its own translation unit so that
+ * the compiler does not see the replaced functions and their callers together. All the variants are replaced (array, nothrow, sized and,
+ * when the compiler provides them, aligned), so that every allocation through operator new is counted, from any thread. */
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+namespace {
+
+    std::atomic<unsigned long long> allocations(0);
+
+    void *allocate(std::size_t size){
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        void *p = std::malloc(size > 0 ? size : 1);
+        if(p == NULL)
+            throw std::bad_alloc();
+        return p;
+    }
+
+#ifdef __cpp_aligned_new
+    void *allocate(std::size_t size, std::align_val_t alignment){
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        const std::size_t align = static_cast<std::size_t>(alignment);
+        /* the size given to aligned_alloc needs to be a multiple of the alignment */
+        void *p = std::aligned_alloc(align, ((size > 0 ? size : 1) + align - 1) / align * align);
+        if(p == NULL)
+            throw std::bad_alloc();
+        return p;
+    }
+#endif
+
+}
+
+namespace smartmath
+{
+    namespace benchmark {
+
+        unsigned long long allocation_count(){
+            return allocations.load(std::memory_order_relaxed);
+        }
+
+    }
+}
+
+void *operator new(std::size_t size){
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size){
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept{
+    try
+    {
+        return allocate(size);
+    }
+    catch(...)
+    {
+        return NULL;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept{
+    return operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept{
+    std::free(p);
+}
+
+#ifdef __cpp_aligned_new
+void *operator new(std::size_t size, std::align_val_t alignment){
+    return allocate(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment){
+    return allocate(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept{
+    try
+    {
+        return allocate(size, alignment);
+    }
+    catch(...)
+    {
+        return NULL;
+    }
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &tag) noexcept{
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept{
+    std::free(p);
+}
+#endif
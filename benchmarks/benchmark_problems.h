@@ -0,0 +1,464 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_BENCHMARK_PROBLEMS_H
+#define SMARTMATH_BENCHMARK_PROBLEMS_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include "../include/smartmath.h"
+
+namespace smartmath
+{
+    namespace benchmark {
+
+        /**
+         * @brief allocation_count returns the number of allocations through any variant of operator new, from any thread, since the start of the program (see allocation_counter.cpp)
+         * @return number of allocations
+         */
+        unsigned long long allocation_count();
+
+        /**
+         * @brief evaluation_counter number of evaluations of the dynamics made through the batch wrappers (the forces for the Hamiltonian ones)
+         * @return counter
+         */
+        inline unsigned long long &evaluation_counter(){
+            static unsigned long long count = 0;
+            return count;
+        }
+
+        /**
+         * @brief block returns the view on the i-th block of d components of a view
+         */
+        template < class T >
+        const_state_view<T> block(const const_state_view<T> &x, const unsigned int &i, const unsigned int &d){
+            return const_state_view<T>(x.data() + i * d * x.stride(), d, x.stride());
+        }
+
+        /**
+         * @brief block returns the view on the i-th block of d components of a view
+         */
+        template < class T >
+        state_view<T> block(const state_view<T> &x, const unsigned int &i, const unsigned int &d){
+            return state_view<T>(x.data() + i * d * x.stride(), d, x.stride());
+        }
+
+        /**
+         * @brief The %batch_dynamics class stacks independent copies of a dynamical system in one state, the copies being stored one after the other
+         *
+         * The Jacobian is declared block-diagonal so that BDF uses its sparse path. Not thread-safe: the blocks are copied in work vectors.
+         */
+        template < class T >
+        class batch_dynamics: public dynamics::base_dynamics<T>
+        {
+
+        public:
+            /**
+             * @brief batch_dynamics constructor
+             * @param dyn dynamical system of one copy
+             * @param dimension dimension of the state of one copy
+             * @param copies number of copies
+             */
+            batch_dynamics(const dynamics::base_dynamics<T> *dyn, const unsigned int &dimension, const unsigned int &copies):
+                dynamics::base_dynamics<T>(dyn->get_name()), m_dyn(dyn), m_dimension(dimension), m_copies(copies), m_x(dimension), m_dx(dimension){}
+
+            int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const{
+                evaluation_counter()++;
+                if(m_copies == 1)
+                    return m_dyn->evaluate(t, state, dstate);
+
+                dstate.resize(state.size());
+                for(unsigned int i = 0; i < m_copies; i++)
+                {
+                    std::copy(state.begin() + i * m_dimension, state.begin() + (i + 1) * m_dimension, m_x.begin());
+                    m_dyn->evaluate(t, m_x, m_dx);
+                    std::copy(m_dx.begin(), m_dx.end(), dstate.begin() + i * m_dimension);
+                }
+                return 0;
+            }
+
+            bool sparsity_pattern(const unsigned int &n, std::vector<std::vector<unsigned int> > &pattern) const{
+                if(m_copies == 1)
+                    return false;
+                pattern.assign(n, std::vector<unsigned int>());
+                for(unsigned int j = 0; j < n; j++)
+                {
+                    const unsigned int first = (j / m_dimension) * m_dimension;
+                    for(unsigned int i = first; i < first + m_dimension; i++)
+                        pattern[j].push_back(i);
+                }
+                return true;
+            }
+
+        private:
+            const dynamics::base_dynamics<T> *m_dyn;
+            unsigned int m_dimension, m_copies;
+            mutable std::vector<T> m_x, m_dx;
+        };
+
+        /**
+         * @brief The %batch_hamiltonian class stacks independent copies of a Hamiltonian system, the state being the positions of all the copies followed by their momenta
+         */
+        template < class T >
+        class batch_hamiltonian: public dynamics::base_hamiltonian<T>
+        {
+
+        public:
+            /**
+             * @brief batch_hamiltonian constructor
+             * @param ham Hamiltonian system of one copy
+             * @param copies number of copies
+             */
+            batch_hamiltonian(const dynamics::base_hamiltonian<T> *ham, const unsigned int &copies):
+                dynamics::base_hamiltonian<T>(ham->get_name(), ham->get_dim() * copies, ham->is_separable()), m_ham(ham), m_copies(copies){}
+
+            int DHq(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
+                evaluation_counter()++;
+                const unsigned int d = m_ham->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_ham->DHq(t, block(q, i, d), block(p, i, d), block(dH, i, d));
+                return 0;
+            }
+
+            int DHp(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
+                const unsigned int d = m_ham->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_ham->DHp(t, block(q, i, d), block(p, i, d), block(dH, i, d));
+                return 0;
+            }
+
+        private:
+            const dynamics::base_hamiltonian<T> *m_ham;
+            unsigned int m_copies;
+        };
+
+        /**
+         * @brief The %batch_mixedvar class stacks independent copies of a Hamiltonian system with mixed variables, with the layout of %batch_hamiltonian
+         */
+        template < class T >
+        class batch_mixedvar: public dynamics::hamiltonian_mixedvar<T>
+        {
+
+        public:
+            /**
+             * @brief batch_mixedvar constructor
+             * @param mix Hamiltonian system with mixed variables of one copy
+             * @param copies number of copies
+             */
+            batch_mixedvar(const dynamics::hamiltonian_mixedvar<T> *mix, const unsigned int &copies):
+                dynamics::hamiltonian_mixedvar<T>(mix->get_name(), mix->get_dim() * copies, mix->is_separable()), m_mix(mix), m_copies(copies){}
+
+            int DHq(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
+                evaluation_counter()++;
+                const unsigned int d = m_mix->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_mix->DHq(t, block(q, i, d), block(p, i, d), block(dH, i, d));
+                return 0;
+            }
+
+            int DHp(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
+                const unsigned int d = m_mix->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_mix->DHp(t, block(q, i, d), block(p, i, d), block(dH, i, d));
+                return 0;
+            }
+
+            int DHq2(const double &t, const_state_view<T> q2, const_state_view<T> p2, state_view<T> dH2) const{
+                const unsigned int d = m_mix->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_mix->DHq2(t, block(q2, i, d), block(p2, i, d), block(dH2, i, d));
+                return 0;
+            }
+
+            int DHp2(const double &t, const_state_view<T> q2, const_state_view<T> p2, state_view<T> dH2) const{
+                const unsigned int d = m_mix->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_mix->DHp2(t, block(q2, i, d), block(p2, i, d), block(dH2, i, d));
+                return 0;
+            }
+
+            int conversion(const_state_view<T> q, const_state_view<T> p, state_view<T> q2, state_view<T> p2) const{
+                const unsigned int d = m_mix->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_mix->conversion(block(q, i, d), block(p, i, d), block(q2, i, d), block(p2, i, d));
+                return 0;
+            }
+
+            int conversion2(const_state_view<T> q2, const_state_view<T> p2, state_view<T> q, state_view<T> p) const{
+                const unsigned int d = m_mix->get_dim();
+                for(unsigned int i = 0; i < m_copies; i++)
+                    m_mix->conversion2(block(q2, i, d), block(p2, i, d), block(q, i, d), block(p, i, d));
+                return 0;
+            }
+
+        private:
+            const dynamics::hamiltonian_mixedvar<T> *m_mix;
+            unsigned int m_copies;
+        };
+
+        /**
+         * @brief make_dynamics builds one of the dynamical systems of the benchmarks with its parameters, for any scalar type (spring only exists in double precision)
+         * @param[in] name pendulum, vanderpol, lotkavolterra or spaceflight
+         * @return dynamics, to be deleted by the caller
+         */
+        template < class T >
+        dynamics::base_dynamics<T> *make_dynamics(const std::string &name){
+            if(name == "pendulum")
+                return new dynamics::pendulum<T>();
+            if(name == "vanderpol")
+                return new dynamics::vanderpol<T>(1.0);
+            if(name == "lotkavolterra")
+                return new dynamics::lotkavolterra<T>(std::vector<T>({1.5, 1.0, 3.0, 1.0}));
+            if(name == "spaceflight")
+            {
+                /* low Earth orbit without thrust nor drag, in SI units */
+                std::vector<T> param(10, 0.0);
+                param[5] = 7000.0;
+                return new dynamics::spaceflight<T>(param);
+            }
+            smartmath_throw("MAKE_DYNAMICS: unknown dynamics " + name);
+            return NULL;
+        }
+
+        /**
+         * @brief initial_conditions returns the initial state of one copy and the time span of a benchmark problem
+         * @param[in] name name of the dynamical system
+         * @param[out] x0 initial state (positions then momenta for the Hamiltonian systems)
+         * @param[out] span duration of the integration
+         */
+        inline void initial_conditions(const std::string &name, std::vector<double> &x0, double &span){
+            span = 10.0;
+            if(name == "pendulum")
+                x0 = {0.1, 0.01};
+            else if(name == "spring")
+                x0 = {1.0, 0.5};
+            else if(name == "vanderpol")
+                x0 = {2.0, 0.0};
+            else if(name == "lotkavolterra")
+                x0 = {10.0, 5.0};
+            else if(name == "spaceflight")
+            {
+                x0 = {7.0e6, 0.0, 0.0, 0.0, 7546.0, 100.0, 1000.0};
+                span = 3000.0;
+            }
+            else
+                smartmath_throw("INITIAL_CONDITIONS: unknown dynamics " + name);
+        }
+
+        /**
+         * @brief The %benchmark_problem class sets up one of the dynamical systems of the library with initial conditions, time span and a number of independent copies
+         *
+         * The copies start from initial conditions scaled by 1 + 0.001 i. Problems: pendulum, spring, vanderpol, lotkavolterra and spaceflight.
+         */
+        class benchmark_problem
+        {
+
+        public:
+            /**
+             * @brief benchmark_problem constructor
+             * @param name name of the dynamical system
+             * @param copies number of copies
+             */
+            benchmark_problem(const std::string &name, const unsigned int &copies): m_name(name), m_copies(copies), m_t0(1000.0){
+
+                if(copies == 0)
+                    smartmath_throw("BENCHMARK_PROBLEM: the number of copies needs to be positive");
+
+                initial_conditions(name, m_x0, m_span);
+                if(name == "spring")
+                {
+                    dynamics::spring<double> *mix = new dynamics::spring<double>();
+                    m_dyn.reset(mix);
+                    m_mix.reset(new batch_mixedvar<double>(mix, copies));
+                }
+                else
+                {
+                    m_dyn.reset(make_dynamics<double>(name));
+                    const dynamics::base_hamiltonian<double> *ham = dynamic_cast<const dynamics::base_hamiltonian<double> *>(m_dyn.get());
+                    if(ham != NULL)
+                        m_ham.reset(new batch_hamiltonian<double>(ham, copies));
+                }
+
+                m_batch.reset(new batch_dynamics<double>(m_dyn.get(), m_x0.size(), copies));
+            }
+
+            /**
+             * @brief names returns the names of the problems
+             */
+            static std::vector<std::string> names(){
+                return {"pendulum", "spring", "vanderpol", "lotkavolterra", "spaceflight"};
+            }
+
+            std::string get_name() const{
+                return m_name;
+            }
+
+            unsigned int get_copies() const{
+                return m_copies;
+            }
+
+            /**
+             * @brief get_dimension returns the dimension of the stacked state
+             */
+            unsigned int get_dimension() const{
+                return m_x0.size() * m_copies;
+            }
+
+            double get_t0() const{
+                return m_t0;
+            }
+
+            double get_tf() const{
+                return m_t0 + m_span;
+            }
+
+            /**
+             * @brief get_dynamics returns the stacked dynamics (copies one after the other)
+             */
+            const dynamics::base_dynamics<double> *get_dynamics() const{
+                return m_batch.get();
+            }
+
+            /**
+             * @brief get_hamiltonian returns the stacked Hamiltonian (NULL if the system has no such form for the standard symplectic integrators)
+             */
+            const dynamics::base_hamiltonian<double> *get_hamiltonian() const{
+                return m_ham.get();
+            }
+
+            /**
+             * @brief get_mixedvar returns the stacked Hamiltonian with mixed variables (NULL if the system has no such form)
+             */
+            const dynamics::hamiltonian_mixedvar<double> *get_mixedvar() const{
+                return m_mix.get();
+            }
+
+            /**
+             * @brief initial_state returns the stacked initial conditions
+             * @param[in] hamiltonian true for the layout of the Hamiltonian wrappers (all positions then all momenta), false for the copies one after the other
+             * @return initial state
+             */
+            std::vector<double> initial_state(const bool &hamiltonian) const{
+                const unsigned int d = m_x0.size();
+                std::vector<double> x(d * m_copies);
+                for(unsigned int i = 0; i < m_copies; i++)
+                {
+                    for(unsigned int j = 0; j < d; j++)
+                        x[state_index(i, j, hamiltonian)] = m_x0[j] * (1.0 + 1.0e-3 * double(i));
+                }
+                return x;
+            }
+
+            /**
+             * @brief state_index returns the index in the stacked state of the j-th component of the i-th copy
+             * @param[in] i copy
+             * @param[in] j component of the state of one copy
+             * @param[in] hamiltonian layout (see initial_state())
+             * @return index
+             */
+            unsigned int state_index(const unsigned int &i, const unsigned int &j, const bool &hamiltonian) const{
+                const unsigned int d = m_x0.size();
+                if(!hamiltonian)
+                    return i * d + j;
+                const unsigned int half = d / 2;
+                return (j < half) ? i * half + j : m_copies * half + i * half + (j - half);
+            }
+
+        private:
+            std::string m_name;
+            unsigned int m_copies;
+            double m_t0, m_span;
+            std::vector<double> m_x0;
+            std::unique_ptr< dynamics::base_dynamics<double> > m_dyn;
+            std::unique_ptr< batch_dynamics<double> > m_batch;
+            std::unique_ptr< batch_hamiltonian<double> > m_ham;
+            std::unique_ptr< batch_mixedvar<double> > m_mix;
+        };
+
+        /**
+         * @brief The %integrator_kind enumeration tells how an integrator is driven and which form of the dynamics it needs
+         */
+        enum integrator_kind
+        {
+            FIXED_STEP = 0,
+            ADAPTIVE = 1,
+            SYMPLECTIC = 2,
+            MIXEDVAR = 3
+        };
+
+        /**
+         * @brief integrator_names returns the names of the integrators of smartmath_integrators.h
+         */
+        inline std::vector<std::string> integrator_names(){
+            return {"euler", "midpoint", "heun", "rk4", "AB", "ABM", "BDF", "rkf45", "rk87", "bulirschstoer",
+                    "euler_symplectic", "leapfrog", "forest", "yoshida6", "euler_mixedvar", "leapfrog_mixedvar", "forest_mixedvar", "yoshida6_mixedvar"};
+        }
+
+        /**
+         * @brief get_kind returns the kind of an integrator
+         * @param[in] name integrator name (see integrator_names())
+         * @return kind
+         */
+        inline integrator_kind get_kind(const std::string &name){
+            if(name == "BDF" || name == "rkf45" || name == "rk87")
+                return ADAPTIVE;
+            if(name.find("_mixedvar") != std::string::npos)
+                return MIXEDVAR;
+            if(name == "euler_symplectic" || name == "leapfrog" || name == "forest" || name == "yoshida6")
+                return SYMPLECTIC;
+            return FIXED_STEP;
+        }
+
+        /**
+         * @brief make_integrator builds an integrator for a problem
+         * @param[in] name integrator name (see integrator_names())
+         * @param[in] problem problem to be integrated
+         * @param[in] tol tolerance of the adaptive integrators
+         * @return integrator, NULL if it cannot integrate the problem
+         */
+        inline std::unique_ptr< integrator::base_integrator<double> > make_integrator(const std::string &name, const benchmark_problem &problem, const double &tol){
+
+            typedef std::unique_ptr< integrator::base_integrator<double> > pointer;
+            const dynamics::base_dynamics<double> *dyn = problem.get_dynamics();
+            const dynamics::base_hamiltonian<double> *ham = problem.get_hamiltonian();
+            const dynamics::hamiltonian_mixedvar<double> *mix = problem.get_mixedvar();
+            pointer integrator;
+
+            if(name == "euler") integrator.reset(new integrator::euler<double>(dyn));
+            else if(name == "midpoint") integrator.reset(new integrator::midpoint<double>(dyn));
+            else if(name == "heun") integrator.reset(new integrator::heun<double>(dyn));
+            else if(name == "rk4") integrator.reset(new integrator::rk4<double>(dyn));
+            else if(name == "AB") integrator.reset(new integrator::AB<double>(dyn));
+            else if(name == "ABM") integrator.reset(new integrator::ABM<double>(dyn));
+            else if(name == "BDF") integrator.reset(new integrator::BDF<double>(dyn, 5, tol));
+            else if(name == "rkf45") integrator.reset(new integrator::rkf45<double>(dyn, tol));
+            else if(name == "rk87") integrator.reset(new integrator::rk87<double>(dyn, tol));
+            else if(name == "bulirschstoer") integrator.reset(new integrator::bulirschstoer<double>(dyn));
+            else if(name == "euler_symplectic") { if(ham) integrator.reset(new integrator::euler_symplectic<double>(ham, true)); }
+            else if(name == "leapfrog") { if(ham) integrator.reset(new integrator::leapfrog<double>(ham, true)); }
+            else if(name == "forest") { if(ham) integrator.reset(new integrator::forest<double>(ham)); }
+            else if(name == "yoshida6") { if(ham) integrator.reset(new integrator::yoshida6<double>(ham)); }
+            else if(name == "euler_mixedvar") { if(mix) integrator.reset(new integrator::euler_mixedvar<double>(mix, true)); }
+            else if(name == "leapfrog_mixedvar") { if(mix) integrator.reset(new integrator::leapfrog_mixedvar<double>(mix, true)); }
+            else if(name == "forest_mixedvar") { if(mix) integrator.reset(new integrator::forest_mixedvar<double>(mix)); }
+            else if(name == "yoshida6_mixedvar") { if(mix) integrator.reset(new integrator::yoshida6_mixedvar<double>(mix)); }
+            else
+                smartmath_throw("MAKE_INTEGRATOR: unknown integrator " + name);
+
+            if(integrator)
+                integrator->set_comments(false);
+            return integrator;
+        }
+
+    }
+}
+
+#endif // SMARTMATH_BENCHMARK_PROBLEMS_H
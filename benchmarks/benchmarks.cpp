@@ -0,0 +1,208 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+/* Benchmark of every integrator on every dynamical system of the library, for several numbers of independent copies of the system
+ * (state sizes) and several numbers of steps (tolerances for the adaptive integrators).
+ *
+ * usage: benchmarks [--csv file] [--json file] [--filter text] [--min-time seconds] [--quick]
+ *
+ * For each case, the integration is repeated until min-time is spent (at least once) and the fastest repetition is reported:
+ * ns_per_step, evaluations_per_second and allocations_per_step (allocations through operator new during the first repetition).
+ * The results are printed as CSV unless --csv is given. */
+
+#include "benchmark_problems.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <fstream>
+#include <iostream>
+
+using namespace smartmath;
+
+/* measurement of one case */
+struct benchmark_result
+{
+    std::string integrator, dynamics, error;
+    unsigned int copies, dimension;
+    int nsteps;
+    double tolerance;
+    unsigned long steps;
+    unsigned long long evaluations, allocations;
+    unsigned int repetitions;
+    double seconds;
+};
+
+benchmark_result run_case(const std::string &name, const benchmark::benchmark_problem &problem, const int &nsteps, const double &tol, const double &min_time){
+
+    benchmark_result result;
+    result.integrator = name;
+    result.dynamics = problem.get_name();
+    result.copies = problem.get_copies();
+    result.dimension = problem.get_dimension();
+    result.nsteps = nsteps;
+    result.tolerance = tol;
+    result.steps = 0;
+    result.evaluations = 0;
+    result.allocations = 0;
+    result.repetitions = 0;
+    result.seconds = std::numeric_limits<double>::infinity();
+
+    std::unique_ptr< integrator::base_integrator<double> > integrator = benchmark::make_integrator(name, problem, tol);
+    const benchmark::integrator_kind kind = benchmark::get_kind(name);
+    const std::vector<double> x0 = problem.initial_state(kind == benchmark::SYMPLECTIC || kind == benchmark::MIXEDVAR);
+    std::vector<double> xf(x0);
+
+    double total = 0.0;
+    try
+    {
+        do
+        {
+            const unsigned long long evaluations = benchmark::evaluation_counter(), allocations = benchmark::allocation_count();
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            integrator->integrate(problem.get_t0(), problem.get_tf(), nsteps, x0, xf);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if(result.repetitions == 0)
+            {
+                result.evaluations = benchmark::evaluation_counter() - evaluations;
+                result.allocations = benchmark::allocation_count() - allocations;
+                result.steps = integrator->get_statistics().steps_accepted;
+            }
+            result.seconds = std::min(result.seconds, seconds);
+            result.repetitions++;
+            total += seconds;
+        }
+        while(total < min_time);
+    }
+    catch(const std::exception &e)
+    {
+        /* kept printable in quotes by CSV and JSON */
+        result.error = e.what();
+        std::replace(result.error.begin(), result.error.end(), '"', '\'');
+        std::replace(result.error.begin(), result.error.end(), '\\', '/');
+    }
+
+    return result;
+}
+
+void write_csv(std::ostream &os, const std::vector<benchmark_result> &results){
+    os << "integrator,dynamics,copies,dimension,nsteps,tolerance,steps,evaluations,seconds,ns_per_step,evaluations_per_second,allocations_per_step,repetitions,error" << std::endl;
+    for(unsigned int k = 0; k < results.size(); k++)
+    {
+        const benchmark_result &r = results[k];
+        const double steps = std::max(1.0, double(r.steps));
+        os << r.integrator << "," << r.dynamics << "," << r.copies << "," << r.dimension << "," << r.nsteps << "," << r.tolerance << "," << r.steps << "," << r.evaluations << ",";
+        if(r.error.empty())
+            os << r.seconds << "," << 1.0e9 * r.seconds / steps << "," << double(r.evaluations) / r.seconds << "," << double(r.allocations) / steps << "," << r.repetitions << "," << std::endl;
+        else
+            os << ",,,,," << "\"" << r.error << "\"" << std::endl;
+    }
+}
+
+void write_json(std::ostream &os, const std::vector<benchmark_result> &results){
+    os << "{\"benchmarks\": [";
+    for(unsigned int k = 0; k < results.size(); k++)
+    {
+        const benchmark_result &r = results[k];
+        const double steps = std::max(1.0, double(r.steps));
+        os << (k == 0 ? "\n" : ",\n") << "  {\"integrator\": \"" << r.integrator << "\", \"dynamics\": \"" << r.dynamics << "\", \"copies\": " << r.copies << ", \"dimension\": " << r.dimension
+           << ", \"nsteps\": " << r.nsteps << ", \"tolerance\": " << r.tolerance << ", \"steps\": " << r.steps << ", \"evaluations\": " << r.evaluations;
+        if(r.error.empty())
+            os << ", \"seconds\": " << r.seconds << ", \"ns_per_step\": " << 1.0e9 * r.seconds / steps << ", \"evaluations_per_second\": " << double(r.evaluations) / r.seconds
+               << ", \"allocations_per_step\": " << double(r.allocations) / steps << ", \"repetitions\": " << r.repetitions << "}";
+        else
+            os << ", \"error\": \"" << r.error << "\"}";
+    }
+    os << "\n]}" << std::endl;
+}
+
+int main(int argc, char **argv){
+
+    std::string csv_file, json_file, filter;
+    double min_time = 0.05;
+    std::vector<unsigned int> copies = {1, 8, 64};
+    std::vector<int> nsteps = {1000, 10000};
+    std::vector<double> tolerances = {1.0e-6, 1.0e-10};
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if(arg == "--quick")
+        {
+            min_time = 0.0;
+            copies = {1, 8};
+            nsteps = {1000};
+            tolerances = {1.0e-6};
+        }
+        else if(arg == "--csv" && i + 1 < argc)
+            csv_file = argv[++i];
+        else if(arg == "--json" && i + 1 < argc)
+            json_file = argv[++i];
+        else if(arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if(arg == "--min-time" && i + 1 < argc)
+            min_time = std::atof(argv[++i]);
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--csv file] [--json file] [--filter text] [--min-time seconds] [--quick]" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<std::string> integrators = benchmark::integrator_names(), problems = benchmark::benchmark_problem::names();
+    std::vector<benchmark_result> results;
+
+    for(unsigned int p = 0; p < problems.size(); p++)
+    {
+        for(unsigned int c = 0; c < copies.size(); c++)
+        {
+            benchmark::benchmark_problem problem(problems[p], copies[c]);
+            for(unsigned int k = 0; k < integrators.size(); k++)
+            {
+                const std::string &name = integrators[k];
+                if(!filter.empty() && name.find(filter) == std::string::npos && problems[p].find(filter) == std::string::npos)
+                    continue;
+                if(!benchmark::make_integrator(name, problem, 1.0e-6))
+                    continue;
+
+                if(benchmark::get_kind(name) == benchmark::ADAPTIVE)
+                {
+                    for(unsigned int j = 0; j < tolerances.size(); j++)
+                        results.push_back(run_case(name, problem, 100, tolerances[j], min_time));
+                }
+                else
+                {
+                    for(unsigned int j = 0; j < nsteps.size(); j++)
+                        results.push_back(run_case(name, problem, nsteps[j], 0.0, min_time));
+                }
+
+                if(!csv_file.empty() || !json_file.empty())
+                    std::cerr << results.back().integrator << " on " << results.back().dynamics << " x" << results.back().copies << std::endl;
+            }
+        }
+    }
+
+    if(csv_file.empty())
+        write_csv(std::cout, results);
+    else
+    {
+        std::ofstream os(csv_file.c_str());
+        write_csv(os, results);
+    }
+    if(!json_file.empty())
+    {
+        std::ofstream os(json_file.c_str());
+        write_json(os, results);
+    }
+
+    return 0;
+}
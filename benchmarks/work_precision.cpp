@@ -0,0 +1,304 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+/* Work-precision data of integrators against high-accuracy reference solutions.
+ *
+ * usage: work_precision [--dynamics a,b,...] [--integrators a,b,...|all] [--csv file] [--json file] [--min-time seconds]
+ *
+ * For each pair of dynamics and integrator, the number of steps (fixed step integrators) is doubled from 16 and the tolerance
+ * (adaptive integrators) is divided by 10 from 1e-2, until the error is below 1e-13, stops decreasing below 1e-10 (roundoff) or the sweep is exhausted.
+ * Failed or unstable runs have a NaN error.
+ * The error is the maximum difference with the reference final state relative to the maximum component of the reference,
+ * which is the analytic solution for spring and an integration with rk87 in long double at tolerance 1e-18 otherwise.
+ * Each point gives the error against the number of evaluations and the time of the fastest repetition (min-time as in benchmarks).
+ * The points are printed as CSV on the standard output unless --csv is given. The summary is then printed on the standard output, after the CSV and an empty line if any:
+ * the cheapest integrator in evaluations and in time reaching each accuracy from 1e-3 to 1e-12 (the mixed variable integrators solve spring exactly, their perturbation being zero). */
+
+#include "benchmark_problems.h"
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+using namespace smartmath;
+
+/* measurement of one point of the diagram */
+struct precision_result
+{
+    std::string integrator, dynamics;
+    int nsteps;
+    double tolerance;
+    unsigned long steps;
+    unsigned long long evaluations;
+    double seconds, error;
+};
+
+std::vector<std::string> split(const std::string &list){
+    std::vector<std::string> names;
+    std::stringstream ss(list);
+    std::string name;
+    while(std::getline(ss, name, ','))
+    {
+        if(!name.empty())
+            names.push_back(name);
+    }
+    return names;
+}
+
+/* final state of one copy of the problem, in extended precision */
+std::vector<long double> reference_solution(const benchmark::benchmark_problem &problem){
+
+    std::vector<double> x0;
+    double span;
+    benchmark::initial_conditions(problem.get_name(), x0, span);
+    std::vector<long double> xf(x0.begin(), x0.end());
+
+    if(problem.get_name() == "spring")
+    {
+        /* harmonic oscillator of unit frequency */
+        const long double c = std::cos((long double)(span)), s = std::sin((long double)(span));
+        xf[0] = c * (long double)(x0[0]) + s * (long double)(x0[1]);
+        xf[1] = c * (long double)(x0[1]) - s * (long double)(x0[0]);
+        return xf;
+    }
+
+    std::unique_ptr< dynamics::base_dynamics<long double> > dyn(benchmark::make_dynamics<long double>(problem.get_name()));
+    integrator::rk87<long double> reference(dyn.get(), 1.0e-18);
+    reference.set_comments(false);
+    const std::vector<long double> x(xf);
+    reference.integrate(problem.get_t0(), problem.get_tf(), 1000, x, xf);
+    return xf;
+}
+
+precision_result run_point(const std::string &name, const benchmark::benchmark_problem &problem, const std::vector<long double> &reference, const int &nsteps, const double &tol, const double &min_time){
+
+    precision_result result;
+    result.integrator = name;
+    result.dynamics = problem.get_name();
+    result.nsteps = nsteps;
+    result.tolerance = tol;
+    result.steps = 0;
+    result.evaluations = 0;
+    result.seconds = std::numeric_limits<double>::infinity();
+    result.error = std::numeric_limits<double>::quiet_NaN();
+
+    std::unique_ptr< integrator::base_integrator<double> > integrator = benchmark::make_integrator(name, problem, tol);
+    const benchmark::integrator_kind kind = benchmark::get_kind(name);
+    const bool hamiltonian = (kind == benchmark::SYMPLECTIC || kind == benchmark::MIXEDVAR);
+    const std::vector<double> x0 = problem.initial_state(hamiltonian);
+    std::vector<double> xf(x0);
+
+    double total = 0.0;
+    unsigned int repetitions = 0;
+    try
+    {
+        do
+        {
+            const unsigned long long evaluations = benchmark::evaluation_counter();
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            integrator->integrate(problem.get_t0(), problem.get_tf(), nsteps, x0, xf);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if(repetitions == 0)
+            {
+                result.evaluations = benchmark::evaluation_counter() - evaluations;
+                result.steps = integrator->get_statistics().steps_accepted;
+            }
+            result.seconds = std::min(result.seconds, seconds);
+            repetitions++;
+            total += seconds;
+        }
+        while(total < min_time);
+    }
+    catch(const std::exception &e)
+    {
+        return result;
+    }
+
+    long double error = 0.0, scale = 0.0;
+    for(unsigned int j = 0; j < reference.size(); j++)
+    {
+        const double x = xf[problem.state_index(0, j, hamiltonian)];
+        /* an unstable run is a failure */
+        if(!std::isfinite(x))
+            return result;
+        error = std::max(error, std::fabs((long double)(x) - reference[j]));
+        scale = std::max(scale, std::fabs(reference[j]));
+    }
+    result.error = double(error / std::max(scale, (long double)(1.0)));
+
+    return result;
+}
+
+void write_csv(std::ostream &os, const std::vector<precision_result> &results){
+    os << "dynamics,integrator,nsteps,tolerance,steps,evaluations,seconds,error" << std::endl;
+    for(unsigned int k = 0; k < results.size(); k++)
+    {
+        const precision_result &r = results[k];
+        os << r.dynamics << "," << r.integrator << "," << r.nsteps << "," << r.tolerance << "," << r.steps << "," << r.evaluations << "," << r.seconds << "," << r.error << std::endl;
+    }
+}
+
+/* failed runs have infinite times and NaN errors, which are null in JSON */
+void write_json_number(std::ostream &os, const double &x){
+    if(std::isfinite(x))
+        os << x;
+    else
+        os << "null";
+}
+
+void write_json(std::ostream &os, const std::vector<precision_result> &results){
+    os << "{\"work_precision\": [";
+    for(unsigned int k = 0; k < results.size(); k++)
+    {
+        const precision_result &r = results[k];
+        os << (k == 0 ? "\n" : ",\n") << "  {\"dynamics\": \"" << r.dynamics << "\", \"integrator\": \"" << r.integrator << "\", \"nsteps\": " << r.nsteps
+           << ", \"tolerance\": " << r.tolerance << ", \"steps\": " << r.steps << ", \"evaluations\": " << r.evaluations
+           << ", \"seconds\": ";
+        write_json_number(os, r.seconds);
+        os << ", \"error\": ";
+        write_json_number(os, r.error);
+        os << "}";
+    }
+    os << "\n]}" << std::endl;
+}
+
+/* true when the sweep of an integrator can stop: the error reached the target or the roundoff floor (below 1e-10 and not halved by the last refinement) */
+bool sweep_done(const std::vector<precision_result> &results, const double &target){
+    const precision_result &last = results.back();
+    if(last.error <= target)
+        return true;
+    if(results.size() < 2)
+        return false;
+    const precision_result &previous = results[results.size() - 2];
+    return previous.integrator == last.integrator && previous.dynamics == last.dynamics && previous.error < 1.0e-10 && !(last.error < 0.5 * previous.error);
+}
+
+/* cheapest integrator of each dynamics reaching each accuracy, in evaluations and in time */
+void write_summary(std::ostream &os, const std::vector<std::string> &problems, const std::vector<precision_result> &results){
+    os << "dynamics,accuracy,cheapest_in_evaluations,evaluations,cheapest_in_time,seconds" << std::endl;
+    for(unsigned int p = 0; p < problems.size(); p++)
+    {
+        for(int e = 3; e <= 12; e++)
+        {
+            const double accuracy = std::pow(10.0, -e);
+            const precision_result *by_evaluations = NULL, *by_time = NULL;
+            for(unsigned int k = 0; k < results.size(); k++)
+            {
+                const precision_result &r = results[k];
+                if(r.dynamics != problems[p] || !(r.error <= accuracy))
+                    continue;
+                if(by_evaluations == NULL || r.evaluations < by_evaluations->evaluations)
+                    by_evaluations = &r;
+                if(by_time == NULL || r.seconds < by_time->seconds)
+                    by_time = &r;
+            }
+            os << problems[p] << "," << accuracy << ",";
+            if(by_evaluations == NULL)
+                os << "none,,none," << std::endl;
+            else
+                os << by_evaluations->integrator << "," << by_evaluations->evaluations << "," << by_time->integrator << "," << by_time->seconds << std::endl;
+        }
+    }
+}
+
+int main(int argc, char **argv){
+
+    std::string csv_file, json_file;
+    double min_time = 0.05;
+    std::vector<std::string> problems = benchmark::benchmark_problem::names();
+    std::vector<std::string> integrators = {"rk87", "bulirschstoer", "ABM", "yoshida6", "yoshida6_mixedvar"};
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if(arg == "--dynamics" && i + 1 < argc)
+            problems = split(argv[++i]);
+        else if(arg == "--integrators" && i + 1 < argc)
+        {
+            const std::string list = argv[++i];
+            integrators = (list == "all") ? benchmark::integrator_names() : split(list);
+        }
+        else if(arg == "--csv" && i + 1 < argc)
+            csv_file = argv[++i];
+        else if(arg == "--json" && i + 1 < argc)
+            json_file = argv[++i];
+        else if(arg == "--min-time" && i + 1 < argc)
+            min_time = std::atof(argv[++i]);
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--dynamics a,b,...] [--integrators a,b,...|all] [--csv file] [--json file] [--min-time seconds]" << std::endl;
+            return 1;
+        }
+    }
+
+    const double target = 1.0e-13;
+    const int max_nsteps = 1 << 17;
+    std::vector<precision_result> results;
+
+    for(unsigned int p = 0; p < problems.size(); p++)
+    {
+        benchmark::benchmark_problem problem(problems[p], 1);
+        const std::vector<long double> reference = reference_solution(problem);
+
+        for(unsigned int k = 0; k < integrators.size(); k++)
+        {
+            const std::string &name = integrators[k];
+            if(!benchmark::make_integrator(name, problem, 1.0e-6))
+                continue;
+
+            if(benchmark::get_kind(name) == benchmark::ADAPTIVE)
+            {
+                for(int e = 2; e <= 13; e++)
+                {
+                    results.push_back(run_point(name, problem, reference, 100, std::pow(10.0, -e), min_time));
+                    if(sweep_done(results, target))
+                        break;
+                }
+            }
+            else
+            {
+                for(int nsteps = 16; nsteps <= max_nsteps; nsteps *= 2)
+                {
+                    results.push_back(run_point(name, problem, reference, nsteps, 0.0, min_time));
+                    if(sweep_done(results, target))
+                        break;
+                }
+            }
+
+            if(!csv_file.empty() || !json_file.empty())
+                std::cerr << name << " on " << problems[p] << std::endl;
+        }
+    }
+
+    if(csv_file.empty())
+    {
+        write_csv(std::cout, results);
+        std::cout << std::endl;
+    }
+    else
+    {
+        std::ofstream os(csv_file.c_str());
+        write_csv(os, results);
+    }
+    write_summary(std::cout, problems, results);
+    if(!json_file.empty())
+    {
+        std::ofstream os(json_file.c_str());
+        write_json(os, results);
+    }
+
+    return 0;
+}
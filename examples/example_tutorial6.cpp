@@ -0,0 +1,40 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+------------Copyright (C) 2017 University of Strathclyde and Authors---------
+------------ e-mail: romain.serra@strath.ac.uk ------------------------------
+------------- Author: Romain Serra ------------------------------------------
+*/
+
+#include "../include/smartmath.h"
+
+using namespace std;
+
+int main(){
+
+cout << "This example shows how to integrate a stiff problem (Van der Pol oscillator with large parameter) with an implicit multistep method" << endl;
+
+/* Creating the dynamics */
+smartmath::dynamics::vanderpol<double> *dyn = new smartmath::dynamics::vanderpol<double>(1000.0);
+
+/* Creating integrator */
+double tolerance = 1.0e-6; // tolerance on the weighted local error
+smartmath::integrator::BDF<double> prop(dyn, 5, tolerance); // variable order BDF with maximum order 5
+prop.set_comments(false);
+
+/* Setting initial conditions */
+std::vector<double> x(2), xf;
+x[0] = 2.0;
+x[1] = 0.0;
+
+/* Integration */
+double t_f = 3000.0; // final time
+prop.integrate(0.0, t_f, 100, x, xf); // the number of steps is only used as an initial guess for the step-size
+
+cout << "State at final time: (" << xf[0] << ", " << xf[1] << ")" << endl;
+cout << "Cost of the linear algebra: " << prop.get_jacobian_evaluations() << " Jacobian evaluations and " << prop.get_LU_decompositions() << " LU factorisations" << endl;
+
+delete dyn;
+
+}
@@ -14,25 +14,60 @@
 
 #include <vector>
 #include <cmath>
+#include <limits>
+#include <type_traits>
+#include <exception>
 #include "../exception.h"
+#include "../Utils/state_traits.h"
 
+/* Eigen triggers -Wint-in-bool-context with recent GCC */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wint-in-bool-context"
+#endif
 #include "../LinearAlgebra/Eigen/Core"
+#include "../LinearAlgebra/Eigen/SparseCore"
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#include <algorithm>
 
 namespace smartmath
 {
     namespace dynamics {
 
+        /**
+         * @brief finite_difference_counter returns the counter of the calling thread to which the evaluations made by the finite differences of jacobian() and sparse_jacobian() are added
+         *
+         * It is NULL unless an integration is in progress on the thread, in which case it points to the number of evaluations of its statistics.
+         * @return reference to the pointer to the counter
+         */
+        inline unsigned long *&finite_difference_counter(){
+            static thread_local unsigned long *counter = NULL;
+            return counter;
+        }
+
         /**
          * @brief The %base_dynamics class is a template abstract class. Any dynamics added to the toolbox needs to inherit from it and implement the method evaluate()
          *
          * The %base_dynamics class is an abstract class. Any dynamical system added to the toolbox need to extend this class and implement the method evaluate.
+         * The type of state vector defaults to std::vector<T>. Systems of fixed dimension can use a fixed-size container such as std::array<T, N> (see state_traits) so that the integrators work on stack-allocated states with loop bounds known at compile time.
          */
-        template < class T >
+        template < class T, class State = std::vector<T> >
         class base_dynamics
         {
 
         public:
 
+            /**
+             * @brief value_type scalar type of the dynamics
+             */
+            typedef T value_type;
+            /**
+             * @brief state_type type of the state vector
+             */
+            typedef State state_type;
+
             /**
              * @brief base_dynamics constructor.
              *
@@ -41,7 +76,7 @@ namespace smartmath
              * The dynamics are implemented as template classes because they can operate in the space pf real number or in the algebra of polynomials in SMART-UQ.
              * @param name dynamical system name
              */
-            base_dynamics(const std::string &name): m_name(name){}
+            base_dynamics(const std::string &name): m_name(name), m_central(false), m_parallel(false){}
 
             virtual ~base_dynamics(){}
 
@@ -49,12 +84,77 @@ namespace smartmath
              * @brief evaluate evaluate the dynamics at a given instant of time and a given state.
              *
              * Function to evaluate the dinamics at a given instant of time and a given state. It is a virtual function so any class that inherites from base_dynamics need to implement it.
+             * The integrators pass a derivative dstate that already has the dimension of the state, so that implementations can write its components directly and do not need to allocate memory.
              * @param[in] t time
              * @param[in] state state values at time t
              * @param[out] dstate derivative of the states at time t
              * @return
              */
-            virtual int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const = 0;
+            virtual int evaluate(const double &t, const State &state, State &dstate) const = 0;
+
+            /**
+             * @brief check_input checks that the dynamics can be evaluated at a given instant of time and a given state, and throws otherwise.
+             *
+             * Implementations of evaluate() only repeat these checks when SMARTMATH_CHECK_LEVEL is SMARTMATH_CHECK_FULL. The integrators call check_input() once at the entry of integrate() unless SMARTMATH_CHECK_LEVEL is SMARTMATH_CHECK_NONE.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             */
+            virtual void check_input(const double &t, const State &state) const{}
+
+            /**
+             * @brief jacobian evaluates the Jacobian matrix of the dynamics at a given instant of time and a given state.
+             *
+             * Function to evaluate the partial derivatives of the dynamics w.r.t. the state. The default implementation uses finite differences (see set_finite_differences()) and is only available for floating point types.
+             * Dynamical systems with a cheap analytical Jacobian should override it.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J Jacobian matrix at time t (J(i,j) is the derivative of the i-th component of the dynamics w.r.t. the j-th state)
+             * @return exit flag (0=success)
+             */
+            virtual int jacobian(const double &t, const State &state, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &J) const{
+                return finite_differences(t, state, J, typename std::is_floating_point<T>::type());
+            }
+
+            /**
+             * @brief sparsity_pattern declares the structure of the Jacobian matrix
+             *
+             * Function to be overridden by dynamical systems with a sparse Jacobian. The default implementation declares no pattern i.e. a dense Jacobian.
+             * @param[in] n dimension of the state vector
+             * @param[out] pattern row indices of the structurally non-zero entries of each column (pattern[j] for the j-th column)
+             * @return true if a pattern is declared, false otherwise
+             */
+            virtual bool sparsity_pattern(const unsigned int &n, std::vector<std::vector<unsigned int> > &pattern) const{
+                return false;
+            }
+
+            /**
+             * @brief sparse_jacobian evaluates the Jacobian matrix of the dynamics in sparse format
+             *
+             * If a sparsity pattern is declared, the default implementation uses finite differences on groups of structurally orthogonal columns (Curtis-Powell-Reid colouring) so that the number of evaluations is the number of colours instead of the dimension.
+             * Otherwise the dense Jacobian from jacobian() is converted.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J compressed Jacobian matrix at time t, whose structure is the declared pattern
+             * @return exit flag (0=success)
+             */
+            virtual int sparse_jacobian(const double &t, const State &state, Eigen::SparseMatrix<T> &J) const{
+                return coloured_finite_differences(t, state, J, typename std::is_floating_point<T>::type());
+            }
+
+            /**
+             * @brief set_finite_differences sets the scheme used by the default implementation of jacobian()
+             *
+             * Forward differences cost one evaluation per state component, central differences two but with a truncation error of second order.
+             * These evaluations are counted in the statistics of the integration in progress on the calling thread, if any (see finite_difference_counter).
+             * On request, the columns are computed in parallel when OpenMP is enabled and the dimension is large enough, in which case evaluate() needs to be thread-safe.
+             * An exception thrown by evaluate() in a parallel computation is rethrown once all the columns are done.
+             * @param[in] central true for central differences, false for forward differences
+             * @param[in] parallel true to compute the columns in parallel (evaluate() being thread-safe), false by default
+             */
+            void set_finite_differences(const bool &central, const bool &parallel = false){
+                m_central = central;
+                m_parallel = parallel;
+            }
 
             /**
              * @brief get_name return dynamical system name
@@ -69,6 +169,261 @@ namespace smartmath
              * @brief m_name dynamical system name (used in error messages)
              */
             std::string m_name;
+            /**
+             * @brief m_central flag for central finite differences in the default Jacobian (forward otherwise)
+             */
+            bool m_central;
+            /**
+             * @brief m_parallel flag for the parallel computation of the finite differences (off by default since evaluate() needs to be thread-safe)
+             */
+            bool m_parallel;
+
+        private:
+            /**
+             * @brief finite_differences approximates the Jacobian with finite differences
+             *
+             * Each column is perturbed with a step scaled on the magnitude of the corresponding state component
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J approximated Jacobian matrix
+             * @return exit flag (0=success)
+             */
+            int finite_differences(const double &t, const State &state, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &J, std::true_type) const{
+
+                int n = state.size();
+                State f0(state);
+                double eps = std::numeric_limits<T>::epsilon();
+                double rel = m_central ? pow(eps, 1.0 / 3.0) : sqrt(eps);
+
+                J.resize(n, n);
+                if(!m_central)
+                    evaluate(t, state, f0);
+
+                /* an exception cannot leave a parallel region: the first one is kept and rethrown after it */
+                std::exception_ptr error;
+#ifdef _OPENMP
+                #pragma omp parallel if(m_parallel && (n >= 8))
+#endif
+                {
+                    State x(state), fp(f0), fm(f0);
+                    T delta;
+#ifdef _OPENMP
+                    #pragma omp for
+#endif
+                    for(int j = 0; j < n; j++)
+                    {
+                        try
+                        {
+                            /* making the step exactly representable */
+                            x[j] = state[j] + rel * std::max(T(1.0), T(fabs(state[j])));
+                            delta = x[j] - state[j];
+                            evaluate(t, x, fp);
+                            if(m_central)
+                            {
+                                x[j] = state[j] - delta;
+                                evaluate(t, x, fm);
+                                for(int i = 0; i < n; i++)
+                                    J(i, j) = (fp[i] - fm[i]) / (2.0 * delta);
+                            }
+                            else
+                            {
+                                for(int i = 0; i < n; i++)
+                                    J(i, j) = (fp[i] - f0[i]) / delta;
+                            }
+                        }
+                        catch(...)
+                        {
+                            keep_exception(error);
+                        }
+                        x[j] = state[j];
+                    }
+                }
+                if(error)
+                    std::rethrow_exception(error);
+                count_evaluations(m_central ? 2 * n : n + 1);
+
+                return 0;
+            }
+
+            /**
+             * @brief coloured_finite_differences approximates the sparse Jacobian with finite differences on groups of columns
+             *
+             * The columns are greedily coloured so that two columns of the same colour never share a non-zero row, then all the columns of a colour are perturbed at once
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J approximated Jacobian matrix
+             * @return exit flag (0=success)
+             */
+            int coloured_finite_differences(const double &t, const State &state, Eigen::SparseMatrix<T> &J, std::true_type) const{
+
+                int n = state.size();
+                std::vector<std::vector<unsigned int> > pattern;
+                if(!sparsity_pattern(n, pattern))
+                {
+                    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Jd;
+                    jacobian(t, state, Jd);
+                    J = Jd.sparseView();
+                    return 0;
+                }
+                if(int(pattern.size()) != n)
+                    smartmath_throw(m_name + ": the sparsity pattern needs one list of rows per column");
+
+                /* structure of the matrix */
+                std::vector<std::vector<unsigned int> > rows(n);
+                Eigen::VectorXi nnz(n);
+                for(int j = 0; j < n; j++)
+                {
+                    std::sort(pattern[j].begin(), pattern[j].end());
+                    pattern[j].erase(std::unique(pattern[j].begin(), pattern[j].end()), pattern[j].end());
+                    nnz(j) = pattern[j].size();
+                    for(unsigned int k = 0; k < pattern[j].size(); k++)
+                        rows[pattern[j][k]].push_back(j);
+                }
+                J.resize(n, n);
+                J.reserve(nnz);
+                for(int j = 0; j < n; j++)
+                {
+                    for(unsigned int k = 0; k < pattern[j].size(); k++)
+                        J.insert(pattern[j][k], j) = 0.0;
+                }
+                J.makeCompressed();
+
+                /* greedy colouring of the columns */
+                std::vector<int> colour(n, -1), forbidden(n, -1);
+                int colours = 0;
+                for(int j = 0; j < n; j++)
+                {
+                    for(unsigned int k = 0; k < pattern[j].size(); k++)
+                    {
+                        const std::vector<unsigned int> &neighbours = rows[pattern[j][k]];
+                        for(unsigned int l = 0; l < neighbours.size(); l++)
+                        {
+                            if(colour[neighbours[l]] >= 0)
+                                forbidden[colour[neighbours[l]]] = j;
+                        }
+                    }
+                    int c = 0;
+                    while(forbidden[c] == j)
+                        c++;
+                    colour[j] = c;
+                    colours = std::max(colours, c + 1);
+                }
+                std::vector<std::vector<unsigned int> > groups(colours);
+                for(int j = 0; j < n; j++)
+                    groups[colour[j]].push_back(j);
+
+                /* one (or two for central differences) evaluation per colour */
+                State f0(state);
+                double eps = std::numeric_limits<T>::epsilon();
+                double rel = m_central ? pow(eps, 1.0 / 3.0) : sqrt(eps);
+                if(!m_central)
+                    evaluate(t, state, f0);
+                T *values = J.valuePtr();
+                const int *outer = J.outerIndexPtr();
+
+                std::exception_ptr error;
+#ifdef _OPENMP
+                #pragma omp parallel if(m_parallel && (colours >= 8))
+#endif
+                {
+                    State x(state), fp(f0), fm(f0);
+                    std::vector<T> delta(n);
+#ifdef _OPENMP
+                    #pragma omp for
+#endif
+                    for(int c = 0; c < colours; c++)
+                    {
+                        const std::vector<unsigned int> &group = groups[c];
+                        try
+                        {
+                            for(unsigned int k = 0; k < group.size(); k++)
+                            {
+                                unsigned int j = group[k];
+                                x[j] = state[j] + rel * std::max(T(1.0), T(fabs(state[j])));
+                                delta[j] = x[j] - state[j];
+                            }
+                            evaluate(t, x, fp);
+                            if(m_central)
+                            {
+                                for(unsigned int k = 0; k < group.size(); k++)
+                                    x[group[k]] = state[group[k]] - delta[group[k]];
+                                evaluate(t, x, fm);
+                            }
+                            for(unsigned int k = 0; k < group.size(); k++)
+                            {
+                                unsigned int j = group[k];
+                                for(unsigned int r = 0; r < pattern[j].size(); r++)
+                                {
+                                    unsigned int i = pattern[j][r];
+                                    if(m_central)
+                                        values[outer[j] + r] = (fp[i] - fm[i]) / (2.0 * delta[j]);
+                                    else
+                                        values[outer[j] + r] = (fp[i] - f0[i]) / delta[j];
+                                }
+                            }
+                        }
+                        catch(...)
+                        {
+                            keep_exception(error);
+                        }
+                        for(unsigned int k = 0; k < group.size(); k++)
+                            x[group[k]] = state[group[k]];
+                    }
+                }
+                if(error)
+                    std::rethrow_exception(error);
+                count_evaluations(m_central ? 2 * colours : colours + 1);
+
+                return 0;
+            }
+
+            /**
+             * @brief count_evaluations adds the evaluations of a finite-difference Jacobian to the counter of the integration in progress on the thread, if any
+             * @param[in] evaluations number of evaluations
+             */
+            static void count_evaluations(const unsigned long &evaluations){
+                unsigned long *counter = finite_difference_counter();
+                if(counter != NULL)
+                    *counter += evaluations;
+            }
+
+            /**
+             * @brief keep_exception stores the exception being handled unless one has already been stored, from any thread of a parallel region
+             * @param[in,out] error first exception thrown
+             */
+            static void keep_exception(std::exception_ptr &error){
+#ifdef _OPENMP
+                #pragma omp critical(smartmath_finite_differences)
+#endif
+                {
+                    if(!error)
+                        error = std::current_exception();
+                }
+            }
+
+            /**
+             * @brief coloured_finite_differences fallback for non floating point types (e.g. polynomials in SMART-UQ)
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J Jacobian matrix
+             * @return exit flag (0=success)
+             */
+            int coloured_finite_differences(const double &t, const State &state, Eigen::SparseMatrix<T> &J, std::false_type) const{
+                smartmath_throw(m_name + ": finite differences Jacobian is only available for floating point types, sparse_jacobian() needs to be implemented");
+                return 1;
+            }
+
+            /**
+             * @brief finite_differences fallback for non floating point types (e.g. polynomials in SMART-UQ)
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J Jacobian matrix
+             * @return exit flag (0=success)
+             */
+            int finite_differences(const double &t, const State &state, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &J, std::false_type) const{
+                smartmath_throw(m_name + ": finite differences Jacobian is only available for floating point types, jacobian() needs to be implemented");
+                return 1;
+            }
 
         };
 
@@ -12,6 +12,7 @@
 
 #include "base_dynamics.h"
 #include "../exception.h"
+#include "../Utils/state_view.h"
 
 namespace smartmath
 {
@@ -21,14 +22,14 @@ namespace smartmath
          * @brief The %base_hamiltonian class is a template abstract class. Any Hamiltonian system added to the toolbox needs to inherit from it
          *
          * The %base_hamiltonian class is a template abstract class. Any Hamiltonian system added to the toolbox needs to inherit from it
-         * The canonical variables are called q and p. 
+         * The canonical variables are called q and p. The partial derivatives of the Hamiltonian are computed on views (see state_view) so that evaluate() passes the halves of the state and writes directly into the halves of its derivative, without copies nor allocations. The output views have the correct size on input.
          */
-        template < class T >
-        class base_hamiltonian: public base_dynamics<T>
+        template < class T, class State = std::vector<T> >
+        class base_hamiltonian: public base_dynamics<T, State>
         {
 
         protected:
-            using base_dynamics<T>::m_name;
+            using base_dynamics<T, State>::m_name;
             /**
              * @brief m_dim half-dimension of Hamiltonian system
              */             
@@ -47,7 +48,7 @@ namespace smartmath
              * @param dim half-order of the Hamiltonian system
              * @param separable boolean precising whether the system is separable or not
              */
-            base_hamiltonian(const std::string &name, const unsigned int &dim, const bool &separable = false): base_dynamics<T>(name), m_dim(dim), m_separable(separable){}
+            base_hamiltonian(const std::string &name, const unsigned int &dim, const bool &separable = false): base_dynamics<T, State>(name), m_dim(dim), m_separable(separable){}
 
             /**
              * @brief ~base_hamiltonian deconstructor
@@ -74,6 +75,16 @@ namespace smartmath
             	return m_separable;
             }            
 
+            /**
+             * @brief check_input checks the dimension of the state of the Hamiltonian system
+             * @param[in] t time in scaled units
+             * @param[in] state vector in scaled units
+             */
+            void check_input(const double &t, const State &state) const{
+                if(state.size() != 2 * m_dim)
+                    smartmath_throw("EVALUATE: the Hamiltonian state must have a consistent dimension");
+            }
+
             /**
              * @brief evaluate differential equations of the implemented Hamiltonian system
              * @param[in] t time in scaled units
@@ -81,31 +92,22 @@ namespace smartmath
              * @param[out] dstate derivative in scaled units
              * @return exit flag (0=success)
              */
-            int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const{
+            int evaluate(const double &t, const State &state, State &dstate) const{
 
             	/* sanity checks */
-				if(state.size() != 2 * m_dim)
-					smartmath_throw("EVALUATE: the Hamiltonian state must have a consistent dimension");
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+				base_hamiltonian::check_input(t, state);
+#endif
 
-				dstate.clear();
-				/* reconstituting the canonical variables q and p from the state vector */
-				std::vector<T> q, p;
-				for(unsigned int k = 0; k < m_dim; k++)
-				{
-					q.push_back(state[k]);
-					p.push_back(state[k + m_dim]);
-				}
-                
-				/* computing the partial derivatives of the Hamiltonian w.r.t. q and p */ 
-                std::vector<T> dHp = p, dHq = q;
-				DHq(t, q, p, dHq);       
-				DHp(t, q, p, dHp);
-
-				/* reconstituting the state derivative */
-				for(unsigned int k = 0; k < m_dim; k++)
-					dstate.push_back(dHp[k]);
+				state_traits<State>::resize(dstate, 2 * m_dim);
+
+				/* the canonical variables q and p are the two halves of the state vector and the derivatives are written in the halves of dstate */
+				const_state_view<T> q(&state[0], m_dim), p(&state[m_dim], m_dim);
+				state_view<T> dq(&dstate[0], m_dim), dp(&dstate[m_dim], m_dim);
+				DHp(t, q, p, dq);
+				DHq(t, q, p, dp);
 				for(unsigned int k = 0; k < m_dim; k++)
-					dstate.push_back(-dHq[k]);
+					dp[k] = -dp[k];
 
             	return 0;
             }
@@ -120,7 +122,7 @@ namespace smartmath
              * @param[out] dH vector of partial derivatives of H w.r.t. the vector q
              * @return exit flag (0=success)
              */
-			virtual int DHq(const double &t, const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &dH) const = 0;
+			virtual int DHq(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const = 0;
 
             /**
              * @brief DHq computes the partial derivative of the Hamiltonian with respect to p
@@ -132,7 +134,7 @@ namespace smartmath
              * @param[out] dH vector of partial derivatives of H w.r.t. the vector p
              * @return exit flag (0=success)
              */
-			virtual int DHp(const double &t, const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &dH) const = 0;
+			virtual int DHp(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const = 0;
 
         };
 
@@ -0,0 +1,208 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_CACHED_DYNAMICS_H
+#define SMARTMATH_CACHED_DYNAMICS_H
+
+#include "base_dynamics.h"
+#include "../exception.h"
+
+namespace smartmath
+{
+    namespace dynamics {
+
+        /**
+         * @brief The %cached_dynamics class memorises the last evaluations of a dynamical system
+         *
+         * The class decorates any dynamics with a ring of the most recent evaluations (t, x) -> f. An evaluation at a time and a state exactly equal to a stored one copies the stored derivative instead of calling the wrapped dynamics.
+         * This avoids evaluating costly force models twice at the same point, e.g. the first stage of a step retried after a rejection or the initialisation of a multistep scheme followed by its first step.
+         * The cache is modified by evaluate() even though the method is const: one instance must not be shared between threads.
+         */
+        template < class T, class State = std::vector<T> >
+        class cached_dynamics: public base_dynamics<T, State>
+        {
+
+        private:
+            using base_dynamics<T, State>::m_name;
+
+        public:
+            /**
+             * @brief cached_dynamics constructor
+             * @param dyn dynamical system to be decorated, which needs to outlive the decorator
+             * @param size number of evaluations kept in memory
+             */
+            cached_dynamics(const base_dynamics<T, State> *dyn, const unsigned int &size = 16):
+                base_dynamics<T, State>(dyn->get_name()), m_dyn(dyn), m_times(size), m_states(size), m_derivatives(size), m_count(0), m_next(0), m_hits(0), m_misses(0){
+                if(size == 0)
+                    smartmath_throw(m_name + ": the size of the cache needs to be positive");
+            }
+
+            /**
+              * @brief ~cached_dynamics
+              */
+            ~cached_dynamics(){}
+
+            /**
+             * @brief evaluate returns the stored derivative if the dynamics has already been evaluated at the same time and state, and evaluates the wrapped dynamics otherwise.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] dstate derivative of the states at time t
+             * @return exit flag (0=success)
+             */
+            int evaluate(const double &t, const State &state, State &dstate) const{
+
+                /* look-up from the most recent evaluation backwards */
+                const unsigned int size = m_times.size();
+                for(unsigned int k = 1; k <= m_count; k++)
+                {
+                    const unsigned int i = (m_next + size - k) % size;
+                    if(m_times[i] == t && equal(m_states[i], state))
+                    {
+                        m_hits++;
+                        dstate = m_derivatives[i];
+                        return 0;
+                    }
+                }
+
+                m_misses++;
+                int flag = m_dyn->evaluate(t, state, dstate);
+                if(flag == 0)
+                {
+                    m_times[m_next] = t;
+                    m_states[m_next] = state;
+                    m_derivatives[m_next] = dstate;
+                    m_next = (m_next + 1) % size;
+                    if(m_count < size)
+                        m_count++;
+                }
+
+                return flag;
+            }
+
+            /**
+             * @brief check_input forwards the checks of the wrapped dynamics
+             * @param[in] t time
+             * @param[in] state state values at time t
+             */
+            void check_input(const double &t, const State &state) const{
+                m_dyn->check_input(t, state);
+            }
+
+            /**
+             * @brief jacobian evaluates the Jacobian matrix of the wrapped dynamics (not cached)
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J Jacobian matrix at time t
+             * @return exit flag (0=success)
+             */
+            int jacobian(const double &t, const State &state, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &J) const{
+                return m_dyn->jacobian(t, state, J);
+            }
+
+            /**
+             * @brief sparsity_pattern returns the sparsity pattern of the wrapped dynamics
+             * @param[in] n dimension of the state
+             * @param[out] pattern for each column, the rows of the non-zero entries
+             * @return true if the wrapped dynamics provides a pattern
+             */
+            bool sparsity_pattern(const unsigned int &n, std::vector<std::vector<unsigned int> > &pattern) const{
+                return m_dyn->sparsity_pattern(n, pattern);
+            }
+
+            /**
+             * @brief sparse_jacobian evaluates the sparse Jacobian matrix of the wrapped dynamics (not cached)
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J sparse Jacobian matrix at time t
+             * @return exit flag (0=success)
+             */
+            int sparse_jacobian(const double &t, const State &state, Eigen::SparseMatrix<T> &J) const{
+                return m_dyn->sparse_jacobian(t, state, J);
+            }
+
+            /**
+             * @brief get_hits returns the number of evaluations answered by the cache
+             * @return number of hits
+             */
+            unsigned long get_hits() const{
+                return m_hits;
+            }
+
+            /**
+             * @brief get_misses returns the number of evaluations of the wrapped dynamics
+             * @return number of misses
+             */
+            unsigned long get_misses() const{
+                return m_misses;
+            }
+
+            /**
+             * @brief clear empties the cache and resets the counters
+             */
+            void clear(){
+                m_count = 0;
+                m_next = 0;
+                m_hits = 0;
+                m_misses = 0;
+            }
+
+        private:
+            /**
+             * @brief equal compares two states component by component
+             */
+            static bool equal(const State &x, const State &y){
+                if(x.size() != y.size())
+                    return false;
+                for(unsigned int j = 0; j < x.size(); j++)
+                {
+                    if(!(x[j] == y[j]))
+                        return false;
+                }
+                return true;
+            }
+
+            /**
+             * @brief m_dyn decorated dynamical system
+             */
+            const base_dynamics<T, State> *m_dyn;
+            /**
+             * @brief m_times times of the stored evaluations
+             */
+            mutable std::vector<double> m_times;
+            /**
+             * @brief m_states states of the stored evaluations
+             */
+            mutable state_history<State> m_states;
+            /**
+             * @brief m_derivatives derivatives of the stored evaluations
+             */
+            mutable state_history<State> m_derivatives;
+            /**
+             * @brief m_count number of stored evaluations
+             */
+            mutable unsigned int m_count;
+            /**
+             * @brief m_next slot of the ring for the next evaluation
+             */
+            mutable unsigned int m_next;
+            /**
+             * @brief m_hits number of evaluations answered by the cache
+             */
+            mutable unsigned long m_hits;
+            /**
+             * @brief m_misses number of evaluations of the decorated dynamics
+             */
+            mutable unsigned long m_misses;
+        };
+
+    }
+}
+
+#endif // SMARTMATH_CACHED_DYNAMICS_H
@@ -0,0 +1,97 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_CALLABLE_DYNAMICS_H
+#define SMARTMATH_CALLABLE_DYNAMICS_H
+
+#include "base_dynamics.h"
+#include "../exception.h"
+#include <string>
+#include <type_traits>
+
+namespace smartmath
+{
+    namespace dynamics {
+
+        /**
+         * @brief The %callable_dynamics class turns any callable object into a dynamical system
+         *
+         * The callable (function pointer, lambda or functor) is held by value and invoked directly as f(t, state, dstate). It can return void or an int exit flag.
+         * The class can be used by all integrators through the base_dynamics interface, or without any virtual call through static_integrator (see make_dynamics).
+         */
+        template < class T, class State, class F >
+        class callable_dynamics final: public base_dynamics<T, State>
+        {
+
+        public:
+            /**
+             * @brief callable_dynamics constructor
+             * @param f callable with signature (const double &t, const State &state, State &dstate)
+             * @param name dynamical system name
+             */
+            callable_dynamics(const F &f, const std::string &name = "User-defined dynamical system"): base_dynamics<T, State>(name), m_f(f){}
+
+            /**
+              * @brief ~callable_dynamics
+              */
+            ~callable_dynamics(){}
+
+            /**
+             * @brief evaluate evaluates the callable at a given instant of time and a given state.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] dstate derivative of the states at time t
+             * @return exit flag (0=success)
+             */
+            int evaluate(const double &t, const State &state, State &dstate) const final{
+                return call(t, state, dstate, typename std::is_void<decltype(std::declval<const F &>()(t, state, dstate))>::type());
+            }
+
+        private:
+            /**
+             * @brief call invokes a callable returning void
+             */
+            int call(const double &t, const State &state, State &dstate, std::true_type) const{
+                m_f(t, state, dstate);
+                return 0;
+            }
+
+            /**
+             * @brief call invokes a callable returning an exit flag
+             */
+            int call(const double &t, const State &state, State &dstate, std::false_type) const{
+                return m_f(t, state, dstate);
+            }
+
+            /**
+             * @brief m_f callable defining the dynamics
+             */
+            F m_f;
+        };
+
+        /**
+         * @brief make_dynamics wraps a callable into a dynamical system
+         *
+         * The scalar and state types need to be given explicitly, e.g.
+         * auto dyn = make_dynamics<double, std::array<double, 2> >([](const double &t, const std::array<double, 2> &x, std::array<double, 2> &dx){ dx[0] = x[1]; dx[1] = -x[0]; });
+         * static_integrator<rk4, decltype(dyn)> prop(&dyn);
+         * @param f callable with signature (const double &t, const State &state, State &dstate)
+         * @param name dynamical system name
+         * @return dynamical system holding a copy of the callable
+         */
+        template < class T, class State = std::vector<T>, class F >
+        callable_dynamics<T, State, F> make_dynamics(const F &f, const std::string &name = "User-defined dynamical system"){
+            return callable_dynamics<T, State, F>(f, name);
+        }
+
+    }
+}
+
+#endif // SMARTMATH_CALLABLE_DYNAMICS_H
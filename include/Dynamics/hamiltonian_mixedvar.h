@@ -73,7 +73,7 @@ namespace smartmath
              * @param[out] dH2 vector of partial derivatives of H w.r.t. the vector q2
              * @return exit flag (0=success)
              */
-            virtual int DHq2(const double &t, const std::vector<T> &q2, const std::vector<T> &p2, std::vector<T> &dH2) const = 0;
+            virtual int DHq2(const double &t, const_state_view<T> q2, const_state_view<T> p2, state_view<T> dH2) const = 0;
 
             /**
              * @brief DHp2 computes the partial derivative of the Hamiltonian with respect to the second 'momentum' p2
@@ -85,7 +85,7 @@ namespace smartmath
              * @param[out] dH2 vector of partial derivatives of H w.r.t. the vector p2
              * @return exit flag (0=success)
              */
-            virtual int DHp2(const double &t, const std::vector<T> &q2, const std::vector<T> &p2, std::vector<T> &dH2) const = 0;            
+            virtual int DHp2(const double &t, const_state_view<T> q2, const_state_view<T> p2, state_view<T> dH2) const = 0;            
 
             /**
              * @brief conversion performs the conversion from the first set of canonical variables to the second one
@@ -97,7 +97,7 @@ namespace smartmath
              * @param[out] p2 vector in scaled units
              * @return exit flag (0=success)
              */
-            virtual int conversion(const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &q2, std::vector<T> &p2) const = 0; 
+            virtual int conversion(const_state_view<T> q, const_state_view<T> p, state_view<T> q2, state_view<T> p2) const = 0; 
 
             /**
              * @brief conversion performs the conversion from the second set of canonical variables to the first one
@@ -109,7 +109,7 @@ namespace smartmath
              * @param[out] p vector in scaled units
              * @return exit flag (0=success)
              */
-            virtual int conversion2(const std::vector<T> &q2, const std::vector<T> &p2, std::vector<T> &q, std::vector<T> &p) const = 0; 
+            virtual int conversion2(const_state_view<T> q2, const_state_view<T> p2, state_view<T> q, state_view<T> p) const = 0; 
 
         };
 
@@ -21,12 +21,12 @@ namespace smartmath
          *
          * The %hamiltonian_momentum class is a template abstract class. Any Hamiltonian system using position and momenta as canonical variables needs to inherit from it
          */
-        template < class T >
-        class hamiltonian_momentum: public base_hamiltonian<T>
+        template < class T, class State = std::vector<T> >
+        class hamiltonian_momentum: public base_hamiltonian<T, State>
         {
 
         protected:
-        	using smartmath::dynamics::base_hamiltonian<T>::m_dim;
+        	using smartmath::dynamics::base_hamiltonian<T, State>::m_dim;
 
         public:
              /**
@@ -37,7 +37,7 @@ namespace smartmath
              * @param dim half-order of the Hamiltonian system
              * @param separable boolean precising whether the system is separable or not
              */
-            hamiltonian_momentum(const std::string &name, const unsigned int &dim, const bool &separable = false): base_hamiltonian<T>(name, dim, separable){}
+            hamiltonian_momentum(const std::string &name, const unsigned int &dim, const bool &separable = false): base_hamiltonian<T, State>(name, dim, separable){}
 
             /**
              * @brief ~hamiltonian_momentum deconstructor
@@ -54,12 +54,13 @@ namespace smartmath
              * @param[out] dH vector of partial derivatives of H w.r.t. the vector p
              * @return exit flag (0=success)
              */
-			int DHp(const double &t, const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &dH) const{
+			int DHp(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
 
 			    if(p.size() != m_dim)
 			        smartmath_exception("DHP: the momentum must have the correct dimension");
 
-			    dH = p;
+			    for(unsigned int k = 0; k < m_dim; k++)
+			        dH[k] = p[k];
 
 			    return 0;
 			};
@@ -30,12 +30,12 @@ namespace smartmath
           \f}
          * parameters can be set in the constructors.
          */
-        template < class T >
-        class lotkavolterra: public base_dynamics<T>
+        template < class T, class State = std::vector<T> >
+        class lotkavolterra: public base_dynamics<T, State>
         {
 
         private:
-            using base_dynamics<T>::m_name;
+            using base_dynamics<T, State>::m_name;
 
         public:
             /**
@@ -44,7 +44,7 @@ namespace smartmath
              * The constructor initializes the parameters of the Lotka-Volterra problem
              * @param[in] param 4 dimensional vector containing the parameters of the problem.
              */
-            lotkavolterra(const std::vector<T> &param): base_dynamics<T>("Lotka-Volterra dynamical system"), m_param(param)
+            lotkavolterra(const std::vector<T> &param): base_dynamics<T, State>("Lotka-Volterra dynamical system"), m_param(param)
 			{
 				//sanity checks
 				if(m_param.size()!=4)
@@ -57,6 +57,18 @@ namespace smartmath
               */
             ~lotkavolterra(){}
 
+            /**
+             * @brief check_input checks the time and the dimension of the state given to the dynamics of the Lotka Volterra problem.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             */
+            void check_input(const double &t, const State &state) const{
+                if(t < 0)
+                    smartmath_throw(m_name + ": negative time supplied in evaluation of the dynamical system");
+                if(state.size() != 2)
+                    smartmath_throw(m_name + ": the state dimension needs to be 2");
+            }
+
             /**
              * @brief evaluate evaluates the dynamics of the Lotka Volterra problem at a given instant of time and a given state.
              *
@@ -66,18 +78,41 @@ namespace smartmath
              * @param[out] dstate derivative of the states at time t
              * @return
              */
-            int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const{
+            int evaluate(const double &t, const State &state, State &dstate) const{
 				//sanity checks
-				if(t<0)
-					smartmath_throw(m_name+": negative time supplied in evaluation of the dynamical system");
-				if(state.size()!=2)
-					smartmath_throw(m_name+": the state dimension needs to be 2");
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+				lotkavolterra::check_input(t, state);
+#endif
 
-				dstate.clear();
+				state_traits<State>::resize(dstate, 2);
 
 				T xy = state[0]*state[1];
-				dstate.push_back(m_param[0]*state[0]-m_param[1]*xy);
-				dstate.push_back(-m_param[2]*state[1]+m_param[3]*xy);
+				dstate[0] = m_param[0]*state[0]-m_param[1]*xy;
+				dstate[1] = -m_param[2]*state[1]+m_param[3]*xy;
+
+				return 0;
+			}
+
+            /**
+             * @brief jacobian evaluates the Jacobian of the Lotka Volterra problem at a given instant of time and a given state.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J Jacobian matrix at time t
+             * @return
+             */
+            int jacobian(const double &t, const State &state, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &J) const{
+
+				//sanity checks
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+				if(state.size()!=2)
+					smartmath_throw(m_name+": the state dimension needs to be 2");
+#endif
+
+				J.resize(2, 2);
+				J(0, 0) = m_param[0]-m_param[1]*state[1];
+				J(0, 1) = -m_param[1]*state[0];
+				J(1, 0) = m_param[3]*state[1];
+				J(1, 1) = -m_param[2]+m_param[3]*state[0];
 
 				return 0;
 			}
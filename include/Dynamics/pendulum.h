@@ -28,12 +28,12 @@ namespace smartmath
           \f}
          *
          */
-        template < class T >
-        class pendulum: public hamiltonian_momentum<T>
+        template < class T, class State = std::vector<T> >
+        class pendulum: public hamiltonian_momentum<T, State>
         {
 
         private:
-            using hamiltonian_momentum<T>::m_dim;
+            using hamiltonian_momentum<T, State>::m_dim;
 
         public:
 
@@ -42,7 +42,7 @@ namespace smartmath
              *
              * The constructor initializes the problem
              */
-            pendulum() : hamiltonian_momentum<double>("Mathematical pendulum problem", 1, true)
+            pendulum() : hamiltonian_momentum<T, State>("Mathematical pendulum problem", 1, true)
             {
 
             }
@@ -62,7 +62,7 @@ namespace smartmath
              * @param[out] dH vector of partial derivatives of H w.r.t. the vector q
              * @return exit flag (0=success)
              */
-            int DHq(const double &t, const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &dH) const{
+            int DHq(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
 
                 if(q.size() != m_dim)
                     smartmath_exception("DHQ: the position must have the correct dimension");
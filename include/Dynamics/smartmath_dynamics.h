@@ -19,6 +19,9 @@
 #include "lotkavolterra.h"
 #include "vanderpol.h"
 #include "spaceflight.h"
+#include "variational_equations.h"
+#include "callable_dynamics.h"
+#include "cached_dynamics.h"
 #include "spring.h"
 #include "pendulum.h"
 
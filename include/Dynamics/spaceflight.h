@@ -29,12 +29,12 @@ namespace smartmath
          * where \f$r\f$ is the distance from the Earth,  \f$\mathbf{v}_{rel}\f$ is the Earth relative velocity and the mass of the spacecraft varies as
             \f{eqnarray*}{\dot{m} = - \alpha \|\mathbf{T}\|\f}
          */
-        template < class T >
-        class spaceflight: public base_dynamics<T>
+        template < class T, class State = std::vector<T> >
+        class spaceflight: public base_dynamics<T, State>
         {
 
         private:
-            using base_dynamics<T>::m_name;
+            using base_dynamics<T, State>::m_name;
 
         public:
 
@@ -53,7 +53,7 @@ namespace smartmath
              * @param t_scale time scaling factor
              * @param r_scale position scaling factor
              */
-            spaceflight(const std::vector<T> &param = std::vector<T>(10), const double &t_scale=1, const double &r_scale=1) : base_dynamics<T>("Spaceflight mechanics"),
+            spaceflight(const std::vector<T> &param = std::vector<T>(10), const double &t_scale=1, const double &r_scale=1) : base_dynamics<T, State>("Spaceflight mechanics"),
 				m_param(param), m_t_scale(t_scale), m_r_scale(r_scale)
 			{
 				if(m_param.size()!=10)
@@ -67,6 +67,18 @@ namespace smartmath
               */
             ~spaceflight(){}
 
+            /**
+             * @brief check_input checks the time and the dimension of the state given to the dynamics of the Two-body problem.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             */
+            void check_input(const double &t, const State &state) const{
+                if(t < 0)
+                    smartmath_throw(m_name + ": negative time supplied in evaluation of the dynamical system");
+                if(state.size() != 7)
+                    smartmath_throw(m_name + ": the state dimension needs to be 7");
+            }
+
             /**
              * @brief evaluate evaluates the dynamics of the Two-body problem at a given instant of time and a given state.
              *
@@ -76,15 +88,14 @@ namespace smartmath
              * @param[out] dstate derivative of the states at time t
              * @return
              */
-            int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const
+            int evaluate(const double &t, const State &state, State &dstate) const
 			{
 				//sanity checks
-				if(t<0)
-					smartmath_throw(m_name+": negative time supplied in evaluation of the dynamical system");
-				if(state.size()!=7)
-					smartmath_throw(m_name+": the state dimension needs to be 7");
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+				spaceflight::check_input(t, state);
+#endif
 
-				dstate.clear();
+				state_traits<State>::resize(dstate, 7);
 
 				//constant parameters
 				double radius_earth = 6378.0*pow(10,3) / m_r_scale;
@@ -107,18 +118,103 @@ namespace smartmath
 				//drag computation
 				T tmp_drag = 0.5*rho*m_param[6]*mod_rel_v/state[6];
 
-				dstate.push_back(state[3]); //dx/dt
-				dstate.push_back(state[4]); //dy/dt
-				dstate.push_back(state[5]); //dz/dt
-				dstate.push_back(-tmp_3D*state[0]+m_param[0]/state[6]+m_param[7]-tmp_drag*rel_v_x); //dv_x/dt
-				dstate.push_back(-tmp_3D*state[1]+m_param[1]/state[6]+m_param[8]-tmp_drag*rel_v_y); //dv_y/dt
-				dstate.push_back(-tmp_3D*state[2]+m_param[2]/state[6]+m_param[9]-tmp_drag*state[5]); //dv_z/dt
-				dstate.push_back(-m_param[3]*sqrt(m_param[0]*m_param[0]+m_param[1]*m_param[1]+m_param[2]*m_param[2])); //dm/dt
+				dstate[0] = state[3]; //dx/dt
+				dstate[1] = state[4]; //dy/dt
+				dstate[2] = state[5]; //dz/dt
+				dstate[3] = -tmp_3D*state[0]+m_param[0]/state[6]+m_param[7]-tmp_drag*rel_v_x; //dv_x/dt
+				dstate[4] = -tmp_3D*state[1]+m_param[1]/state[6]+m_param[8]-tmp_drag*rel_v_y; //dv_y/dt
+				dstate[5] = -tmp_3D*state[2]+m_param[2]/state[6]+m_param[9]-tmp_drag*state[5]; //dv_z/dt
+				dstate[6] = -m_param[3]*sqrt(m_param[0]*m_param[0]+m_param[1]*m_param[1]+m_param[2]*m_param[2]); //dm/dt
 
 				return 0;
 
 			}            
 
+            /**
+             * @brief jacobian evaluates the Jacobian of the dynamics at a given instant of time and a given state.
+             *
+             * Function to evaluate analytically the partial derivatives of the dynamics w.r.t. position, velocity and mass.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J Jacobian matrix at time t
+             * @return
+             */
+            int jacobian(const double &t, const State &state, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &J) const
+			{
+				//sanity checks
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+				if(state.size()!=7)
+					smartmath_throw(m_name+": the state dimension needs to be 7");
+#endif
+
+				J.resize(7, 7);
+				for(unsigned int i = 0; i < 7; i++)
+				{
+					for(unsigned int j = 0; j < 7; j++)
+						J(i, j) = 0.0;
+				}
+
+				//constant parameters
+				double radius_earth = 6378.0*pow(10,3) / m_r_scale;
+				double mu_earth = 398600.4415*pow(10,9) / (pow(m_r_scale,3)/pow(m_t_scale,2));
+				double omega_earth = 7.2921150*pow(10,-5) * m_t_scale;
+				double H0_atmosphere = 900000.0 / m_r_scale;
+
+				//precomputations
+				T r = sqrt(state[0]*state[0]+state[1]*state[1]+state[2]*state[2]);
+				T tmp_3D =  mu_earth/pow(r,3);
+				T tmp_5D = 3.0*tmp_3D/(r*r);
+
+				//atmospheric model and its gradient w.r.t. position
+				T rho = m_param[4]*exp(-(r-radius_earth-H0_atmosphere)/m_param[5]);
+				T drho[3];
+				for(unsigned int j = 0; j < 3; j++)
+					drho[j] = -rho*state[j]/(m_param[5]*r);
+
+				//relative velocity and its derivatives w.r.t. the state (only non-zero terms are listed)
+				T rel_v[3];
+				rel_v[0] = state[3]-omega_earth*state[1];
+				rel_v[1] = state[4]+omega_earth*state[0];
+				rel_v[2] = state[5];
+				T mod_rel_v = sqrt(rel_v[0]*rel_v[0]+rel_v[1]*rel_v[1]+rel_v[2]*rel_v[2]);
+				Eigen::Matrix<T, 3, 7> drel_v;
+				for(unsigned int i = 0; i < 3; i++)
+				{
+					for(unsigned int j = 0; j < 7; j++)
+						drel_v(i, j) = 0.0;
+					drel_v(i, 3 + i) = 1.0;
+				}
+				drel_v(0, 1) = -omega_earth;
+				drel_v(1, 0) = omega_earth;
+
+				//drag and its derivatives
+				T tmp_drag = 0.5*rho*m_param[6]*mod_rel_v/state[6];
+				T dtmp_drag[7];
+				for(unsigned int j = 0; j < 7; j++)
+				{
+					T dmod_rel_v = 0.0;
+					if(mod_rel_v != 0.0)
+						dmod_rel_v = (rel_v[0]*drel_v(0, j)+rel_v[1]*drel_v(1, j)+rel_v[2]*drel_v(2, j))/mod_rel_v;
+					dtmp_drag[j] = 0.5*rho*m_param[6]*dmod_rel_v/state[6];
+					if(j < 3)
+						dtmp_drag[j] += 0.5*drho[j]*m_param[6]*mod_rel_v/state[6];
+				}
+				dtmp_drag[6] -= tmp_drag/state[6];
+
+				for(unsigned int i = 0; i < 3; i++)
+				{
+					J(i, 3 + i) = 1.0; //dx/dt
+					for(unsigned int j = 0; j < 3; j++)
+						J(3 + i, j) = tmp_5D*state[i]*state[j];
+					J(3 + i, i) -= tmp_3D;
+					for(unsigned int j = 0; j < 7; j++)
+						J(3 + i, j) -= dtmp_drag[j]*rel_v[i]+tmp_drag*drel_v(i, j);
+					J(3 + i, 6) -= m_param[i]/(state[6]*state[6]);
+				}
+
+				return 0;
+			}
+
         private:
             mutable std::vector<T> m_param;
             double m_t_scale;
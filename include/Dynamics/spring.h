@@ -68,8 +68,9 @@ namespace smartmath
             int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const{
 
                 /* sanity checks */
-                if(state.size() != 2 * m_dim)
-                    smartmath_throw("EVALUATE: the Hamiltonian state must have a consistent dimension");
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+                spring::check_input(t, state);
+#endif
 
                 dstate[0] = state[1];
                 dstate[1] = -state[0];
@@ -85,7 +86,7 @@ namespace smartmath
              * @param[out] dH partial derivative of H with respect to q in scaled units 
              * @return exit flag (0=success)
              */
-            int DHq(const double &t, const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &dH) const{
+            int DHq(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
 
                 dH[0] = 0.0;
 
@@ -100,7 +101,7 @@ namespace smartmath
              * @param[out] dH partial derivative of H with respect to p in scaled units 
              * @return exit flag (0=success)
              */
-            int DHp(const double &t, const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &dH) const{
+            int DHp(const double &t, const_state_view<T> q, const_state_view<T> p, state_view<T> dH) const{
 
                 dH[0] = p[0];
 
@@ -117,7 +118,7 @@ namespace smartmath
              * @param[out] dH2 vector of partial derivatives of H w.r.t. the vector q2
              * @return exit flag (0=success)
              */
-            int DHq2(const double &t, const std::vector<T> &q2, const std::vector<T> &p2, std::vector<T> &dH2) const{
+            int DHq2(const double &t, const_state_view<T> q2, const_state_view<T> p2, state_view<T> dH2) const{
 
                 dH2[0] = 0.0;
 
@@ -134,7 +135,7 @@ namespace smartmath
              * @param[out] dH2 vector of partial derivatives of H w.r.t. the vector p2
              * @return exit flag (0=success)
              */
-            int DHp2(const double &t, const std::vector<T> &q2, const std::vector<T> &p2, std::vector<T> &dH2) const{
+            int DHp2(const double &t, const_state_view<T> q2, const_state_view<T> p2, state_view<T> dH2) const{
 
                 dH2[0] = 1.0;
 
@@ -151,7 +152,7 @@ namespace smartmath
              * @param[out] p2 vector in scaled units
              * @return exit flag (0=success)
              */
-            int conversion(const std::vector<T> &q, const std::vector<T> &p, std::vector<T> &q2, std::vector<T> &p2) const{
+            int conversion(const_state_view<T> q, const_state_view<T> p, state_view<T> q2, state_view<T> p2) const{
 
                 p2[0] = (q[0] * q[0] + p[0] * p[0]) / 2.0;
                 q2[0] = atan2(q[0], p[0]);
@@ -169,7 +170,7 @@ namespace smartmath
              * @param[out] p vector in scaled units
              * @return exit flag (0=success)
              */
-            int conversion2(const std::vector<T> &q2, const std::vector<T> &p2, std::vector<T> &q, std::vector<T> &p) const{
+            int conversion2(const_state_view<T> q2, const_state_view<T> p2, state_view<T> q, state_view<T> p) const{
 
                 T inter = sqrt(2.0 * p2[0]);
                 p[0] = inter * cos(q2[0]);
@@ -27,25 +27,37 @@ namespace smartmath
          * \f}
          * where \f$\mu\f$ is user supplied parameter that can be either  aconstant or a polynomial value
          */
-        template < class T >
-        class vanderpol: public base_dynamics<T>
+        template < class T, class State = std::vector<T> >
+        class vanderpol: public base_dynamics<T, State>
         {
 
         private:
-            using base_dynamics<T>::m_name;
+            using base_dynamics<T, State>::m_name;
 
         public:
             /**
              * @brief vanderpol constructor
              * @param mu problem parameter (constant or polynomial value)
              */
-            vanderpol(const T &mu=.5): base_dynamics<T>("Van der Pol dynamical system"), m_mu(mu){}
+            vanderpol(const T &mu=.5): base_dynamics<T, State>("Van der Pol dynamical system"), m_mu(mu){}
 
             /**
               * @brief ~vanderpol
               */
             ~vanderpol(){}
 
+            /**
+             * @brief check_input checks the time and the dimension of the state given to the dynamics of the Van der Pol oscillator.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             */
+            void check_input(const double &t, const State &state) const{
+                if(t < 0)
+                    smartmath_throw(m_name + ": negative time supplied in evaluation of the dynamical system");
+                if(state.size() != 2)
+                    smartmath_throw(m_name + ": the state dimension needs to be 2");
+            }
+
             /**
              * @brief evaluate evaluates the dynamics of the Van der Pol oscillator at a given instant of time and a given state.
              *
@@ -55,23 +67,46 @@ namespace smartmath
              * @param[out] dstate derivative of the states at time t
              * @return
              */
-            int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const
+            int evaluate(const double &t, const State &state, State &dstate) const
 		{
 		    //sanity checks
-		    if(t<0)
-			smartmath_throw(m_name+": negative time supplied in evaluation of the dynamical system");
-		    if(state.size()!=2)
-			smartmath_throw(m_name+": the state dimension needs to be 2");
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+		    vanderpol::check_input(t, state);
+#endif
 
-		    dstate.clear();
+		    state_traits<State>::resize(dstate, 2);
 
-		    dstate.push_back(state[1]);
-		    dstate.push_back(m_mu*(1.0-state[0]*state[0])*state[1]-state[0]);
+		    dstate[0] = state[1];
+		    dstate[1] = m_mu*(1.0-state[0]*state[0])*state[1]-state[0];
 
 		    return 0;
 		}
 
 
+            /**
+             * @brief jacobian evaluates the Jacobian of the Van der Pol oscillator at a given instant of time and a given state.
+             * @param[in] t time
+             * @param[in] state state values at time t
+             * @param[out] J Jacobian matrix at time t
+             * @return
+             */
+            int jacobian(const double &t, const State &state, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &J) const
+		{
+		    //sanity checks
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+		    if(state.size()!=2)
+			smartmath_throw(m_name+": the state dimension needs to be 2");
+#endif
+
+		    J.resize(2, 2);
+		    J(0, 0) = 0.0;
+		    J(0, 1) = 1.0;
+		    J(1, 0) = -2.0*m_mu*state[0]*state[1]-1.0;
+		    J(1, 1) = m_mu*(1.0-state[0]*state[0]);
+
+		    return 0;
+		}
+
         private:
             T m_mu;
         };
@@ -0,0 +1,185 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_VARIATIONAL_EQUATIONS_H
+#define SMARTMATH_VARIATIONAL_EQUATIONS_H
+
+#include "base_dynamics.h"
+#include "../exception.h"
+
+namespace smartmath
+{
+    namespace dynamics {
+
+        /**
+         * @brief The %variational_equations class augments a dynamical system with the equations of its state transition matrix
+         *
+         * The augmented state is made of the n states x followed by the n x n entries of the state transition matrix \f$\Phi\f$ stored column by column. Its dynamics is
+         * \f{eqnarray*}{
+         * \dot{x} &=& f(t,x) \\
+         * \dot{\Phi} &=& J(t,x) \Phi
+         * \f}
+         * where J is provided by the method jacobian() of the original dynamics. Any integrator can then propagate the state together with \f$\Phi\f$.
+         * The template parameter N is the dimension of the original system when known at compile time (e.g. 7 for spaceflight) so that the product \f$J \Phi\f$ is done on fixed-size matrices, Eigen::Dynamic otherwise.
+         * State is the state type of the original system, which can be of fixed size (see state_traits), the augmented state being a std::vector.
+         * The states and the Jacobian of the original system are kept in buffers of the object: evaluate() is not thread-safe and the parallel finite differences must not be enabled on the augmented system.
+         */
+        template < class T, int N = Eigen::Dynamic, class State = std::vector<T> >
+        class variational_equations: public base_dynamics<T>
+        {
+
+            static_assert((state_traits<State>::dimension < 0) || (state_traits<State>::dimension == N), "the dimension of a fixed-size state needs to be N");
+
+        private:
+            using base_dynamics<T>::m_name;
+
+            /**
+             * @brief Eigen matrix type of the Jacobian and of the state transition matrix
+             */
+            typedef Eigen::Matrix<T, N, N> matrix;
+
+        public:
+            /**
+             * @brief variational_equations constructor
+             * @param dyn original dynamical system
+             * @param n dimension of the original dynamical system (ignored if N is fixed)
+             */
+            variational_equations(const base_dynamics<T, State> *dyn, const unsigned int &n = 0):
+                base_dynamics<T>("variational equations of " + dyn->get_name()), m_dyn(dyn), m_n(N == Eigen::Dynamic ? n : N){
+                if(N == Eigen::Dynamic && n == 0)
+                    smartmath_throw(m_name + ": the dimension of the original system needs to be positive");
+                state_traits<State>::resize(m_x, m_n);
+                state_traits<State>::resize(m_dx, m_n);
+                m_J.resize(m_n, m_n);
+            }
+
+            /**
+              * @brief ~variational_equations
+              */
+            ~variational_equations(){}
+
+            /**
+             * @brief check_input checks the dimension of the augmented state and the inputs of the original dynamics
+             * @param[in] t time
+             * @param[in] state augmented state values at time t
+             */
+            void check_input(const double &t, const std::vector<T> &state) const
+            {
+                if(state.size() != m_n * (m_n + 1))
+                    smartmath_throw(m_name + ": the augmented state dimension needs to be n(n+1)");
+                for(unsigned int i = 0; i < m_n; i++)
+                    m_x[i] = state[i];
+                m_dyn->check_input(t, m_x);
+            }
+
+            /**
+             * @brief evaluate evaluates the augmented dynamics at a given instant of time and a given augmented state.
+             * @param[in] t time
+             * @param[in] state augmented state values at time t (n states followed by the state transition matrix by columns)
+             * @param[out] dstate derivative of the augmented state at time t
+             * @return exit flag (0=success, otherwise the one of the evaluation or of the Jacobian of the original system)
+             */
+            int evaluate(const double &t, const std::vector<T> &state, std::vector<T> &dstate) const
+            {
+                //sanity checks
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+                if(state.size() != m_n * (m_n + 1))
+                    smartmath_throw(m_name + ": the augmented state dimension needs to be n(n+1)");
+#endif
+
+                for(unsigned int i = 0; i < m_n; i++)
+                    m_x[i] = state[i];
+                int flag = m_dyn->evaluate(t, m_x, m_dx);
+                if(flag != 0)
+                    return flag;
+                flag = m_dyn->jacobian(t, m_x, m_J);
+                if(flag != 0)
+                    return flag;
+
+                dstate.resize(state.size());
+                for(unsigned int i = 0; i < m_n; i++)
+                    dstate[i] = m_dx[i];
+
+                Eigen::Map<const matrix> J(m_J.data(), m_n, m_n);
+                Eigen::Map<const matrix> Phi(&state[m_n], m_n, m_n);
+                Eigen::Map<matrix> dPhi(&dstate[m_n], m_n, m_n);
+                dPhi.noalias() = J * Phi;
+
+                return 0;
+            }
+
+            /**
+             * @brief initial_state builds the augmented state from a state of the original system and an identity state transition matrix
+             * @param[in] x0 state of the original system
+             * @return augmented state
+             */
+            std::vector<T> initial_state(const State &x0) const
+            {
+                if((unsigned int) x0.size() != m_n)
+                    smartmath_throw(m_name + ": the state dimension needs to be n");
+
+                std::vector<T> state(m_n * (m_n + 1), T(0.0));
+                for(unsigned int i = 0; i < m_n; i++)
+                    state[i] = x0[i];
+                for(unsigned int i = 0; i < m_n; i++)
+                    state[m_n + i * (m_n + 1)] = 1.0;
+
+                return state;
+            }
+
+            /**
+             * @brief split extracts the state of the original system and the state transition matrix from an augmented state
+             * @param[in] state augmented state
+             * @param[out] x state of the original system
+             * @param[out] Phi state transition matrix
+             */
+            void split(const std::vector<T> &state, State &x, Eigen::Matrix<T, N, N> &Phi) const
+            {
+                if(state.size() != m_n * (m_n + 1))
+                    smartmath_throw(m_name + ": the augmented state dimension needs to be n(n+1)");
+
+                state_traits<State>::resize(x, m_n);
+                for(unsigned int i = 0; i < m_n; i++)
+                    x[i] = state[i];
+                Phi = Eigen::Map<const matrix>(&state[m_n], m_n, m_n);
+            }
+
+            /**
+             * @brief get_dimension returns the dimension of the original dynamical system
+             * @return dimension n
+             */
+            unsigned int get_dimension() const{
+                return m_n;
+            }
+
+        private:
+            /**
+             * @brief m_dyn original dynamical system
+             */
+            const base_dynamics<T, State> *m_dyn;
+            /**
+             * @brief m_n dimension of the original dynamical system
+             */
+            unsigned int m_n;
+            /**
+             * @brief m_x, m_dx state of the original system and its derivative, sized once by the constructor
+             */
+            mutable State m_x, m_dx;
+            /**
+             * @brief m_J Jacobian of the original system, sized once by the constructor
+             */
+            mutable Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> m_J;
+        };
+
+    }
+}
+
+
+#endif // SMARTMATH_VARIATIONAL_EQUATIONS_H
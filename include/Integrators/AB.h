@@ -24,14 +24,15 @@ namespace smartmath
          *
          * The %AB class is an implementation of a multistep integrator namely the Adam-Bashforth algorithm with fixed step-size 
          */
-        template < class T >
-        class AB: public base_multistep<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class AB: public base_multistep<T, State, Dyn>
         {
 
         private:
-            using base_multistep<T>::m_name;
-            using base_multistep<T>::m_dyn;
-            using base_multistep<T>::m_order;
+            using base_multistep<T, State, Dyn>::m_name;
+            using base_multistep<T, State, Dyn>::m_dyn;
+            using base_multistep<T, State, Dyn>::evaluate;
+            using base_multistep<T, State, Dyn>::m_order;
             /**
              * @brief m_beta coefficients used in integration step
              */             
@@ -39,11 +40,11 @@ namespace smartmath
             /**
              * @brief m_initializerRK Runge-Kutta scheme used to initialize Adam-Bashforth
              */             
-            integrator::rk4<T> *m_initializerRK;
+            integrator::rk4<T, State, Dyn> *m_initializerRK;
             /**
              * @brief m_initializerBS Bulirsch-Stoer scheme used to initialize Adam-Bashforth
              */             
-            integrator::bulirschstoer<T> *m_initializerBS;
+            integrator::bulirschstoer<T, State, Dyn> *m_initializerBS;
             /**
              * @brief m_init boolean defining the type of initializer (true is B-S, false is R-K)
              */             
@@ -51,7 +52,7 @@ namespace smartmath
 
         public:
 
-            using base_multistep<T>::integrate;
+            using base_multistep<T, State, Dyn>::integrate;
             
             /**
              * @brief Adam Bashforth constructor
@@ -61,7 +62,7 @@ namespace smartmath
              * @param order order of the method
              * @param init boolean defining the type of initializer used by the method (true is B-S, false is R-K)
              */
-            AB(const dynamics::base_dynamics<T> *dyn, const unsigned int order = 8, const bool init = false): base_multistep<T>("Adam Bashforth integration scheme", dyn, order)
+            AB(const Dyn *dyn, const unsigned int order = 8, const bool init = false): base_multistep<T, State, Dyn>("Adam Bashforth integration scheme", dyn, order), m_init(init)
             {
                 if((order < 1 )||(order > 8))
                     smartmath_throw("AB: order must be between 1 and 8");  
@@ -80,8 +81,8 @@ namespace smartmath
                 for(unsigned int i = 0; i < m_order; i++)
                     m_beta.push_back(prebeta[m_order-1][i]);
 
-                m_initializerRK = new integrator::rk4<T>(m_dyn);
-                m_initializerBS = new integrator::bulirschstoer<T>(m_dyn, (order + 1) / 2);
+                m_initializerRK = new integrator::rk4<T, State, Dyn>(m_dyn);
+                m_initializerBS = new integrator::bulirschstoer<T, State, Dyn>(m_dyn, (order + 1) / 2);
 
             }
 
@@ -103,17 +104,16 @@ namespace smartmath
              * @param[out] xfinal vector of final states
              * @return
              */
-            int integration_step(const double &t, const unsigned int &m, const double &h, const std::vector<T> &x0, std::vector<std::vector<T> > &f, std::vector<T> &xfinal) const{
+            int integration_step(const double &t, const unsigned int &m, const double &h, const State &x0, state_history<State> &f, State &xfinal) const{
 
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
                 if(f.size() != m)
                     smartmath_throw("INTEGRATION_STEP: wrong number of saved states for multistep integration"); 
+#endif
 
                 xfinal = x0;
-                for(unsigned int i = 0; i < x0.size(); i++)
-                {
-                    for(unsigned int j = 0; j < m; j++)
-                        xfinal[i] += h * m_beta[j] * f[j][i];
-                }
+                for(unsigned int j = 0; j < m; j++)
+                    state_traits<State>::axpy(xfinal, h * m_beta[j], f[j]);
 
                 update_saved_steps(m, t + h, xfinal, f);
 
@@ -121,6 +121,21 @@ namespace smartmath
             }
   
 
+            /**
+             * @brief dense_step performs one step of the Bulirsch-Stoer initializer, whose order matches the one of the scheme, from a given state, used for the states at the output times
+             *
+             * The saved steps of the scheme only exist at the nodes of the integration. It is public for Adam Bashforth Moulton to use it as well.
+             * @param[in] t initial time of the step
+             * @param[in] h step-size
+             * @param[in] x vector of states at time t
+             * @param[out] xh vector of states at time t + h
+             * @return true
+             */
+            bool dense_step(const double &t, const double &h, const State &x, State &xh) const{
+                m_initializerBS->integration_step(t, h, x, xh);
+                return true;
+            }
+
             /**
              * @brief initialize method to integrate between two given time steps, initial condition and number of steps (saving intermediate states)
              *
@@ -132,15 +147,15 @@ namespace smartmath
              * @param[out] f vector of saved state vectors for multistep scheme
              * @return
              */    
-            int initialize(const unsigned int &m, const double &ti, const double &h, const std::vector<T> &x0, std::vector<std::vector<T> > &f) const{
+            int initialize(const unsigned int &m, const double &ti, const double &h, const State &x0, state_history<State> &f) const{
 
                 f.clear();
 
-                std::vector<T> dx(x0), x(x0), xp(x0);
-                std::vector< std::vector<T> > fp;
+                State dx(x0), x(x0), xp(x0);
+                state_history<State> fp;
                 
                 /* Computing the initial saved steps */
-                m_dyn->evaluate(ti, x, dx);
+                evaluate(ti, x, dx);
                 fp.push_back(dx);
                 double t = ti;
                 for(unsigned int j = 0; j < m - 1; j++)
@@ -151,7 +166,7 @@ namespace smartmath
                         m_initializerRK->integration_step(t, -h, x, xp);
                     t -= h;
                     x = xp;
-                    m_dyn->evaluate(t, x, dx);
+                    evaluate(t, x, dx);
                     fp.push_back(dx);
                 }
                 
@@ -172,16 +187,18 @@ namespace smartmath
              * @param[out] f vector of saved state vectors for multistep scheme
              * @return
              */     
-            int update_saved_steps(const unsigned int &m, const double &t, const std::vector<T> &x, std::vector<std::vector<T> > &f) const{
+            int update_saved_steps(const unsigned int &m, const double &t, const State &x, state_history<State> &f) const{
 
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
                 if(f[0].size() != x.size())
                     smartmath_throw("UPDATE_SAVED_STEPS: wrong number of previously saved states for multistep integration"); 
+#endif
 
-                std::vector<T> dx = x;
-                std::vector<std::vector<T> > fp = f;
+                State dx = x;
+                state_history<State> fp = f;
                 for(unsigned int j = 0; j < m - 1; j++)
                     f[j] = fp[j+1];
-                m_dyn->evaluate(t, x, dx);
+                evaluate(t, x, dx);
                 f[m-1] = dx;
 
                 return 0;
@@ -23,14 +23,15 @@ namespace smartmath
          *
          * The %ABM class is an implementation of a multistep integrator with fixed step-size namely the Adam-Bashforth-Moulton algorithm (a type of predictor-corrector)
          */
-        template < class T >
-        class ABM: public base_multistep<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class ABM: public base_multistep<T, State, Dyn>
         {
 
         private:
-            using base_multistep<T>::m_name;
-            using base_multistep<T>::m_dyn;
-            using base_multistep<T>::m_order;
+            using base_multistep<T, State, Dyn>::m_name;
+            using base_multistep<T, State, Dyn>::m_dyn;
+            using base_multistep<T, State, Dyn>::evaluate;
+            using base_multistep<T, State, Dyn>::m_order;
             /**
              * @brief m_beta coefficients used for corrector
              */                
@@ -38,7 +39,7 @@ namespace smartmath
             /**
              * @brief m_predictor integrator used as predictor (Adam-Bashforth)
              */            
-            integrator::AB<T> *m_predictor;
+            integrator::AB<T, State, Dyn> *m_predictor;
             /**
              * @brief m_init boolean defining the type of initializer used by the predictor (true is B-S, false is R-K)
              */             
@@ -46,7 +47,7 @@ namespace smartmath
 
         public:
 
-            using base_integrator<T>::integrate;
+            using base_integrator<T, State, Dyn>::integrate;
 
             /**
              * @brief Adam Bashforth Moulton constructor
@@ -56,7 +57,7 @@ namespace smartmath
              * @param order order of the method
              * @param init boolean defining the type of initializer used by the predictor (true is B-S, false is R-K)
              */
-            ABM(const dynamics::base_dynamics<T> *dyn, const unsigned int order = 8, const bool init = false): base_multistep<T>("Adam Bashforth Moulton algorithm", dyn, order), m_init(init)
+            ABM(const Dyn *dyn, const unsigned int order = 8, const bool init = false): base_multistep<T, State, Dyn>("Adam Bashforth Moulton algorithm", dyn, order), m_init(init)
             {
 
                 if((order < 2) || (order > 8))
@@ -75,7 +76,7 @@ namespace smartmath
                 for(unsigned int i = 0; i < m_order; i++)
                     m_beta_Moulton.push_back(prebeta[m_order-2][i]);
 
-                m_predictor = new integrator::AB<T>(m_dyn, m_order, m_init);
+                m_predictor = new integrator::AB<T, State, Dyn>(m_dyn, m_order, m_init);
 
             }
 
@@ -97,18 +98,20 @@ namespace smartmath
              * @param[out] xfinal vector of final states
              * @return
              */
-            int integration_step(const double &t, const unsigned int &m, const double &h, const std::vector<T> &x0, std::vector<std::vector<T> > &f, std::vector<T> &xfinal) const{
+            int integration_step(const double &t, const unsigned int &m, const double &h, const State &x0, state_history<State> &f, State &xfinal) const{
                 
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
                 if(f.size() != m)
                     smartmath_throw("INTEGRATION_STEP: wrong number of saved states in multistep integration"); 
+#endif
 
-                std::vector<T> dx = x0;    
+                State dx = x0;    
 
                 m_predictor->integration_step(t, m, h, x0, f, xfinal); // prediction 
 
                 correction(h, x0, f, xfinal); 
 
-                m_dyn->evaluate(t + h, xfinal, dx);
+                evaluate(t + h, xfinal, dx);
                 f[m-1] = dx;
 
                 return 0;
@@ -124,14 +127,11 @@ namespace smartmath
              * @param[out] xfinal vector of final states
              * @return
              */
-            int correction(const double &h, const std::vector<T> &x0, const std::vector<std::vector<T> > &f, std::vector<T> &xfinal) const{
+            int correction(const double &h, const State &x0, const state_history<State> &f, State &xfinal) const{
 
                 xfinal = x0;
-                for(unsigned int i = 0; i < x0.size(); i++)
-                {
-                    for(unsigned int j = 0; j < m_order; j++)
-                        xfinal[i] += h * m_beta_Moulton[j] * f[j][i];
-                }
+                for(unsigned int j = 0; j < m_order; j++)
+                    state_traits<State>::axpy(xfinal, h * m_beta_Moulton[j], f[j]);
 
                 return 0;
             }
@@ -147,13 +147,27 @@ namespace smartmath
              * @param[out] f vector of saved state vectors for multistep scheme
              * @return
              */     
-            int initialize(const unsigned int &m, const double &ti, const double &h, const std::vector<T> &x0, std::vector<std::vector<T> > &f) const{  
+            int initialize(const unsigned int &m, const double &ti, const double &h, const State &x0, state_history<State> &f) const{  
 
                 m_predictor->initialize(m, ti, h, x0, f);
 
                 return 0;
             }            
 
+        protected:
+            /**
+             * @brief dense_step performs one Bulirsch-Stoer step of the predictor from a given state, used for the states at the output times
+             * @param[in] t initial time of the step
+             * @param[in] h step-size
+             * @param[in] x vector of states at time t
+             * @param[out] xh vector of states at time t + h
+             * @return true
+             */
+            bool dense_step(const double &t, const double &h, const State &x, State &xh) const{
+                m_predictor->dense_step(t, h, x, xh);
+                return true;
+            }
+
         };
 
     }
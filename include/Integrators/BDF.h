@@ -0,0 +1,903 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+-------- e-mail: romain.serra@strath.ac.uk ---------------------------
+--------- Author: Romain Serra ---------------------------------------
+*/
+
+#ifndef SMARTMATH_BDF_H
+#define SMARTMATH_BDF_H
+
+#include "base_multistep.h"
+/* Eigen triggers -Wint-in-bool-context with recent GCC */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wint-in-bool-context"
+#endif
+#include "../LinearAlgebra/Eigen/LU"
+#include "../LinearAlgebra/Eigen/SparseLU"
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#include "../exception.h"
+#include "checkpoint.h"
+#include <limits>
+#include <memory>
+
+namespace smartmath
+{
+    namespace integrator {
+
+        /**
+         * @brief The %BDF class is an implementation of the variable step-size, variable order Backward Differentiation Formulas
+         *
+         * The %BDF class is an implicit multistep integrator for stiff problems with orders from 1 to 5.
+         * The history is kept in Nordsieck form i.e. the saved vectors are \f$ z_j = h^j x^{(j)} / j! \f$ for \f$ j = 0 \dots q \f$ so that changing the step-size only requires a rescaling.
+         * The implicit corrector is solved with a modified Newton iteration whose iteration matrix \f$ I - \gamma J \f$ is factorised once and reused across steps until the convergence degrades.
+         * The Jacobian and the factorisation belong to the integration (or to the stepper) like the Nordsieck history, so that an integrator can be used by several integrations at once.
+         * The Jacobian J is provided by the method jacobian() of the dynamics. If the dynamics declare a sparsity pattern, the sparse Jacobian is used instead and the iteration matrix is factorised with a sparse LU whose symbolic analysis is done once per integration.
+         * The scalar type T needs to be a real type supported by Eigen.
+         */
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class BDF: public base_multistep<T, State, Dyn>
+        {
+
+        private:
+            using base_multistep<T, State, Dyn>::m_name;
+            using base_multistep<T, State, Dyn>::m_dyn;
+            using base_multistep<T, State, Dyn>::evaluate;
+            using base_multistep<T, State, Dyn>::m_order;
+            /**
+             * @brief Eigen dense matrix type used for the Jacobian and the iteration matrix
+             */
+            typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> matrix;
+            /**
+             * @brief Eigen dense vector type used in the Newton iterations
+             */
+            typedef Eigen::Matrix<T, Eigen::Dynamic, 1> vector;
+            /**
+             * @brief m_tol tolerance for step-size and order control
+             */
+            double m_tol;
+            /**
+             * @brief m_multiplier maximum multiplying factor used when increasing step-size
+             */
+            double m_multiplier;
+            /**
+             * @brief m_l coefficients of the corrector for each order (m_l[q][j] for j = 0 ... q)
+             */
+            std::vector<std::vector<double> > m_l;
+            /**
+             * @brief Eigen sparse matrix type used for the Jacobian and the iteration matrix of systems with a sparsity pattern
+             */
+            typedef Eigen::SparseMatrix<T> sparse_matrix;
+
+        public:
+
+            using base_multistep<T, State, Dyn>::integrate;
+
+            /**
+             * @brief BDF constructor
+             *
+             * The integrator is initialized with the super class constructor. The user can choose the maximum order of the method, the default value being 5
+             * @param dyn pointer to the dynamical system to be integrated
+             * @param order maximum order of the method
+             * @param tol tolerance for the weighted local error estimate
+             * @param multiplier maximum multiplying factor for step-size control
+             */
+            BDF(const Dyn *dyn, const unsigned int order = 5, const double tol = 1.0e-7, const double multiplier = 5.0): base_multistep<T, State, Dyn>("Backward Differentiation Formulas variable step-size and order", dyn, order),
+                m_tol(tol), m_multiplier(multiplier)
+            {
+                if((order < 1) || (order > 5))
+                    smartmath_throw("BDF: order must be between 1 and 5");
+                if(tol <= 0.0)
+                    smartmath_throw("BDF: tolerance for estimated error must be positive");
+                if((multiplier > 10.0) || (multiplier < 1.5))
+                    smartmath_throw("BDF: maximum step-multiplier must be between 1.5 and 10");
+
+                /* coefficients of Lambda(x) = prod_{i=1}^{q} (1 + x / i) */
+                std::vector<double> l(1, 1.0);
+                m_l.push_back(l);
+                for(unsigned int q = 1; q <= m_order; q++)
+                {
+                    l.push_back(0.0);
+                    for(unsigned int j = q; j > 0; j--)
+                        l[j] += l[j - 1] / double(q);
+                    m_l.push_back(l);
+                }
+            }
+
+            /**
+              * @brief ~BDF deconstructor
+              */
+            ~BDF(){}
+
+            /**
+             * @brief integration_step performs one integration step with a given order and step-size
+             *
+             * The method implements one step of the BDF scheme of order m without error control, with a Jacobian evaluated for this step only
+             * @param[in] t initial time for integration step
+             * @param[in] m order
+             * @param[in] h step-size
+             * @param[in] x0 vector of initial states
+             * @param[in] f Nordsieck history (m + 1 vectors)
+             * @param[out] xfinal vector of final states
+             * @return exit flag (0=success, 1=Newton iterations failed)
+             */
+            int integration_step(const double &t, const unsigned int &m, const double &h, const State &x0, state_history<State> &f, State &xfinal) const{
+
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
+                if(f.size() != m + 1)
+                    smartmath_throw("INTEGRATION_STEP: wrong size of Nordsieck history for BDF integration");
+#endif
+
+                state_history<State> z;
+                State e;
+                iteration_matrix M;
+                M.sparse = sparse_dynamics(x0.size());
+                if(correct(t, m, h, f, z, e, M) != 0)
+                    return 1;
+
+                f = z;
+                xfinal = f[0];
+
+                return 0;
+            }
+
+            /**
+             * @brief initialize method to initialize integrator at initial time
+             *
+             * The method initializes the Nordsieck history at first order with step-size h
+             * @param[in] m number of saved steps (not used: the method always starts at first order)
+             * @param[in] ti initial time instant
+             * @param[in] h step size
+             * @param[in] x0 vector of initial states
+             * @param[out] f Nordsieck history
+             * @return
+             */
+            int initialize(const unsigned int &m, const double &ti, const double &h, const State &x0, state_history<State> &f) const{
+
+                f.clear();
+                State dx(x0);
+                evaluate(ti, x0, dx);
+                for(unsigned int i = 0; i < dx.size(); i++)
+                    dx[i] *= h;
+                f.push_back(x0);
+                f.push_back(dx);
+
+                return 0;
+            }
+
+            /**
+             * @brief The %iteration_matrix class holds the Jacobian and the factorisation of the iteration matrix of the Newton iterations
+             *
+             * A copy holds the same Jacobian. The sparse factorisation cannot be copied: the copy computes it again from the Jacobian at its first use, which gives the same factors.
+             */
+            class iteration_matrix
+            {
+
+            public:
+                iteration_matrix(): sparse(false), gamma(0.0), fresh_jacobian(false), jacobian_age(std::numeric_limits<unsigned int>::max()),
+                    m_SLU(new Eigen::SparseLU<sparse_matrix>()), m_analysed(false), m_factorised(false){}
+
+                iteration_matrix(const iteration_matrix &other): sparse(other.sparse), J(other.J), Js(other.Js), gamma(other.gamma), fresh_jacobian(other.fresh_jacobian),
+                    jacobian_age(other.jacobian_age), m_LU(other.m_LU), m_SLU(new Eigen::SparseLU<sparse_matrix>()), m_analysed(false), m_factorised(other.m_factorised && !other.sparse){}
+
+                iteration_matrix &operator=(const iteration_matrix &other){
+                    if(this != &other)
+                    {
+                        sparse = other.sparse;
+                        J = other.J;
+                        Js = other.Js;
+                        gamma = other.gamma;
+                        fresh_jacobian = other.fresh_jacobian;
+                        jacobian_age = other.jacobian_age;
+                        m_LU = other.m_LU;
+                        m_SLU.reset(new Eigen::SparseLU<sparse_matrix>());
+                        m_analysed = false;
+                        m_factorised = other.m_factorised && !other.sparse;
+                    }
+                    return *this;
+                }
+
+                /**
+                 * @brief factorise computes the LU factorisation of the iteration matrix I - gamma J
+                 *
+                 * In the sparse case the structure of the iteration matrix does not change during the integration so that the symbolic analysis is only done once
+                 * @param[in] g ratio between step-size and first coefficient of the corrector
+                 */
+                void factorise(const double &g){
+
+                    if(sparse)
+                    {
+                        sparse_matrix I(Js.rows(), Js.cols());
+                        I.setIdentity();
+                        sparse_matrix M = I - g * Js;
+                        M.makeCompressed();
+                        if(!m_analysed)
+                        {
+                            m_SLU->analyzePattern(M);
+                            m_analysed = true;
+                        }
+                        m_SLU->factorize(M);
+                        if(m_SLU->info() != Eigen::Success)
+                            smartmath_throw("BDF: sparse LU factorisation of the iteration matrix failed");
+                    }
+                    else
+                    {
+                        matrix M = matrix::Identity(J.rows(), J.cols()) - g * J;
+                        m_LU.compute(M);
+                    }
+                    gamma = g;
+                    m_factorised = true;
+                }
+
+                /**
+                 * @brief solve solves a linear system with the iteration matrix, factorised again with the same gamma if it has been copied or restored
+                 * @param[in] G right-hand side
+                 * @param[out] delta solution
+                 */
+                void solve(const vector &G, vector &delta){
+                    if(!m_factorised)
+                        factorise(gamma);
+                    if(sparse)
+                        delta = m_SLU->solve(G);
+                    else
+                        delta = m_LU.solve(G);
+                }
+
+                /**
+                 * @brief invalidate marks the factorisation as to be computed again before the next solve
+                 */
+                void invalidate(){
+                    m_analysed = false;
+                    m_factorised = false;
+                }
+
+                /**
+                 * @brief save writes the Jacobian and the value of gamma of the factorisation
+                 * @param[in,out] out checkpoint file
+                 */
+                void save(checkpoint_output &out) const{
+                    out.write(sparse);
+                    out.write(gamma);
+                    out.write(fresh_jacobian);
+                    out.write(jacobian_age);
+                    if(sparse)
+                        out.write_matrix(Js);
+                    else
+                        out.write_matrix(J);
+                }
+
+                /**
+                 * @brief load restores the data written by save(), the factorisation being computed again at the next solve, which gives the same factors without counting a new factorisation
+                 * @param[in,out] in checkpoint file
+                 */
+                void load(checkpoint_input &in){
+                    sparse = in.read<bool>();
+                    gamma = in.read<double>();
+                    fresh_jacobian = in.read<bool>();
+                    jacobian_age = in.read<unsigned int>();
+                    if(sparse)
+                        in.read_matrix(Js);
+                    else
+                        in.read_matrix(J);
+                    invalidate();
+                }
+
+                /**
+                 * @brief dimension returns the dimension of the last computed Jacobian
+                 * @return number of rows
+                 */
+                unsigned int dimension() const{
+                    return sparse ? Js.rows() : J.rows();
+                }
+
+                /**
+                 * @brief sparse true if the dynamics declare a sparsity pattern
+                 */
+                bool sparse;
+                /**
+                 * @brief J last computed Jacobian of the dynamics
+                 */
+                matrix J;
+                /**
+                 * @brief Js last computed sparse Jacobian of the dynamics
+                 */
+                sparse_matrix Js;
+                /**
+                 * @brief gamma value of h / l1 used in the current factorisation (0 if none)
+                 */
+                double gamma;
+                /**
+                 * @brief fresh_jacobian true if the Jacobian has been computed at the current step
+                 */
+                bool fresh_jacobian;
+                /**
+                 * @brief jacobian_age number of steps since the last Jacobian evaluation
+                 */
+                unsigned int jacobian_age;
+
+            private:
+                /**
+                 * @brief m_LU factorisation of the iteration matrix
+                 */
+                Eigen::PartialPivLU<matrix> m_LU;
+                /**
+                 * @brief m_SLU sparse factorisation of the iteration matrix (Eigen's sparse LU cannot be copied)
+                 */
+                std::unique_ptr< Eigen::SparseLU<sparse_matrix> > m_SLU;
+                /**
+                 * @brief m_analysed true if the symbolic analysis of the sparse iteration matrix has been done
+                 */
+                bool m_analysed;
+                /**
+                 * @brief m_factorised true if the factorisation corresponds to gamma and the Jacobian
+                 */
+                bool m_factorised;
+            };
+
+            /**
+             * @brief The %step_memory struct gathers the state of the step-size and order control and of the Newton iterations between two steps
+             */
+            struct step_memory
+            {
+                /**
+                 * @brief q current order
+                 */
+                unsigned int q;
+                /**
+                 * @brief steps_at_order number of steps accepted at the current order
+                 */
+                unsigned int steps_at_order;
+                /**
+                 * @brief previous_error true if e_previous is the correction of the previous step at the current step-size
+                 */
+                bool previous_error;
+                /**
+                 * @brief h current step-size
+                 */
+                double h;
+                /**
+                 * @brief hmin step-size under which a failure of the corrector or of the error test is fatal
+                 */
+                double hmin;
+                /**
+                 * @brief f Nordsieck history
+                 */
+                state_history<State> f;
+                /**
+                 * @brief z corrected Nordsieck history of the last attempt
+                 */
+                state_history<State> z;
+                /**
+                 * @brief e correction of the last attempt
+                 */
+                State e;
+                /**
+                 * @brief e_previous correction of the previous accepted step
+                 */
+                State e_previous;
+                /**
+                 * @brief iteration Jacobian and factorisation of the iteration matrix
+                 */
+                iteration_matrix iteration;
+            };
+
+            /**
+             * @brief start initializes the memory of the step-size and order control at first order
+             * @param[in] ti initial time instant
+             * @param[in] h initial step-size
+             * @param[in] x0 vector of initial states
+             * @param[out] mem memory of the step-size and order control
+             */
+            void start(const double &ti, const double &h, const State &x0, step_memory &mem) const{
+
+                mem.q = 1;
+                mem.steps_at_order = 0;
+                mem.previous_error = false;
+                mem.h = h;
+                mem.e = x0;
+                mem.e_previous = x0;
+                mem.iteration = iteration_matrix();
+                mem.iteration.sparse = sparse_dynamics(x0.size());
+                initialize(mem.q, ti, h, x0, mem.f);
+            }
+
+            /**
+             * @brief attempt_step performs one attempt of a step with step-size and order control
+             *
+             * The step-size is reduced so that tend is not exceeded. If the attempt is accepted, the time and the Nordsieck history are advanced and the step-size and order for the next step are selected. Otherwise the step-size is reduced for a new attempt
+             * @param[in,out] t current time
+             * @param[in] tend time not to be exceeded
+             * @param[in,out] mem memory of the step-size and order control (the state at time t is mem.f[0])
+             * @return exit flag (0=step accepted, 1=step rejected)
+             */
+            int attempt_step(double &t, const double &tend, step_memory &mem) const{
+
+                unsigned int &q = mem.q, &steps_at_order = mem.steps_at_order;
+                bool &previous_error = mem.previous_error;
+                double &h = mem.h, eta, eta_down, eta_up, err;
+                const double &hmin = mem.hmin;
+                state_history<State> &f = mem.f, &z = mem.z;
+                State &e = mem.e, &e_previous = mem.e_previous;
+                iteration_matrix &M = mem.iteration;
+
+                /* the correction of the previous step is rescaled too, for the test raising the order; tend is then reached exactly */
+                if(fabs(tend - t) < fabs(h))
+                {
+                    change_step((tend - t) / h, mem);
+                    h = tend - t;
+                }
+
+                /* Newton iterations for the corrector, with a fresh Jacobian before giving up */
+                if(correct(t, q, h, f, z, e, M) != 0)
+                {
+                    if(!M.fresh_jacobian)
+                    {
+                        M.jacobian_age = std::numeric_limits<unsigned int>::max();
+                        this->statistics().steps_rejected++;
+                        return 1;
+                    }
+                    if(fabs(h) <= hmin)
+                        smartmath_throw("BDF: Newton iterations failed with minimum step-size");
+                    rescale(0.25 * h, h, f);
+                    h *= 0.25;
+                    previous_error = false;
+                    this->statistics().steps_rejected++;
+                    return 1;
+                }
+
+                /* Local error test */
+                err = norm(e, z[0]) / (double(q + 1) * m_l[q][1]);
+                if(err > 1.0)
+                {
+                    eta = std::max(0.2, 0.9 * pow(err, -1.0 / double(q + 1)));
+                    if(fabs(h) <= hmin)
+                        smartmath_throw("BDF: local error test failed with minimum step-size");
+                    rescale(eta * h, h, f);
+                    h *= eta;
+                    previous_error = false;
+                    this->statistics().steps_rejected++;
+                    return 1;
+                }
+
+                /* Accepted step */
+                f = z;
+                t += h;
+                steps_at_order++;
+                M.jacobian_age++;
+                M.fresh_jacobian = false;
+
+                /* Step-size and order selection */
+                eta = 1.0 / (pow(1.2 * err, 1.0 / double(q + 1)) + 1.0e-6);
+                if(steps_at_order > q)
+                {
+                    unsigned int q_new = q;
+                    if(q > 1)
+                    {
+                        double factorial = 1.0;
+                        for(unsigned int j = 2; j < q; j++)
+                            factorial *= double(j);
+                        eta_down = 1.0 / (pow(1.3 * norm(f[q], f[0]) * factorial / m_l[q - 1][1], 1.0 / double(q)) + 1.0e-6);
+                        if(eta_down > eta)
+                        {
+                            eta = eta_down;
+                            q_new = q - 1;
+                        }
+                    }
+                    if((q < m_order) && previous_error)
+                    {
+                        State de(e);
+                        for(unsigned int i = 0; i < de.size(); i++)
+                            de[i] -= e_previous[i];
+                        eta_up = 1.0 / (pow(1.4 * norm(de, f[0]) / (double(q + 2) * m_l[q + 1][1]), 1.0 / double(q + 2)) + 1.0e-6);
+                        if(eta_up > eta)
+                        {
+                            eta = eta_up;
+                            q_new = q + 1;
+                        }
+                    }
+                    if(q_new > q)
+                    {
+                        double factorial = 1.0;
+                        for(unsigned int j = 2; j <= q_new; j++)
+                            factorial *= double(j);
+                        State zq(e);
+                        for(unsigned int i = 0; i < zq.size(); i++)
+                            zq[i] /= factorial;
+                        f.push_back(zq);
+                    }
+                    else if(q_new < q)
+                        f.pop_back();
+                    if(q_new != q)
+                    {
+                        q = q_new;
+                        steps_at_order = 0;
+                    }
+                }
+
+                /* the step-size is kept if the expected gain is small, which also saves factorisations */
+                eta = std::min(eta, m_multiplier);
+                if(eta < 1.2)
+                    eta = 1.0;
+                e_previous = e;
+                previous_error = (steps_at_order > 0);
+                if(eta != 1.0)
+                    change_step(eta, mem);
+
+                return 0;
+            }
+
+            /**
+             * @brief change_step multiplies the step-size of a memory, rescaling the Nordsieck history and the correction of the previous step
+             * @param[in] eta ratio between the new and the current step-size
+             * @param[in,out] mem memory of the step-size and order control
+             */
+            void change_step(const double &eta, step_memory &mem) const{
+
+                rescale(eta * mem.h, mem.h, mem.f);
+                mem.h *= eta;
+                /* the correction scales as h^(q+1) */
+                for(unsigned int i = 0; i < mem.e_previous.size(); i++)
+                    mem.e_previous[i] *= pow(eta, double(mem.q + 1));
+            }
+
+            /**
+             * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size
+             *
+             * The method implements the variable step-size, variable order BDF scheme with given initial time,
+             * final time, initial state condition and initial guess for step-size, the state after each step being passed to the observer
+             * @param[in] ti initial time instant
+             * @param[in] tend final time instant
+             * @param[in] nsteps initial guess for number of integration steps
+             * @param[in] x0 vector of initial states
+             * @param[in,out] observer observer of the intermediate states (including final one)
+             * @return exit flag (see integration_status)
+             */
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer) const{
+
+                step_memory mem;
+
+                return run(ti, tend, nsteps, x0, mem, observer);
+            }
+
+            /**
+             * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size (returning the states at requested times)
+             *
+             * The states at the requested times are evaluated with the interpolating polynomial given by the Nordsieck history, which has the order of the method and costs no evaluation of the dynamics.
+             * @param[in] ti initial time instant
+             * @param[in] tend final time instant
+             * @param[in] nsteps initial guess for number of integration steps
+             * @param[in] x0 vector of initial states
+             * @param[in] t_eval output times, sorted in the direction of integration between ti and tend
+             * @param[out] x_eval vector of states at the output times (only the ones reached if the integration was stopped before tend)
+             * @return exit flag (see integration_status)
+             */
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, const std::vector<double> &t_eval, state_history<State> &x_eval) const{
+
+                this->check_output_times(ti, tend, t_eval);
+                step_memory mem;
+                nordsieck_observer observer(mem, t_eval, x_eval);
+
+                int status = run(ti, tend, nsteps, x0, mem, observer);
+                if(status == INTEGRATION_SUCCESS)
+                    observer.complete();
+
+                return status;
+            }
+
+            /**
+             * @brief get_jacobian_evaluations returns the number of Jacobian evaluations during the last integration
+             * @return number of Jacobian evaluations
+             */
+            unsigned int get_jacobian_evaluations() const{
+                return this->get_statistics().jacobian_evaluations;
+            }
+
+            /**
+             * @brief get_LU_decompositions returns the number of LU factorisations of the iteration matrix during the last integration
+             * @return number of LU factorisations
+             */
+            unsigned int get_LU_decompositions() const{
+                return this->get_statistics().factorisations;
+            }
+
+            /**
+             * @brief get_newton_iterations returns the number of Newton iterations during the last integration
+             * @return number of Newton iterations
+             */
+            unsigned int get_newton_iterations() const{
+                return this->get_statistics().newton_iterations;
+            }
+
+        private:
+
+            /**
+             * @brief The %nordsieck_observer class fills the states at requested output times with the polynomial given by the Nordsieck history
+             *
+             * After a step accepted at time t, the history at t with step-size h defines \f$ x(t + s h) = \sum_j z_j s^j \f$, which is evaluated for the output times in the step.
+             */
+            class nordsieck_observer: public base_observer<T, State>
+            {
+
+            public:
+                /**
+                 * @brief nordsieck_observer constructor
+                 * @param mem memory of the step-size and order control holding the Nordsieck history
+                 * @param t_eval output times, sorted in the direction of integration
+                 * @param x_eval vector of states at the output times to be filled
+                 */
+                nordsieck_observer(const step_memory &mem, const std::vector<double> &t_eval, state_history<State> &x_eval): m_mem(mem), m_t_eval(t_eval), m_x_eval(x_eval), m_next(0), m_t(0.0){}
+
+                /**
+                 * @brief start fills the output times equal to the initial time
+                 * @param[in] t0 initial time instant
+                 * @param[in] x0 vector of initial states
+                 */
+                void start(const double &t0, const State &x0){
+                    m_x_eval.clear();
+                    m_next = 0;
+                    m_t = t0;
+                    while((m_next < m_t_eval.size()) && (m_t_eval[m_next] == t0))
+                    {
+                        m_x_eval.push_back(x0);
+                        m_next++;
+                    }
+                }
+
+                /**
+                 * @brief observe fills the output times lying in the last step
+                 * @param[in] t time at the end of the step
+                 * @param[in] x vector of states at time t
+                 */
+                void observe(const double &t, const State &x){
+
+                    while((m_next < m_t_eval.size()) && ((m_t_eval[m_next] - t) * (t - m_t) <= 0.0))
+                        fill(t);
+                    m_t = t;
+                }
+
+                /**
+                 * @brief complete fills the output times left at the end of an integration that reached its final time, which differ from the last time by round-off only
+                 */
+                void complete(){
+                    while(m_next < m_t_eval.size())
+                        fill(m_t);
+                }
+
+            private:
+                /**
+                 * @brief fill evaluates the polynomial of the Nordsieck history at the next output time
+                 * @param[in] t time of the Nordsieck history
+                 */
+                void fill(const double &t){
+                    /* Horner scheme in s = (t_eval - t) / h */
+                    const state_history<State> &z = m_mem.f;
+                    const double s = (m_t_eval[m_next] - t) / m_mem.h;
+                    State xe(z.back());
+                    for(unsigned int j = z.size() - 1; j > 0; j--)
+                    {
+                        for(unsigned int i = 0; i < xe.size(); i++)
+                            xe[i] = z[j - 1][i] + s * xe[i];
+                    }
+                    m_x_eval.push_back(xe);
+                    m_next++;
+                }
+
+                /**
+                 * @brief m_mem memory of the step-size and order control
+                 */
+                const step_memory &m_mem;
+                /**
+                 * @brief m_t_eval output times
+                 */
+                const std::vector<double> &m_t_eval;
+                /**
+                 * @brief m_x_eval states at the output times
+                 */
+                state_history<State> &m_x_eval;
+                /**
+                 * @brief m_next index of the next output time
+                 */
+                unsigned int m_next;
+                /**
+                 * @brief m_t time at the end of the last step
+                 */
+                double m_t;
+            };
+
+            /**
+             * @brief run performs the integration with a given memory of the step-size and order control
+             * @param[in] ti initial time instant
+             * @param[in] tend final time instant
+             * @param[in] nsteps initial guess for number of integration steps
+             * @param[in] x0 vector of initial states
+             * @param[out] mem memory of the step-size and order control
+             * @param[in,out] observer observer of the intermediate states
+             * @return exit flag (see integration_status)
+             */
+            int run(const double &ti, const double &tend, const int &nsteps, const State &x0, step_memory &mem, base_observer<T, State> &observer) const{
+
+                this->check_entry(ti, tend, x0);
+                SMARTMATH_TRACE_SCOPE("integrate");
+                integration_record record(this->m_statistics);
+
+                observer.start(ti, x0);
+
+                double t = ti;
+                unsigned long steps = 0;
+                start(ti, (tend - ti) / double(nsteps), x0, mem);
+                mem.hmin = 16.0 * std::numeric_limits<double>::epsilon() * (fabs(ti) + fabs(tend));
+
+                record.start_steps();
+                while(fabs(t - ti) < fabs(tend - ti))
+                {
+                    SMARTMATH_TRACE_SCOPE("step");
+                    int status = this->check_limits(record, steps);
+                    if(status != INTEGRATION_SUCCESS)
+                    {
+                        observer.finish(t, mem.f[0]);
+                        return record.finish(status, steps);
+                    }
+
+                    if(attempt_step(t, tend, mem) == 0)
+                    {
+                        steps++;
+                        observer.observe(t, mem.f[0]);
+                    }
+                }
+
+                observer.finish(t, mem.f[0]);
+                return record.finish(0, steps);
+            }
+
+            /**
+             * @brief correct performs the prediction and the Newton iterations of the corrector
+             *
+             * The method predicts the Nordsieck history at t + h and solves the corrector equation with a modified Newton method, refreshing the Jacobian and the factorisation when needed
+             * @param[in] t initial time for integration step
+             * @param[in] q order
+             * @param[in] h step-size
+             * @param[in] f Nordsieck history at time t
+             * @param[out] z corrected Nordsieck history at time t + h
+             * @param[out] e correction vector (difference between corrected and predicted states)
+             * @param[in,out] M Jacobian and factorisation of the iteration matrix
+             * @return exit flag (0=success, 1=Newton iterations failed)
+             */
+            int correct(const double &t, const unsigned int &q, const double &h, const state_history<State> &f, state_history<State> &z, State &e, iteration_matrix &M) const{
+
+                unsigned int n = f[0].size();
+                const std::vector<double> &l = m_l[q];
+                double gamma = h / l[1], rate = 1.0, dnorm, dnorm_old = 0.0;
+
+                /* prediction with the Pascal triangle */
+                z = f;
+                for(unsigned int k = 0; k < q; k++)
+                {
+                    for(unsigned int j = q; j > k; j--)
+                    {
+                        for(unsigned int i = 0; i < n; i++)
+                            z[j - 1][i] += z[j][i];
+                    }
+                }
+
+                /* refreshing the Jacobian and the iteration matrix if needed */
+                if((M.jacobian_age > 20) || (M.dimension() != n))
+                {
+                    SMARTMATH_TRACE_SCOPE("jacobian");
+                    if(M.sparse)
+                        m_dyn->sparse_jacobian(t + h, z[0], M.Js);
+                    else
+                        m_dyn->jacobian(t + h, z[0], M.J);
+                    this->statistics().jacobian_evaluations++;
+                    M.jacobian_age = 0;
+                    M.fresh_jacobian = true;
+                    M.gamma = 0.0;
+                }
+                if((M.gamma == 0.0) || (fabs(gamma / M.gamma - 1.0) > 0.3))
+                {
+                    SMARTMATH_TRACE_SCOPE("factorise");
+                    M.factorise(gamma);
+                    this->statistics().factorisations++;
+                }
+
+                /* modified Newton iterations, with temporaries drawn from the arena of the thread for states using step_allocator (z and e are kept in the memory) */
+                step_scope scope;
+                State y(z[0]), fy(z[0]);
+                vector G(n), delta(n);
+                e = z[0];
+                for(unsigned int i = 0; i < n; i++)
+                    e[i] = 0.0 * z[0][0];
+                for(unsigned int it = 0; it < 4; it++)
+                {
+                    this->statistics().newton_iterations++;
+                    for(unsigned int i = 0; i < n; i++)
+                        y[i] = z[0][i] + e[i];
+                    evaluate(t + h, y, fy);
+                    for(unsigned int i = 0; i < n; i++)
+                        G(i) = gamma * fy[i] - z[1][i] / l[1] - e[i];
+                    /* the factorisation may correspond to a slightly different gamma: rescaling keeps the iteration consistent */
+                    M.solve(G, delta);
+                    if(M.gamma != gamma)
+                        delta *= 2.0 / (1.0 + gamma / M.gamma);
+                    for(unsigned int i = 0; i < n; i++)
+                        e[i] += delta(i);
+
+                    dnorm = norm(delta, y);
+                    if(it > 0)
+                        rate = std::max(0.2 * rate, dnorm / dnorm_old);
+                    if(dnorm * std::min(1.0, rate) <= 0.2)
+                    {
+                        for(unsigned int j = 0; j <= q; j++)
+                        {
+                            for(unsigned int i = 0; i < n; i++)
+                                z[j][i] += l[j] * e[i];
+                        }
+                        return 0;
+                    }
+                    if((it > 0) && (rate > 2.0))
+                        break;
+                    dnorm_old = dnorm;
+                }
+
+                /* convergence failure: the factorisation is not trusted anymore */
+                M.gamma = 0.0;
+
+                return 1;
+            }
+
+            /**
+             * @brief sparse_dynamics returns true if the dynamics declare a sparsity pattern
+             * @param[in] n dimension of the state vector
+             * @return true if the sparse Jacobian is to be used
+             */
+            bool sparse_dynamics(const unsigned int &n) const{
+                std::vector<std::vector<unsigned int> > pattern;
+                return m_dyn->sparsity_pattern(n, pattern);
+            }
+
+            /**
+             * @brief rescale rescales the Nordsieck history for a change of step-size
+             * @param[in] h_new new step-size
+             * @param[in] h current step-size
+             * @param[in,out] f Nordsieck history
+             */
+            void rescale(const double &h_new, const double &h, state_history<State> &f) const{
+
+                double eta = h_new / h, factor = 1.0;
+                for(unsigned int j = 1; j < f.size(); j++)
+                {
+                    factor *= eta;
+                    for(unsigned int i = 0; i < f[j].size(); i++)
+                        f[j][i] *= factor;
+                }
+            }
+
+            /**
+             * @brief norm computes the weighted root-mean-square norm used for the error and convergence tests
+             * @param[in] v vector whose norm is computed
+             * @param[in] x state vector used for the weights
+             * @return weighted norm (1 corresponds to the tolerance)
+             */
+            template < class V >
+            double norm(const V &v, const State &x) const{
+
+                double sum = 0.0, w;
+                for(unsigned int i = 0; i < x.size(); i++)
+                {
+                    w = m_tol * (1.0 + fabs(x[i]));
+                    sum += pow(v[i] / w, 2);
+                }
+
+                return sqrt(sum / double(x.size()));
+            }
+
+        };
+
+    }
+}
+
+#endif // SMARTMATH_BDF_H
@@ -23,15 +23,16 @@ namespace smartmath
          *
          * The %base_embeddedRK class is a template abstract class. Any variable step-size Runge-Kutta algorithm added to the toolbox needs to inherit from it and implement the method that performs on integration step between to given times given the initial state 
          */
-        template < class T >
-        class base_embeddedRK: public base_integrationwevent<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class base_embeddedRK: public base_integrationwevent<T, State, Dyn>
         {
 
         protected:
-            using base_integrationwevent<T>::m_name;
-            using base_integrationwevent<T>::m_dyn;
-            using base_integrationwevent<T>::m_minstep_events;
-            using base_integrationwevent<T>::m_maxstep_events;               
+            using base_integrationwevent<T, State, Dyn>::m_name;
+            using base_integrationwevent<T, State, Dyn>::m_dyn;
+            using base_integrationwevent<T, State, Dyn>::evaluate;
+            using base_integrationwevent<T, State, Dyn>::m_minstep_events;
+            using base_integrationwevent<T, State, Dyn>::m_maxstep_events;               
             /**
              * @brief m_tol tolerance for step-size control
              */
@@ -48,7 +49,7 @@ namespace smartmath
 
         public:
 
-            using base_integrationwevent<T>::integrate;
+            using base_integrationwevent<T, State, Dyn>::integrate;
 
             /**
              * @brief base_embeddedRK constructor
@@ -61,7 +62,7 @@ namespace smartmath
              * @param minstep_events minimum step-size to detect an event
              * @param maxstep_events maximum step-size
              */
-            base_embeddedRK(const std::string &name, const dynamics::base_dynamics<T> *dyn, const double &tol, const double &multiplier, const double &minstep_events, const double &maxstep_events) : base_integrationwevent<T>(name, dyn, minstep_events, maxstep_events), m_tol(tol), m_multiplier(multiplier){
+            base_embeddedRK(const std::string &name, const Dyn *dyn, const double &tol, const double &multiplier, const double &minstep_events, const double &maxstep_events) : base_integrationwevent<T, State, Dyn>(name, dyn, minstep_events, maxstep_events), m_tol(tol), m_multiplier(multiplier){
                 
                 /** sanity checks **/
                 if(tol <= 0.0)
@@ -90,66 +91,111 @@ namespace smartmath
              * @param[out] er estimated error
              * @return
              */
-            virtual int integration_step(const double &ti, const unsigned int &m, const double &h, const std::vector<T> &x0, const std::vector<std::vector<T> > &f, std::vector<T> &xfinal, T &er) const = 0;
+            virtual int integration_step(const double &ti, const unsigned int &m, const double &h, const State &x0, const state_history<State> &f, State &xfinal, T &er) const = 0;
+
+            /**
+             * @brief controlled_step attempts one integration step and evaluates the step-size control
+             *
+             * The step-size is first limited by the maximum step-size of the integrator and by the distance to tend, then the step is performed and its estimated error is compared to the tolerance
+             * @param[in] t initial time of the step
+             * @param[in] tend time not to be exceeded
+             * @param[in,out] h step-size to attempt, on exit the step-size actually attempted
+             * @param[in] x0 vector of states at time t
+             * @param[out] xfinal vector of states at time t + h
+             * @param[out] factor factor proposed by the controller for the next step-size (bounded by the maximum multiplier if the step is accepted)
+             * @return true if the step is accepted
+             */
+            bool controlled_step(const double &t, const double &tend, double &h, const State &x0, State &xfinal, double &factor) const{
+
+                if((h * h > m_maxstep_events*m_maxstep_events) && (m_maxstep_events > 0.0))
+                {
+                    if(h > 0.0)
+                        h = m_maxstep_events;
+                    else
+                        h = -m_maxstep_events;
+                }
+
+                if(sqrt(pow(tend - t, 2)) < sqrt(h * h))
+                    h = tend - t;
+
+                state_history<State> f;
+                T er = 0.0 * x0[0];
+                integration_step(t, m_control, h, x0, f, xfinal, er);
+
+                double value = evaluate_squarerootintegrationerror(er);
+                factor = pow(m_tol / value, 1.0 / (double(m_control) + 1.0));
+                if(er > m_tol)
+                {
+                    this->statistics().steps_rejected++;
+                    return false;
+                }
+
+                if(factor > m_multiplier)
+                    factor = m_multiplier;
+                return true;
+            }
 
             /**
              * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size while handling events
              *
              * The method implements a variable step-size scheme to integrate with given initial time,
-             * final time, initial state condition and initial guess for step-size
+             * final time, initial state condition and initial guess for step-size, the state after each step being passed to the observer
              * @param[in] ti initial time instant
              * @param[in] tend final time instant
              * @param[in] nsteps initial guess for number of integration steps
              * @param[in] x0 vector of initial states
-             * @param[out] x_history vector of intermediate states
-             * @param[out] t_history vector of intermediate times
+             * @param[in,out] observer observer of the intermediate states
              * @param[in] g event function             
-             * @return
+             * @return exit flag (see integration_status)
              */
-            int integrate(const double &ti, double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history, std::vector<int> (*g)(std::vector<T> x, double d)) const{
+            int integrate(const double &ti, double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer, std::vector<int> (*g)(State x, double d)) const{
 
-                x_history.clear();
-                t_history.clear();
+                this->check_entry(ti, tend, x0);
+                SMARTMATH_TRACE_SCOPE("integrate");
+                integration_record record(this->m_statistics);
+
+                observer.start(ti, x0);
 
                 unsigned int k;
                 int check = 0;
-                std::vector<T> x(x0), xtemp(x0);
-                std::vector<std::vector<T> > f;
+                State x(x0), xtemp(x0);
 
-                double factor = 1.0, value = 0.0, t = ti, h = (tend - ti) / double(nsteps);
-                T er = 0.0 * x0[0];
+                double factor = 1.0, t = ti, h = (tend - ti) / double(nsteps);
 
                 std::vector<int> events, events2;
                 events = g(x0, ti);
                 events2 = events;
                 unsigned int m = events.size();           
 
+                record.start_steps();
                 unsigned int i = 0;
                 while(sqrt(pow(t - ti, 2)) < sqrt(pow(tend - ti, 2)))
                 {
+                    SMARTMATH_TRACE_SCOPE("step");
+                    int status = this->check_limits(record, i);
+                    if(status != INTEGRATION_SUCCESS)
+                    {
+                        tend = t; // saving the time of the last accepted step
+                        observer.finish(t, x);
+                        return record.finish(status, i);
+                    }
+
 
-                    if((h * h > m_maxstep_events*m_maxstep_events) && (m_maxstep_events > 0.0))
+                    /* Step-size control, the temporaries of the attempt being drawn from the arena of the thread for states using step_allocator */
+                    bool accepted;
                     {
-                        if(h > 0.0)
-                            h = m_maxstep_events;
-                        else
-                            h = -m_maxstep_events;
-                    }   
-
-                    if(sqrt(pow(tend - t, 2)) < sqrt(h * h))
-                        h = tend - t;
-
-                    integration_step(t, m_control, h, x, f, xtemp, er);
-                    
-                    /* Step-size control */
-                    value = evaluate_squarerootintegrationerror(er);
-                    factor=pow(m_tol / value, 1.0 / (double(m_control) + 1.0));
-                    if(er > m_tol) // unsucessful step
-                        h *= 0.9 * factor;  
+                        step_scope scope;
+                        accepted = controlled_step(t, tend, h, x, xtemp, factor);
+                    }
+                    if(!accepted) // unsucessful step
+                        h *= 0.9 * factor;
                     else
                     { // sucessful step
                         /* Checking for the events */
-                        events2 = g(xtemp, t + h);
+                        {
+                            SMARTMATH_TRACE_SCOPE("events");
+                            events2 = g(xtemp, t + h);
+                        }
 
                         k = 0;
                         check = 0;        
@@ -167,13 +213,16 @@ namespace smartmath
                         if(check == 1)
                         {
                             if(sqrt(h * h) > m_minstep_events)
+                            {
                                 h *= 0.5;
+                                this->statistics().event_iterations++;
+                            }
                             else
                             {
                                 tend = t + h; // saving the termination time    
                                 t = tend; // trick to get out of the while loop   
-                                x_history.push_back(xtemp);
-                                t_history.push_back(t);
+                                x = xtemp; // final state
+                                observer.event(t, x);
 
                                 if(this->m_comments)
                                     std::cout << "Propagation interrupted by terminal event at time " << tend << " after " << i << " steps" << std::endl;
@@ -184,11 +233,8 @@ namespace smartmath
                             x = xtemp; // updating state
                             t += h; // updating current time  
                             events = events2; 
-                            x_history.push_back(x);
-                            t_history.push_back(t); 
+                            observer.observe(t, x);
                             /* Step-size control */
-                            if(factor > m_multiplier)
-                                factor = m_multiplier;  
                             h *= factor; // updating step-size
                             i++; // counting the number of steps
                         }           
@@ -196,7 +242,26 @@ namespace smartmath
                     }
                 }
 
-                return 0;
+                observer.finish(t, x);
+                return record.finish(0, i);
+            }
+
+        protected:
+            /**
+             * @brief dense_step performs one step of the scheme with the order used to propagate, from a given state, used for the states at the output times
+             *
+             * No step-size control is needed: shorter than the accepted step it lies in, the step has a smaller error.
+             * @param[in] t initial time of the step
+             * @param[in] h step-size
+             * @param[in] x vector of states at time t
+             * @param[out] xh vector of states at time t + h
+             * @return true
+             */
+            bool dense_step(const double &t, const double &h, const State &x, State &xh) const{
+                state_history<State> f;
+                T er = 0.0 * x[0];
+                integration_step(t, m_control, h, x, f, xh, er);
+                return true;
             }
 
         };
@@ -23,13 +23,14 @@ namespace smartmath
          *
          * The %base_integrationwevent class is a template abstract class. Any integrator handling events added to the toolbox needs to inherit from it and implement the method that integrates while dealing with events 
          */
-        template < class T >
-        class base_integrationwevent: public base_integrator<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class base_integrationwevent: public base_integrator<T, State, Dyn>
         {
 
         protected:
-            using base_integrator<T>::m_name;
-            using base_integrator<T>::m_dyn;
+            using base_integrator<T, State, Dyn>::m_name;
+            using base_integrator<T, State, Dyn>::m_dyn;
+            using base_integrator<T, State, Dyn>::evaluate;
             /**
              * @brief m_minstep_events minimum step-size for events detection
              */
@@ -41,7 +42,7 @@ namespace smartmath
 
         public:
 
-            using base_integrator<T>::integrate;
+            using base_integrator<T, State, Dyn>::integrate;
 
             /**
              * @brief base_integrationwevent constructor
@@ -52,7 +53,7 @@ namespace smartmath
              * @param minstep_events minimum step-size to detect an event
              * @param maxstep_events maximum step-size
              */
-            base_integrationwevent(const std::string &name, const dynamics::base_dynamics<T> *dyn, const double &minstep_events, const double &maxstep_events) : base_integrator<T>(name, dyn), m_minstep_events(minstep_events), m_maxstep_events(maxstep_events){
+            base_integrationwevent(const std::string &name, const Dyn *dyn, const double &minstep_events, const double &maxstep_events) : base_integrator<T, State, Dyn>(name, dyn), m_minstep_events(minstep_events), m_maxstep_events(maxstep_events){
                 
                 if(minstep_events <= 0.0)
                    smartmath_throw("BASE_INTEGRATIONWEVENT: minimum step-size for events must be non negative");
@@ -71,22 +72,40 @@ namespace smartmath
              * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size while handling events
              *
              * The method implements a variable step-size scheme to integrate with given initial time,
-             * final time, initial state condition and initial guess for step-size
+             * final time, initial state condition and initial guess for step-size, the state after each step being passed to the observer
              * @param[in] ti initial time instant
              * @param[in] tend final time instant
              * @param[in] nsteps initial guess for number of integration steps
              * @param[in] x0 vector of initial states
-             * @param[out] x_history vector of intermediate states
-             * @param[out] t_history vector of intermediate times
-             * @param[in] g event function             
-             * @return
+             * @param[in,out] observer observer of the intermediate states
+             * @param[in] g event function
+             * @return exit flag (see integration_status)
              */
-            virtual int integrate(const double &ti, double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history, std::vector<int> (*g)(std::vector<T> x, double d)) const=0;
+            virtual int integrate(const double &ti, double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer, std::vector<int> (*g)(State x, double d)) const=0;
 
             /**
              * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size
              *
              * The method implements a variable step-size scheme to integrate with given initial time,
+             * final time, initial state condition and initial guess for step-size, the state after each step being passed to the observer
+             * @param[in] ti initial time instant
+             * @param[in] tend final time instant
+             * @param[in] nsteps initial guess for number of integration steps
+             * @param[in] x0 vector of initial states
+             * @param[in,out] observer observer of the intermediate states
+             * @return exit flag (see integration_status)
+             */
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer) const{
+
+                double tf = tend;
+
+                return integrate(ti, tf, nsteps, x0, observer, dummy_event);
+            }
+
+            /**
+             * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size while handling events
+             *
+             * The method implements a variable step-size scheme to integrate with given initial time,
              * final time, initial state condition and initial guess for step-size
              * @param[in] ti initial time instant
              * @param[in] tend final time instant
@@ -94,18 +113,44 @@ namespace smartmath
              * @param[in] x0 vector of initial states
              * @param[out] x_history vector of intermediate states
              * @param[out] t_history vector of intermediate times
-             * @return
+             * @param[in] g event function             
+             * @return exit flag (see integration_status)
              */
-            int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history) const{
+            int integrate(const double &ti, double &tend, const int &nsteps, const State &x0, state_history<State> &x_history, std::vector<double> &t_history, std::vector<int> (*g)(State x, double d)) const{
 
-                double t0 = ti, tf = tend, n = nsteps;
-                std::vector<T> x(x0);
+                history_observer<T, State> observer(x_history, t_history, this->m_recording);
 
-                integrate(t0, tf, n, x, x_history, t_history, dummy_event);
-    
-                return 0;
+                integration_record record(this->m_statistics);
+                int status = integrate(ti, tend, nsteps, x0, observer, g);
+                record.statistics().history_bytes = this->history_memory(x_history) + t_history.capacity() * sizeof(double);
+
+                return status;
             }
 
+            /**
+             * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size while handling events (returning the states at requested times)
+             *
+             * The states at the requested times inside a step are computed with a step of the method from the beginning of that step.
+             * @param[in] ti initial time instant
+             * @param[in] tend final time instant
+             * @param[in] nsteps initial guess for number of integration steps
+             * @param[in] x0 vector of initial states
+             * @param[in] t_eval output times, sorted in the direction of integration between ti and tend
+             * @param[out] x_eval vector of states at the output times (only the ones reached before a terminal event)
+             * @param[in] g event function
+             * @return exit flag (see integration_status)
+             */
+            int integrate(const double &ti, double &tend, const int &nsteps, const State &x0, const std::vector<double> &t_eval, state_history<State> &x_eval, std::vector<int> (*g)(State x, double d)) const{
+
+                this->check_output_times(ti, tend, t_eval);
+                typename base_integrator<T, State, Dyn>::dense_observer observer(this, t_eval, x_eval);
+
+                integration_record record(this->m_statistics);
+                int status = integrate(ti, tend, nsteps, x0, observer, g);
+                record.statistics().history_bytes = this->history_memory(x_eval);
+
+                return status;
+            }
 
             /**
              * @brief integrate method to integrate bewteen two given time steps, with initial condition and initial guess for step-size while handling events
@@ -120,16 +165,11 @@ namespace smartmath
              * @param[in] g event function
              * @return
              */
-            int integrate(const double &ti, double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<T> &xfinal, std::vector<int> (*g)(std::vector<T> x, double d)) const{
-
-                std::vector<std::vector<T> > x_history;
-                std::vector<double> t_history;
-
-                integrate(ti, tend, nsteps, x0, x_history, t_history, *g);
+            int integrate(const double &ti, double &tend, const int &nsteps, const State &x0, State &xfinal, std::vector<int> (*g)(State x, double d)) const{
 
-                xfinal = x_history.back();
+                final_observer<T, State> observer(xfinal);
 
-                return 0;
+                return integrate(ti, tend, nsteps, x0, observer, g);
             }
 
             /**
@@ -139,7 +179,7 @@ namespace smartmath
              * @param[in] d time
              * @return vector with one 0
              */
-            static std::vector<int> dummy_event(std::vector<T> x, double d){
+            static std::vector<int> dummy_event(State x, double d){
 
                 std::vector<int> output(1, 0);
 
@@ -15,51 +15,454 @@
 
 #include "../Dynamics/base_dynamics.h"
 #include "../exception.h"
+#include "base_observer.h"
+#include "../Utils/trace.h"
+#include "../Utils/pool_allocator.h"
+#include <type_traits>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <utility>
 
 namespace smartmath
 {
     namespace integrator {
 
+        /**
+         * @brief integration_status exit flags of the integrate methods
+         *
+         * An integration stopped by one of the limits of integration_limits returns the states up to the last accepted step.
+         */
+        enum integration_status
+        {
+            INTEGRATION_SUCCESS = 0,
+            INTEGRATION_TIME_LIMIT = 1,
+            INTEGRATION_EVALUATION_LIMIT = 2,
+            INTEGRATION_STEP_LIMIT = 3,
+            INTEGRATION_CANCELLED = 4
+        };
+
+        /**
+         * @brief The %integration_limits struct gathers the budget of an integration
+         *
+         * A zero value means no limit. The limits are checked between two steps, so an integration can exceed the number of evaluations by the cost of one step.
+         */
+        struct integration_limits
+        {
+            integration_limits(): max_wall_time(0.0), max_evaluations(0), max_steps(0), cancel(NULL){}
+
+            /**
+             * @brief max_wall_time maximum wall-clock duration of the integration in seconds
+             */
+            double max_wall_time;
+            /**
+             * @brief max_evaluations maximum number of evaluations of the dynamics
+             */
+            unsigned long max_evaluations;
+            /**
+             * @brief max_steps maximum number of accepted steps
+             */
+            unsigned long max_steps;
+            /**
+             * @brief cancel token set to true by another thread to stop the integration
+             */
+            const std::atomic<bool> *cancel;
+        };
+
+        /**
+         * @brief The %integration_statistics struct gathers the cost of an integration
+         *
+         * The statistics are filled by every integrate method and read with get_statistics() once it has returned. Collecting them costs an increment per evaluation and per rejected step and three readings of the clock per integration.
+         * They are counted in an integration_record local to the call, so that a const integrator can be used by several threads at once.
+         */
+        struct integration_statistics
+        {
+            integration_statistics(): evaluations(0), bootstrap_evaluations(0), steps_accepted(0), steps_rejected(0), event_iterations(0), jacobian_evaluations(0), factorisations(0),
+                newton_iterations(0), history_bytes(0), setup_time(0.0), stepping_time(0.0){}
+
+            /**
+             * @brief evaluations number of evaluations of the dynamics, including the bootstrap and the interpolation of the output (the kicks and drifts of the symplectic integrators are not counted)
+             */
+            unsigned long evaluations;
+            /**
+             * @brief bootstrap_evaluations number of evaluations before the first step (starting values of the multistep schemes, initial derivative of BDF)
+             */
+            unsigned long bootstrap_evaluations;
+            /**
+             * @brief steps_accepted number of accepted steps
+             */
+            unsigned long steps_accepted;
+            /**
+             * @brief steps_rejected number of steps rejected by the error control of the variable step-size integrators
+             */
+            unsigned long steps_rejected;
+            /**
+             * @brief event_iterations number of halvings of the step-size to locate an event
+             */
+            unsigned long event_iterations;
+            /**
+             * @brief jacobian_evaluations number of evaluations of the Jacobian of the dynamics (implicit integrators)
+             */
+            unsigned long jacobian_evaluations;
+            /**
+             * @brief factorisations number of LU factorisations of the iteration matrix (implicit integrators)
+             */
+            unsigned long factorisations;
+            /**
+             * @brief newton_iterations number of iterations of the Newton method solving the corrector (implicit integrators)
+             */
+            unsigned long newton_iterations;
+            /**
+             * @brief history_bytes memory held by the history or the output states at the end of the integration, which is its high-water mark since they only grow
+             */
+            std::size_t history_bytes;
+            /**
+             * @brief setup_time wall-clock time in seconds spent before the first step
+             */
+            double setup_time;
+            /**
+             * @brief stepping_time wall-clock time in seconds spent in the steps, including the observers and the location of events
+             */
+            double stepping_time;
+        };
+
+        /**
+         * @brief The %statistics_store class keeps the statistics of the last integration finished by an integrator, which can be read while other threads integrate with it
+         */
+        class statistics_store
+        {
+
+        public:
+            /**
+             * @brief statistics_store constructor
+             */
+            statistics_store(){}
+
+            /**
+             * @brief statistics_store copy constructor
+             * @param other statistics copied
+             */
+            statistics_store(const statistics_store &other): m_value(other.get()){}
+
+            /**
+             * @brief operator = copies the statistics of another store
+             * @param other statistics copied
+             * @return reference to this store
+             */
+            statistics_store &operator=(const statistics_store &other){
+                if(this != &other)
+                    set(other.get());
+                return *this;
+            }
+
+            /**
+             * @brief get returns the statistics stored last
+             * @return statistics
+             */
+            integration_statistics get() const{
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_value;
+            }
+
+            /**
+             * @brief set stores the statistics of a finished integration
+             * @param[in] value statistics
+             */
+            void set(const integration_statistics &value) const{
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_value = value;
+            }
+
+        private:
+            /**
+             * @brief m_mutex lock of the statistics
+             */
+            mutable std::mutex m_mutex;
+            /**
+             * @brief m_value statistics of the last integration
+             */
+            mutable integration_statistics m_value;
+        };
+
+        /**
+         * @brief The %integration_record class counts the cost of the integration in progress on the calling thread
+         *
+         * A record is opened on entry of each integrate method and closed on exit, when its statistics are copied to the integrator. While it is open, the evaluations and rejected steps of the integrators used internally
+         * (starting method, predictor) and the evaluations of the finite-difference Jacobians are counted in it. A record opened while one of the same integrator is open on the thread (the integrate methods returning a history call the one with an observer) joins it.
+         * A record can also add the cost of the steps of a stepper to its running statistics.
+         */
+        class integration_record
+        {
+
+        public:
+            /**
+             * @brief integration_record constructor opening the record of an integration
+             * @param store statistics of the last integration of the integrator, set when the record is closed
+             */
+            explicit integration_record(const statistics_store &store): m_store(&store), m_total(false), m_parent(current()), m_root(this), m_statistics(&m_local){
+                if((m_parent != NULL) && (m_parent->m_store == m_store))
+                {
+                    m_root = m_parent->m_root;
+                    m_statistics = m_parent->m_statistics;
+                }
+                else
+                    open();
+            }
+
+            /**
+             * @brief integration_record constructor opening a record whose cost is added to running statistics
+             * @param total statistics to which the evaluations, steps and time spent are added
+             */
+            explicit integration_record(integration_statistics &total): m_store(NULL), m_total(true), m_parent(current()), m_root(this), m_statistics(&total){
+                open();
+            }
+
+            integration_record(const integration_record &) = delete;
+            integration_record &operator=(const integration_record &) = delete;
+
+            /**
+             * @brief ~integration_record closes the record, unless it has joined another one
+             */
+            ~integration_record(){
+                if(m_root != this)
+                    return;
+                if(m_total)
+                    m_statistics->stepping_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start_steps).count();
+                current() = m_parent;
+                dynamics::finite_difference_counter() = m_counter;
+                if(m_store != NULL)
+                {
+                    m_store->set(*m_statistics);
+                    last_statistics() = *m_statistics;
+                }
+            }
+
+            /**
+             * @brief statistics returns the statistics being counted
+             * @return reference to the statistics
+             */
+            integration_statistics &statistics() const{
+                return *m_statistics;
+            }
+
+            /**
+             * @brief start_steps records the cost of the setup of the integration, called once before the first step
+             */
+            void start_steps() const{
+                m_root->m_start_steps = std::chrono::steady_clock::now();
+                m_statistics->bootstrap_evaluations = m_statistics->evaluations;
+                m_statistics->setup_time = std::chrono::duration<double>(m_root->m_start_steps - m_root->m_start).count();
+            }
+
+            /**
+             * @brief finish records the number of steps and the time spent in them, called on exit of an integration
+             * @param[in] status exit flag of the integration
+             * @param[in] steps number of steps accepted
+             * @return status
+             */
+            int finish(const int &status, const unsigned long &steps) const{
+                m_statistics->steps_accepted = steps;
+                m_statistics->stepping_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_root->m_start_steps).count();
+                return status;
+            }
+
+            /**
+             * @brief elapsed returns the wall-clock time since the record was opened
+             * @return time in seconds
+             */
+            double elapsed() const{
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_root->m_start).count();
+            }
+
+            /**
+             * @brief active returns the statistics of the record open on the calling thread
+             *
+             * Outside of any record (integration_step() called directly), the cost is counted in statistics of the thread that nobody reads.
+             * @return reference to the statistics
+             */
+            static integration_statistics &active(){
+                static thread_local integration_statistics unrecorded;
+                integration_record *record = current();
+                return (record != NULL) ? *record->m_statistics : unrecorded;
+            }
+
+            /**
+             * @brief last returns the statistics of the last integration finished on the calling thread, by any integrator
+             * @return statistics
+             */
+            static integration_statistics last(){
+                return last_statistics();
+            }
+
+        private:
+            /**
+             * @brief open starts the clock and makes the record the one of the calling thread
+             */
+            void open(){
+                m_start = std::chrono::steady_clock::now();
+                m_start_steps = m_start;
+                m_counter = dynamics::finite_difference_counter();
+                dynamics::finite_difference_counter() = &m_statistics->evaluations;
+                current() = this;
+            }
+
+            /**
+             * @brief current returns the record open on the calling thread (NULL if none)
+             */
+            static integration_record *&current(){
+                static thread_local integration_record *record = NULL;
+                return record;
+            }
+
+            /**
+             * @brief last_statistics returns the statistics of the last integration finished on the calling thread
+             */
+            static integration_statistics &last_statistics(){
+                static thread_local integration_statistics statistics;
+                return statistics;
+            }
+
+            /**
+             * @brief m_store statistics of the integrator (NULL for running statistics)
+             */
+            const statistics_store *m_store;
+            /**
+             * @brief m_total true if the cost is added to running statistics
+             */
+            bool m_total;
+            /**
+             * @brief m_parent record open on the thread before this one
+             */
+            integration_record *m_parent;
+            /**
+             * @brief m_root record holding the clock (this one, or the one it has joined)
+             */
+            integration_record *m_root;
+            /**
+             * @brief m_statistics statistics being counted
+             */
+            integration_statistics *m_statistics;
+            /**
+             * @brief m_local statistics of the integration
+             */
+            integration_statistics m_local;
+            /**
+             * @brief m_counter counter of the finite-difference evaluations before the record was opened
+             */
+            unsigned long *m_counter = NULL;
+            /**
+             * @brief m_start wall-clock time at the opening of the record
+             */
+            std::chrono::steady_clock::time_point m_start;
+            /**
+             * @brief m_start_steps wall-clock time at the beginning of the first step
+             */
+            std::chrono::steady_clock::time_point m_start_steps;
+        };
+
         /**
          * @brief The %base_integrator class is a template abstract class. Any integrator added to the toolbox needs to inherit from it and implement the method integrate()
          *
          * The %base_integrator class is a template abstract class. Any integrator added to the toolbox needs to inherit from it and implement the method that integrates between two given times, with initial state and stepsize
+         * The state type is the one of the dynamics (std::vector<T> by default, see state_traits for fixed-size states).
+         * The type of the dynamics Dyn defaults to the abstract base_dynamics, in which case every evaluation of the dynamics is a virtual call.
+         * If the concrete type is given instead (see static_integrator), the evaluations are resolved at compile time so that the right-hand side can be inlined in the integration step. The dynamics object must then be of exactly that type.
          */
-        template < class T >
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
         class base_integrator
         {
 
         public:
 
+            /**
+             * @brief value_type scalar type of the integrator
+             */
+            typedef T value_type;
+            /**
+             * @brief state_type type of the state vector
+             */
+            typedef State state_type;
+
             /**
              * @brief base_integrator constructor
              *
              * The constructor initializes the name of the integrator and a pointer to the dynamical system to eb integrated
              * @param name integrator name
-             * @param dyn pointer to a base_dynamics object
+             * @param dyn pointer to the dynamics object
              */
-            base_integrator(const std::string &name, const dynamics::base_dynamics<T> *dyn):m_name(name),m_dyn(dyn){}
+            base_integrator(const std::string &name, const Dyn *dyn):m_name(name),m_dyn(dyn){}
 
             /**
              * @brief ~base_integrator deconstructor
              */
             virtual ~base_integrator(){}
 
+            /**
+             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (passing intermediate states to an observer)
+             *
+             * The method implements the scheme to integrate with given initial time,
+             * final time, initial state condition and number of steps (constant stepsize), the state after each step being passed to the observer
+             * @param[in] ti initial time instant
+             * @param[in] tend final time instant
+             * @param[in] nsteps number of integration steps
+             * @param[in] x0 vector of initial states
+             * @param[in,out] observer observer of the intermediate states (including final one)
+             * @return exit flag (see integration_status)
+             */
+            virtual int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer) const = 0;
+
             /**
              * @brief integrate method to integrate between two given time steps, initial condition and number of steps (saving intermediate states)
              *
              * The method implements the scheme to integrate with given initial time,
-             * final time, initial state condition and number of steps (constant stepsize) returning the full history of propagation
+             * final time, initial state condition and number of steps (constant stepsize) returning the history of propagation selected by the recording policy (see set_recording)
              * @param[in] ti initial time instant
              * @param[in] tend final time instant
              * @param[in] nsteps number of integration steps
              * @param[in] x0 vector of initial states
              * @param[out] x_history vector of intermediate state vector (including final one)
              * @param[out] t_history vector of intermediate times (including final one)
-             * @return
+             * @return exit flag (see integration_status)
              */
-            virtual int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history)  const = 0;
-            
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, state_history<State> &x_history, std::vector<double> &t_history) const{
+
+                history_observer<T, State> observer(x_history, t_history, m_recording);
+
+                integration_record record(m_statistics);
+                int status = integrate(ti, tend, nsteps, x0, observer);
+                record.statistics().history_bytes = history_memory(x_history) + t_history.capacity() * sizeof(double);
+
+                return status;
+            }
+
+            /**
+             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (returning the states at requested times)
+             *
+             * The states at the requested times inside a step are computed with a step of the method from the beginning of that step, which costs one step per output time and keeps the accuracy of the integration.
+             * Integrators without such a step (see dense_step()) interpolate them with cubic Hermite polynomials, of order four only.
+             * The steps are not constrained by the output times and no history is stored.
+             * @param[in] ti initial time instant
+             * @param[in] tend final time instant
+             * @param[in] nsteps number of integration steps
+             * @param[in] x0 vector of initial states
+             * @param[in] t_eval output times, sorted in the direction of integration between ti and tend
+             * @param[out] x_eval vector of states at the output times (only the ones reached if the integration was stopped before tend)
+             * @return exit flag (see integration_status)
+             */
+            virtual int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, const std::vector<double> &t_eval, state_history<State> &x_eval) const{
+
+                check_output_times(ti, tend, t_eval);
+                dense_observer observer(this, t_eval, x_eval);
+
+                integration_record record(m_statistics);
+                int status = integrate(ti, tend, nsteps, x0, observer);
+                if(status == INTEGRATION_SUCCESS)
+                    observer.complete();
+                record.statistics().history_bytes = history_memory(x_eval);
+
+                return status;
+            }
+
             /**
              * @brief integrate method to integrate from initial conditions to a final time with a given number of steps
              *
@@ -69,19 +472,14 @@ namespace smartmath
              * @param[in] tend final time instant
              * @param[in] nsteps number of integration steps
              * @param[in] x0 vector of initial states
-             * @param[out] xfinal vector of final states
-             * @return
+             * @param[out] xfinal vector of final states (last accepted state if the integration was stopped by a limit)
+             * @return exit flag (see integration_status)
              */
-            int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<T> &xfinal) const{
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, State &xfinal) const{
 
-                std::vector<std::vector<T> > x_history;
-                std::vector<double> t_history;
+                final_observer<T, State> observer(xfinal);
 
-                integrate(ti, tend, nsteps, x0, x_history, t_history);
-
-                xfinal = x_history.back();
-
-                return 0;
+                return integrate(ti, tend, nsteps, x0, observer);
             }
 
             /**
@@ -105,6 +503,61 @@ namespace smartmath
                 m_comments = status;
             }
 
+            /**
+             * @brief set_limits sets the budget of the next integrations
+             *
+             * The limits apply to each integration separately, including the ones run at the same time by several threads.
+             * @param[in] limits maximum wall-clock time, number of evaluations and of steps and cancellation token
+             */
+            void set_limits(const integration_limits &limits)
+            {
+                m_limits = limits;
+                m_limited = (limits.max_wall_time > 0.0) || (limits.max_evaluations > 0) || (limits.max_steps > 0) || (limits.cancel != NULL);
+            }
+
+            /**
+             * @brief get_limits returns the budget of the integrations
+             * @return limits
+             */
+            integration_limits get_limits() const
+            {
+                return m_limits;
+            }
+
+            /**
+             * @brief set_recording sets the policy selecting the states kept by the integrate methods returning a history
+             * @param[in] policy recording policy (stride, minimum time interval, states at events only or final state only)
+             */
+            void set_recording(const recording_policy &policy)
+            {
+                if(policy.stride == 0)
+                    smartmath_throw(m_name + ": the recording stride needs to be positive");
+                if(policy.min_interval < 0.0)
+                    smartmath_throw(m_name + ": the minimum recording interval needs to be non-negative");
+                m_recording = policy;
+            }
+
+            /**
+             * @brief get_recording returns the policy selecting the states kept in the history
+             * @return recording policy
+             */
+            recording_policy get_recording() const
+            {
+                return m_recording;
+            }
+
+            /**
+             * @brief get_statistics returns the cost of the last integration
+             *
+             * The statistics are set when an integrate method returns (or throws). If the integrator is used by several threads at once, they are the ones of the last integration finished by any of them:
+             * integration_record::last() returns the ones of the last integration finished on the calling thread instead. The steppers count their own statistics.
+             * @return statistics
+             */
+            integration_statistics get_statistics() const
+            {
+                return m_statistics.get();
+            }
+
 
         protected:
             /**
@@ -112,14 +565,299 @@ namespace smartmath
              */
             std::string m_name;
             /**
-             * @brief m_dyn pointer to a base_dynamics system to be integrated
+             * @brief m_dyn pointer to the dynamical system to be integrated
              */
-            const dynamics::base_dynamics<T> *m_dyn;
+            const Dyn *m_dyn;
             /**
              * @brief m_comments status for comment printing
              */
             bool m_comments = true;
+            /**
+             * @brief m_limits budget of the integrations
+             */
+            integration_limits m_limits;
+            /**
+             * @brief m_limited true if at least one limit is set
+             */
+            bool m_limited = false;
+            /**
+             * @brief m_recording policy selecting the states kept in the history
+             */
+            recording_policy m_recording;
+            /**
+             * @brief m_statistics cost of the last integration
+             */
+            statistics_store m_statistics;
+
+            /**
+             * @brief evaluate evaluates the dynamics at a given instant of time and a given state
+             *
+             * All the evaluations of the dynamics made by the integrators go through this method. The call is virtual unless the concrete type of the dynamics is known.
+             * @param[in] t time
+             * @param[in] x state at time t
+             * @param[out] dx derivative of the state at time t
+             * @return exit flag (0=success)
+             */
+            int evaluate(const double &t, const State &x, State &dx) const{
+                SMARTMATH_TRACE_SCOPE("evaluate");
+                statistics().evaluations++;
+                return dispatch_evaluate(t, x, dx, typename std::is_abstract<Dyn>::type());
+            }
+
+            /**
+             * @brief derivative evaluates the time derivative of the state used to interpolate between the steps when dense_step() is not available
+             * @param[in] t time
+             * @param[in] x state at time t
+             * @param[out] dx derivative of the state at time t
+             * @return exit flag (0=success)
+             */
+            virtual int derivative(const double &t, const State &x, State &dx) const{
+                return evaluate(t, x, dx);
+            }
+
+            /**
+             * @brief dense_step performs one step of the method from a given state, used to compute the states at the output times inside a step
+             *
+             * Taken from the beginning of the step containing the output time, the shorter step has a local error bounded by the one of the step itself.
+             * The integrators not overriding it are interpolated with cubic Hermite polynomials instead.
+             * @param[in] t initial time of the step
+             * @param[in] h step-size
+             * @param[in] x vector of states at time t
+             * @param[out] xh vector of states at time t + h
+             * @return true if the step has been performed
+             */
+            virtual bool dense_step(const double &t, const double &h, const State &x, State &xh) const{
+                return false;
+            }
+
+            /**
+             * @brief check_output_times checks that the output times are sorted in the direction of integration and lie between the initial and final times
+             * @param[in] ti initial time
+             * @param[in] tend final time
+             * @param[in] t_eval output times
+             */
+            void check_output_times(const double &ti, const double &tend, const std::vector<double> &t_eval) const{
+                double previous = ti;
+                for(unsigned int i = 0; i < t_eval.size(); i++)
+                {
+                    if((t_eval[i] - previous) * (tend - ti) < 0.0)
+                        smartmath_throw(m_name + ": output times need to be sorted in the direction of integration and to start after the initial time");
+                    previous = t_eval[i];
+                }
+                if((t_eval.size() > 0) && ((tend - previous) * (tend - ti) < 0.0))
+                    smartmath_throw(m_name + ": output times need to end before the final time");
+            }
+
+            /**
+             * @brief The %dense_observer class fills the states at requested output times lying inside the steps with a step of the method from the beginning of the step
+             *
+             * An output time strictly inside a step costs one step of the method (see dense_step()), so the states keep the accuracy of the integration.
+             * For the integrators without dense_step(), they are interpolated with cubic Hermite polynomials, whose error is of order four whatever the order of the method:
+             * the derivatives at the ends of a step are then only evaluated if an output time lies strictly inside the step, and the one at the end is kept for the next step.
+             */
+            class dense_observer: public base_observer<T, State>
+            {
+
+            public:
+                /**
+                 * @brief dense_observer constructor
+                 * @param integrator integrator providing the derivatives
+                 * @param t_eval output times, sorted in the direction of integration
+                 * @param x_eval vector of states at the output times to be filled
+                 */
+                dense_observer(const base_integrator *integrator, const std::vector<double> &t_eval, state_history<State> &x_eval): m_integrator(integrator), m_t_eval(t_eval), m_x_eval(x_eval), m_next(0), m_t(0.0), m_fresh(false){}
+
+                /**
+                 * @brief start stores the initial conditions and fills the output times equal to the initial time
+                 * @param[in] t0 initial time instant
+                 * @param[in] x0 vector of initial states
+                 */
+                void start(const double &t0, const State &x0){
+                    m_x_eval.clear();
+                    m_next = 0;
+                    m_t = t0;
+                    m_x = x0;
+                    m_f0 = x0;
+                    m_f1 = x0;
+                    m_xe = x0;
+                    m_fresh = false;
+                    while((m_next < m_t_eval.size()) && (m_t_eval[m_next] == t0))
+                    {
+                        m_x_eval.push_back(x0);
+                        m_next++;
+                    }
+                }
+
+                /**
+                 * @brief observe fills the output times lying in the last step
+                 * @param[in] t time at the end of the step
+                 * @param[in] x vector of states at time t
+                 */
+                void observe(const double &t, const State &x){
+
+                    bool interpolated = false;
+                    const double h = t - m_t;
+                    while((m_next < m_t_eval.size()) && ((m_t_eval[m_next] - t) * h <= 0.0))
+                    {
+                        if(m_t_eval[m_next] == t)
+                            m_x_eval.push_back(x);
+                        else if(m_integrator->dense_step(m_t, m_t_eval[m_next] - m_t, m_x, m_xe))
+                            m_x_eval.push_back(m_xe);
+                        else
+                        {
+                            if(!interpolated)
+                            {
+                                if(!m_fresh)
+                                    m_integrator->derivative(m_t, m_x, m_f0);
+                                m_integrator->derivative(t, x, m_f1);
+                                interpolated = true;
+                            }
+
+                            /* cubic Hermite basis */
+                            const double s = (m_t_eval[m_next] - m_t) / h, s2 = s * s, s3 = s2 * s;
+                            const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0, h10 = s3 - 2.0 * s2 + s, h01 = 3.0 * s2 - 2.0 * s3, h11 = s3 - s2;
+                            for(unsigned int i = 0; i < m_xe.size(); i++)
+                                m_xe[i] = h00 * m_x[i] + h01 * x[i] + h * (h10 * m_f0[i] + h11 * m_f1[i]);
+                            m_x_eval.push_back(m_xe);
+                        }
+                        m_next++;
+                    }
+
+                    m_fresh = interpolated;
+                    if(interpolated)
+                        std::swap(m_f0, m_f1);
+                    m_t = t;
+                    m_x = x;
+                }
+
+                /**
+                 * @brief complete fills the output times left at the end of an integration that reached its final time, which differ from the last time by round-off only
+                 */
+                void complete(){
+                    for(; m_next < m_t_eval.size(); m_next++)
+                        m_x_eval.push_back(m_x);
+                }
+
+            private:
+                /**
+                 * @brief m_integrator integrator providing the derivatives
+                 */
+                const base_integrator *m_integrator;
+                /**
+                 * @brief m_t_eval output times
+                 */
+                const std::vector<double> &m_t_eval;
+                /**
+                 * @brief m_x_eval states at the output times
+                 */
+                state_history<State> &m_x_eval;
+                /**
+                 * @brief m_next index of the next output time
+                 */
+                unsigned int m_next;
+                /**
+                 * @brief m_t time at the end of the last step
+                 */
+                double m_t;
+                /**
+                 * @brief m_x state at the end of the last step
+                 */
+                State m_x;
+                /**
+                 * @brief m_f0, m_f1 derivatives at the beginning and at the end of the step
+                 */
+                State m_f0, m_f1;
+                /**
+                 * @brief m_xe state at an output time
+                 */
+                State m_xe;
+                /**
+                 * @brief m_fresh true if the derivative at the end of the last step has been evaluated
+                 */
+                bool m_fresh;
+            };
+
+            /**
+             * @brief check_entry checks the inputs of an integration against the dynamics at both ends of the time interval
+             *
+             * Called once by the integrate methods, it does nothing if SMARTMATH_CHECK_LEVEL is SMARTMATH_CHECK_NONE.
+             * @param[in] ti initial time
+             * @param[in] tend final time
+             * @param[in] x0 initial state
+             */
+            void check_entry(const double &ti, const double &tend, const State &x0) const{
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_ENTRY
+                if(m_dyn != NULL)
+                {
+                    m_dyn->check_input(ti, x0);
+                    m_dyn->check_input(tend, x0);
+                }
+#endif
+            }
+
+            /**
+             * @brief statistics returns the statistics in which the cost of this integrator is counted
+             * @return statistics of the record open on the calling thread
+             */
+            integration_statistics &statistics() const{
+                return integration_record::active();
+            }
+
+            /**
+             * @brief history_memory computes the memory held by a sequence of states
+             * @param[in] x_history sequence of states
+             * @return number of bytes
+             */
+            std::size_t history_memory(const state_history<State> &x_history) const{
+                std::size_t bytes = x_history.capacity() * sizeof(State);
+                if((state_traits<State>::dimension < 0) && !x_history.empty())
+                    bytes += x_history.size() * x_history[0].size() * sizeof(T);
+                return bytes;
+            }
+
+            /**
+             * @brief check_limits checks the budget of the integration, called before each step
+             * @param[in] record record of the integration
+             * @param[in] steps number of steps accepted so far
+             * @return INTEGRATION_SUCCESS if the integration can go on, the limit reached otherwise
+             */
+            int check_limits(const integration_record &record, const unsigned long &steps) const{
+                if(!m_limited)
+                    return INTEGRATION_SUCCESS;
+                if((m_limits.cancel != NULL) && m_limits.cancel->load(std::memory_order_relaxed))
+                    return INTEGRATION_CANCELLED;
+                if((m_limits.max_steps > 0) && (steps >= m_limits.max_steps))
+                    return INTEGRATION_STEP_LIMIT;
+                if((m_limits.max_evaluations > 0) && (record.statistics().evaluations >= m_limits.max_evaluations))
+                    return INTEGRATION_EVALUATION_LIMIT;
+                if((m_limits.max_wall_time > 0.0) && (record.elapsed() >= m_limits.max_wall_time))
+                    return INTEGRATION_TIME_LIMIT;
+                return INTEGRATION_SUCCESS;
+            }
+
+        private:
+            /**
+             * @brief dispatch_evaluate virtual call to the dynamics
+             */
+            int dispatch_evaluate(const double &t, const State &x, State &dx, std::true_type) const{
+                return m_dyn->evaluate(t, x, dx);
+            }
+
+            /**
+             * @brief dispatch_evaluate call to the dynamics resolved at compile time
+             */
+            int dispatch_evaluate(const double &t, const State &x, State &dx, std::false_type) const{
+                return m_dyn->Dyn::evaluate(t, x, dx);
+            }
         };
+
+        /**
+         * @brief static_integrator integrator of a given family specialised on the concrete type of the dynamics
+         *
+         * For instance static_integrator<rk4, dynamics::vanderpol<double> > is rk4<double, std::vector<double>, dynamics::vanderpol<double> >.
+         */
+        template < template < class, class, class > class Integrator, class Dyn >
+        using static_integrator = Integrator<typename Dyn::value_type, typename Dyn::state_type, Dyn>;
     }
 }
 
@@ -22,13 +22,14 @@ namespace smartmath
          *
          * The %base_multistep class is a template abstract class. Any fixed-size, fixed order multistep integrator added to the toolbox needs to inherit from it and implement the methods integration_step() and initialize() 
          */
-        template < class T >
-        class base_multistep: public base_integrator<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class base_multistep: public base_integrator<T, State, Dyn>
         {
 
         protected:
-            using base_integrator<T>::m_name;
-            using base_integrator<T>::m_dyn;
+            using base_integrator<T, State, Dyn>::m_name;
+            using base_integrator<T, State, Dyn>::m_dyn;
+            using base_integrator<T, State, Dyn>::evaluate;
             /**
              * @brief m_order order of the multistep integrator
              */
@@ -36,7 +37,7 @@ namespace smartmath
 
         public:
 
-            using base_integrator<T>::integrate;
+            using base_integrator<T, State, Dyn>::integrate;
 
             /**
              * @brief base_multistep constructor
@@ -46,7 +47,7 @@ namespace smartmath
              * @param dyn pointer to a base_dynamics object
              * @param order number of saved steps
              */
-            base_multistep(const std::string &name, const dynamics::base_dynamics<T> *dyn, const unsigned int &order) : base_integrator<T>(name, dyn), m_order(order){}
+            base_multistep(const std::string &name, const Dyn *dyn, const unsigned int &order) : base_integrator<T, State, Dyn>(name, dyn), m_order(order){}
 
             /**
              * @brief ~base_multistep deconstructor
@@ -66,10 +67,10 @@ namespace smartmath
              * @param[out] xfinal vector of final states
              * @return
              */
-            virtual int integration_step(const double &t, const unsigned int &m, const double &h, const std::vector<T> &x0, std::vector<std::vector<T> > &f, std::vector<T> &xfinal) const=0;
+            virtual int integration_step(const double &t, const unsigned int &m, const double &h, const State &x0, state_history<State> &f, State &xfinal) const=0;
 
             /**
-             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (saving intermediate states)
+             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (passing intermediate states to an observer)
              *
              * The method implements a multistep scheme to integrate with given initial time,
              * final time, initial state condition and number of steps (constant stepsize)
@@ -77,33 +78,48 @@ namespace smartmath
              * @param[in] tend final time instant
              * @param[in] nsteps number of integration steps
              * @param[in] x0 vector of initial states
-             * @param[out] x_history vector of intermediate state vector (including final one)
-             * @param[out] t_history vector of intermediate times (including final one)
-             * @return
+             * @param[in,out] observer observer of the intermediate states (including final one)
+             * @return exit flag (see integration_status)
              */
-            int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history) const{
-    
-                t_history.clear();
-                x_history.clear();
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer) const{
+
+                this->check_entry(ti, tend, x0);
+                SMARTMATH_TRACE_SCOPE("integrate");
+                integration_record record(this->m_statistics);
 
-                std::vector<T> x(x0), xp(x0);
-                std::vector<std::vector<T> > f;
+                observer.start(ti, x0);
+
+                State x(x0), xp(x0);
+                state_history<State> f;
                 double t = ti, h = (tend - ti) / double(nsteps);
 
                 initialize(m_order, ti, h, x0, f);
 
+                record.start_steps();
                 for(int k = 0; k < nsteps; k++)
                 {
-                    integration_step(t, m_order, h, x, f, xp);
+                    SMARTMATH_TRACE_SCOPE("step");
+                    int status = this->check_limits(record, k);
+                    if(status != INTEGRATION_SUCCESS)
+                    {
+                        observer.finish(t, x);
+                        return record.finish(status, k);
+                    }
+
+                    {
+                        /* temporaries of the step drawn from the arena of the thread for states using step_allocator */
+                        step_scope scope;
+                        integration_step(t, m_order, h, x, f, xp);
+                    }
 
                     /* Saving states */
                     t += h;
                     x = xp;
-                    t_history.push_back(t);
-                    x_history.push_back(x);
+                    observer.observe(t, x);
                 }
 
-                return 0;
+                observer.finish(t, x);
+                return record.finish(0, nsteps);
             }
 
             /**
@@ -117,7 +133,15 @@ namespace smartmath
              * @param[out] f vector of saved state vectors for multistep scheme
              * @return
              */     
-            virtual  int initialize(const unsigned int &m, const double &ti, const double &h, const std::vector<T> &x0, std::vector<std::vector<T> > &f) const = 0;
+            virtual  int initialize(const unsigned int &m, const double &ti, const double &h, const State &x0, state_history<State> &f) const = 0;
+
+            /**
+             * @brief get_order returns the number of saved steps of the multistep scheme
+             * @return order
+             */
+            unsigned int get_order() const{
+                return m_order;
+            }
 
         };
 
@@ -0,0 +1,254 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_BASE_OBSERVER_H
+#define SMARTMATH_BASE_OBSERVER_H
+
+#include <vector>
+#include <cmath>
+#include "../exception.h"
+#include "../Utils/state_traits.h"
+#include "../Utils/trace.h"
+
+namespace smartmath
+{
+    namespace integrator {
+
+        /**
+         * @brief The %base_observer class is a template abstract class receiving the states computed by an integrator
+         *
+         * The integrators call start() with the initial conditions and then observe() after each accepted step, so that the states can be used on the fly instead of being stored in a history.
+         */
+        template < class T, class State = std::vector<T> >
+        class base_observer
+        {
+
+        public:
+            /**
+             * @brief ~base_observer deconstructor
+             */
+            virtual ~base_observer(){}
+
+            /**
+             * @brief start is called once with the initial conditions of the integration
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             */
+            virtual void start(const double &t0, const State &x0){}
+
+            /**
+             * @brief observe is called after each accepted step
+             * @param[in] t time at the end of the step
+             * @param[in] x vector of states at time t
+             */
+            virtual void observe(const double &t, const State &x) = 0;
+
+            /**
+             * @brief event is called instead of observe() for a state at which the integration is stopped by an event
+             * @param[in] t time of the event
+             * @param[in] x vector of states at time t
+             */
+            virtual void event(const double &t, const State &x){
+                observe(t, x);
+            }
+
+            /**
+             * @brief finish is called once at the end of the integration, also when it is stopped by a limit, with the last state passed to observe() or event() (the initial one if none)
+             * @param[in] t final time
+             * @param[in] x vector of final states
+             */
+            virtual void finish(const double &t, const State &x){}
+        };
+
+        /**
+         * @brief The %recording_policy struct selects the states kept in the history of an integration
+         *
+         * By default every step is recorded. A step is recorded if it is a multiple of stride and if at least min_interval has elapsed since the last recorded state.
+         * The final state is always recorded, except with events_only where only the states at events are. final_only keeps the final state only.
+         */
+        struct recording_policy
+        {
+            recording_policy(): stride(1), min_interval(0.0), events_only(false), final_only(false){}
+
+            /**
+             * @brief stride number of steps between two recorded states
+             */
+            unsigned int stride;
+            /**
+             * @brief min_interval minimum time between two recorded states
+             */
+            double min_interval;
+            /**
+             * @brief events_only true to record the states at events only
+             */
+            bool events_only;
+            /**
+             * @brief final_only true to record the final state only
+             */
+            bool final_only;
+        };
+
+        /**
+         * @brief The %history_observer class stores the states computed by an integrator according to a recording policy
+         *
+         * The initial state is not stored, as for the integrate methods returning a history. The states discarded by the policy are never appended nor copied:
+         * the final state is recorded from the one passed to finish() by the integrator if the policy has discarded it.
+         */
+        template < class T, class State = std::vector<T> >
+        class history_observer: public base_observer<T, State>
+        {
+
+        public:
+            /**
+             * @brief history_observer constructor
+             * @param x_history vector of states to be filled, which needs to outlive the observer
+             * @param t_history vector of times to be filled, which needs to outlive the observer
+             * @param policy recording policy
+             */
+            history_observer(state_history<State> &x_history, std::vector<double> &t_history, const recording_policy &policy = recording_policy()):
+                m_x_history(x_history), m_t_history(t_history), m_policy(policy), m_steps(0), m_t_recorded(0.0), m_pending(false){
+                if(policy.stride == 0)
+                    smartmath_throw("HISTORY_OBSERVER: the recording stride needs to be positive");
+                if(policy.min_interval < 0.0)
+                    smartmath_throw("HISTORY_OBSERVER: the minimum recording interval needs to be non-negative");
+            }
+
+            /**
+             * @brief start empties the history
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             */
+            void start(const double &t0, const State &x0){
+                m_x_history.clear();
+                m_t_history.clear();
+                m_steps = 0;
+                m_t_recorded = t0;
+                m_pending = false;
+            }
+
+            /**
+             * @brief observe appends a state to the history if the recording policy selects it
+             * @param[in] t time at the end of the step
+             * @param[in] x vector of states at time t
+             */
+            void observe(const double &t, const State &x){
+                m_steps++;
+                if(!m_policy.events_only && !m_policy.final_only && (m_steps % m_policy.stride == 0) && (fabs(t - m_t_recorded) >= m_policy.min_interval))
+                {
+                    record(t, x);
+                    return;
+                }
+                if(!m_policy.events_only)
+                    m_pending = true;
+            }
+
+            /**
+             * @brief event appends the state at an event to the history
+             * @param[in] t time of the event
+             * @param[in] x vector of states at time t
+             */
+            void event(const double &t, const State &x){
+                m_steps++;
+                record(t, x);
+            }
+
+            /**
+             * @brief finish records the final state if it has been discarded by the policy
+             * @param[in] t final time
+             * @param[in] x vector of final states
+             */
+            void finish(const double &t, const State &x){
+                if(m_pending)
+                    record(t, x);
+            }
+
+        private:
+            /**
+             * @brief record appends a state to the history
+             * @param[in] t time
+             * @param[in] x vector of states at time t
+             */
+            void record(const double &t, const State &x){
+                SMARTMATH_TRACE_SCOPE("record");
+                m_t_history.push_back(t);
+                m_x_history.push_back(x);
+                m_t_recorded = t;
+                m_pending = false;
+            }
+
+            /**
+             * @brief m_x_history history of states
+             */
+            state_history<State> &m_x_history;
+            /**
+             * @brief m_t_history history of times
+             */
+            std::vector<double> &m_t_history;
+            /**
+             * @brief m_policy recording policy
+             */
+            recording_policy m_policy;
+            /**
+             * @brief m_steps number of observed steps
+             */
+            unsigned long m_steps;
+            /**
+             * @brief m_t_recorded time of the last recorded state
+             */
+            double m_t_recorded;
+            /**
+             * @brief m_pending true if the last observed state has been discarded
+             */
+            bool m_pending;
+        };
+
+        /**
+         * @brief The %final_observer class keeps the final state of an integration only
+         */
+        template < class T, class State = std::vector<T> >
+        class final_observer: public base_observer<T, State>
+        {
+
+        public:
+            /**
+             * @brief final_observer constructor
+             * @param xfinal final state to be filled, which needs to outlive the observer
+             */
+            final_observer(State &xfinal): m_xfinal(xfinal){}
+
+            /**
+             * @brief start sets the final state to the initial one in case no step is performed
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             */
+            void start(const double &t0, const State &x0){
+                m_xfinal = x0;
+            }
+
+            /**
+             * @brief observe overwrites the final state
+             * @param[in] t time at the end of the step
+             * @param[in] x vector of states at time t
+             */
+            void observe(const double &t, const State &x){
+                m_xfinal = x;
+            }
+
+        private:
+            /**
+             * @brief m_xfinal final state
+             */
+            State &m_xfinal;
+        };
+
+    }
+}
+
+#endif // SMARTMATH_BASE_OBSERVER_H
@@ -22,13 +22,14 @@ namespace smartmath
          *
          * The %base_rungekutta class is a template abstract class. Any fixed-step Runge-Kutta algorithm added to the toolbox needs to inherit from it and implement the method that performs on integration step between to given times given the initial state
          */
-        template < class T >
-        class base_rungekutta: public base_integrator<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class base_rungekutta: public base_integrator<T, State, Dyn>
         {
 
         protected:
-            using base_integrator<T>::m_name;
-            using base_integrator<T>::m_dyn;
+            using base_integrator<T, State, Dyn>::m_name;
+            using base_integrator<T, State, Dyn>::m_dyn;
+            using base_integrator<T, State, Dyn>::evaluate;
             /**
              * @brief m_stages number of stages
              */            
@@ -48,7 +49,7 @@ namespace smartmath
 
         public:
 
-            using base_integrator<T>::integrate;
+            using base_integrator<T, State, Dyn>::integrate;
 
             /**
              * @brief base_rungekutta constructor
@@ -57,7 +58,7 @@ namespace smartmath
              * @param name integrator name
              * @param dyn pointer to a base_dynamics object
              */
-            base_rungekutta(const std::string &name, const dynamics::base_dynamics<T> *dyn) : base_integrator<T>(name, dyn){}
+            base_rungekutta(const std::string &name, const Dyn *dyn) : base_integrator<T, State, Dyn>(name, dyn){}
 
             /**
              * @brief ~base_rungekutta deconstructor
@@ -77,10 +78,9 @@ namespace smartmath
              * @param[out] xfinal vector of final states
              * @return
              */
-            int integration_step(const double &ti, const double &h, const std::vector<T> &x0, std::vector<T> &xfinal) const{
+            int integration_step(const double &ti, const double &h, const State &x0, State &xfinal) const{
 
-                std::vector<T> x_temp = x0, k = x0;
-                unsigned int l = x0.size();
+                State x_temp = x0, k = x0;
 
                 xfinal = x0;
 
@@ -89,17 +89,14 @@ namespace smartmath
                     x_temp = x0;
                     if(i == 0)
                     {
-                        m_dyn->evaluate(ti + h * m_coeT[i], x_temp, k);
-                        for(unsigned int j = 0; j < l; j++)
-                            xfinal[j] += m_coeX[i] * k[j] * h;
+                        evaluate(ti + h * m_coeT[i], x_temp, k);
+                        state_traits<State>::axpy(xfinal, m_coeX[i] * h, k);
                     }
                     else
                     { 
-                        for(unsigned int j = 0; j < l; j++)
-                            x_temp[j] += m_coeK[i - 1] * k[j] * h;    
-                        m_dyn->evaluate(ti + h * m_coeT[i], x_temp, k);
-                        for(unsigned int j = 0; j < l; j++)
-                            xfinal[j] += m_coeX[i] * k[j] * h;        
+                        state_traits<State>::axpy(x_temp, m_coeK[i - 1] * h, k);
+                        evaluate(ti + h * m_coeT[i], x_temp, k);
+                        state_traits<State>::axpy(xfinal, m_coeX[i] * h, k);
                     }
                 }              
 
@@ -107,7 +104,7 @@ namespace smartmath
             }
 
             /**
-             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (saving intermediate states)
+             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (passing intermediate states to an observer)
              *
              * The method implements a fixed-step Runge-Kutta scheme to integrate with given initial time,
              * final time, initial state condition and number of steps (constant stepsize)
@@ -115,29 +112,58 @@ namespace smartmath
              * @param[in] tend final time instant
              * @param[in] nsteps number of integration steps
              * @param[in] x0 vector of initial states
-             * @param[out] x_history vector of intermediate state vector (including final one)
-             * @param[out] t_history vector of intermediate times (including final one)
-             * @return
+             * @param[in,out] observer observer of the intermediate states (including final one)
+             * @return exit flag (see integration_status)
              */
-            int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history) const{
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer) const{
+
+                this->check_entry(ti, tend, x0);
+                SMARTMATH_TRACE_SCOPE("integrate");
+                integration_record record(this->m_statistics);
 
-                t_history.clear();
-                x_history.clear();
+                observer.start(ti, x0);
 
-                std::vector<T> dx = x0, x = x0, x_temp = x0;
+                State x = x0, x_temp = x0;
 
                 double t = ti, h = (tend - ti) / double(nsteps);
 
+                record.start_steps();
                 for(int i = 0; i < nsteps; i++)
                 {
-                    integration_step(t, h, x, x_temp);
+                    SMARTMATH_TRACE_SCOPE("step");
+                    int status = this->check_limits(record, i);
+                    if(status != INTEGRATION_SUCCESS)
+                    {
+                        observer.finish(t, x);
+                        return record.finish(status, i);
+                    }
+
+                    {
+                        /* temporaries of the step drawn from the arena of the thread for states using step_allocator */
+                        step_scope scope;
+                        integration_step(t, h, x, x_temp);
+                    }
                     t +=h ;
                     x = x_temp;
-                    t_history.push_back(t);
-                    x_history.push_back(x);
+                    observer.observe(t, x);
                 }
 
-                return 0;
+                observer.finish(t, x);
+                return record.finish(0, nsteps);
+            }
+
+        protected:
+            /**
+             * @brief dense_step performs one step of the Runge-Kutta scheme from a given state, used for the states at the output times
+             * @param[in] t initial time of the step
+             * @param[in] h step-size
+             * @param[in] x vector of states at time t
+             * @param[out] xh vector of states at time t + h
+             * @return true
+             */
+            bool dense_step(const double &t, const double &h, const State &x, State &xh) const{
+                integration_step(t, h, x, xh);
+                return true;
             }
 
         };
@@ -61,10 +61,12 @@ namespace smartmath
             int integration_step(const double &ti, const double &tau, const std::vector<T> &q0, const std::vector<T> &p0, std::vector<T> &qf, std::vector<T> &pf) const{
 
                 /* sanity checks */
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
                 if(q0.size() != m_ham->get_dim())
                     smartmath_throw("INTEGRATION_STEP: position vector must have consistent dimension with Hamiltonian system");               
                 if(p0.size() != m_ham->get_dim())
                     smartmath_throw("INTEGRATION_STEP: momentum vector must have consistent dimension with Hamiltonian system");     
+#endif
 
                 unsigned int n = m_ham->get_dim();
                 std::vector<T> q = q0, p = p0, dq = q0, dp = p0;
@@ -95,7 +97,7 @@ namespace smartmath
             }
             
             /**
-             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (saving intermediate states)
+             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (passing intermediate states to an observer)
              *
              * The method implements a fixed-step symplectic scheme to integrate with given initial time,
              * final time, initial state condition and number of steps (constant stepsize)
@@ -103,18 +105,20 @@ namespace smartmath
              * @param[in] tend final time instant
              * @param[in] nsteps number of integration steps
              * @param[in] x0 vector of initial states
-             * @param[out] x_history vector of intermediate state vector (including final one)
-             * @param[out] t_history vector of intermediate times (including final one)
-             * @return
+             * @param[in,out] observer observer of the intermediate states (including final one)
+             * @return exit flag (see integration_status)
              */
-            int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history) const{
+            int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, base_observer<T> &observer) const{
 
                 /* sanity checks */
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_ENTRY
                 if(x0.size() != 2 * m_ham->get_dim())
                     smartmath_throw("INTEGRATE: state vector must have consistent dimension with Hamiltonian system"); 
+#endif
+                SMARTMATH_TRACE_SCOPE("integrate");
+                integration_record record(this->m_statistics);
 
-                t_history.clear();
-                x_history.clear();
+                observer.start(ti, x0);
 
                 double t = ti, h = (tend-ti) / double(nsteps);
 
@@ -131,9 +135,22 @@ namespace smartmath
                 }
                 std::vector<T> q = q0, p = p0;
 
+                record.start_steps();
                 for(int i = 0; i < nsteps; i++)
                 {
-                    integration_step(t, h, q0, p0, q, p);
+                    SMARTMATH_TRACE_SCOPE("step");
+                    int status = this->check_limits(record, i);
+                    if(status != INTEGRATION_SUCCESS)
+                    {
+                        observer.finish(t, x);
+                        return record.finish(status, i);
+                    }
+
+                    {
+                        /* temporaries of the step drawn from the arena of the thread for scalars using step_allocator */
+                        step_scope scope;
+                        integration_step(t, h, q0, p0, q, p);
+                    }
                     t += h;
                     q0 = q;
                     p0 = p;
@@ -142,11 +159,11 @@ namespace smartmath
                         x[j] = q0[j];
                         x[j + n] = p0[j];
                     }                    
-                    t_history.push_back(t);
-                    x_history.push_back(x);
+                    observer.observe(t, x);
                 }
 
-                return 0;
+                observer.finish(t, x);
+                return record.finish(0, nsteps);
             }
 
         protected:
@@ -168,6 +185,27 @@ namespace smartmath
              */
             std::vector<double> m_d;
 
+            /**
+             * @brief dense_step performs one step of the symplectic scheme from a given state, used for the states at the output times
+             * @param[in] t initial time of the step
+             * @param[in] h step-size
+             * @param[in] x vector of states at time t (coordinates followed by momenta)
+             * @param[out] xh vector of states at time t + h
+             * @return true
+             */
+            bool dense_step(const double &t, const double &h, const std::vector<T> &x, std::vector<T> &xh) const{
+                const unsigned int n = m_ham->get_dim();
+                std::vector<T> q0(x.begin(), x.begin() + n), p0(x.begin() + n, x.begin() + 2 * n), q(q0), p(p0);
+                integration_step(t, h, q0, p0, q, p);
+                xh = x;
+                for(unsigned int j = 0; j < n; j++)
+                {
+                    xh[j] = q[j];
+                    xh[j + n] = p[j];
+                }
+                return true;
+            }
+
         };
     }
 }
@@ -22,13 +22,14 @@ namespace smartmath
          *
          * The bulirschstoer class is a fixed-stepsize implementation of the Burlish-Stoer method with polynomial extrapolation and the original Burlish sequence
          */
-        template < class T >
-        class bulirschstoer: public base_integrator<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class bulirschstoer: public base_integrator<T, State, Dyn>
         {
 
         protected:
-            using base_integrator<T>::m_name;
-            using base_integrator<T>::m_dyn;
+            using base_integrator<T, State, Dyn>::m_name;
+            using base_integrator<T, State, Dyn>::m_dyn;
+            using base_integrator<T, State, Dyn>::evaluate;
             /**
              * @brief m_sequence Bulirsch sequence
              */              
@@ -40,7 +41,7 @@ namespace smartmath
 
         public:
 
-            using base_integrator<T>::integrate;
+            using base_integrator<T, State, Dyn>::integrate;
 
             /**
              * @brief bulirschstoer constructor
@@ -49,7 +50,7 @@ namespace smartmath
              * @param dyn pointer to the dynamical system to be integrated
              * @param extrapol size of the extrapolation table (the order equals twice that number)
              */
-            bulirschstoer(const dynamics::base_dynamics<T> *dyn, const unsigned int &extrapol = 7) : base_integrator<T>("Bulirsch-Stoer algorithm", dyn), m_extrapol(extrapol){
+            bulirschstoer(const Dyn *dyn, const unsigned int &extrapol = 7) : base_integrator<T, State, Dyn>("Bulirsch-Stoer algorithm", dyn), m_extrapol(extrapol){
 
                 /* sanity checks */
                 if(m_extrapol < 1)
@@ -86,9 +87,9 @@ namespace smartmath
              * @param[out] xfinal vector of final states
              * @return
              */
-            int integration_step(const double &t, const double &H, const std::vector<T> &x0, std::vector<T> &xfinal) const{
+            int integration_step(const double &t, const double &H, const State &x0, State &xfinal) const{
 
-                std::vector< std::vector<T> > M;
+                state_history<State> M;
                 extrapolation(m_extrapol, H, x0, t, M);
                 xfinal = M[m_extrapol-1];
                 
@@ -96,7 +97,7 @@ namespace smartmath
             }
 
             /**
-             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (saving intermediate states)
+             * @brief integrate method to integrate between two given time steps, initial condition and number of steps (passing intermediate states to an observer)
              *
              * The method implements the multistep scheme to integrate with given initial time,
              * final time, initial state condition and number of steps (constant stepsize)
@@ -104,31 +105,46 @@ namespace smartmath
              * @param[in] tend final time instant
              * @param[in] nsteps number of integration steps
              * @param[in] x0 vector of initial states
-             * @param[out] x_history vector of intermediate state vector (including final one)
-             * @param[out] t_history vector of intermediate times (including final one)
-             * @return
+             * @param[in,out] observer observer of the intermediate states (including final one)
+             * @return exit flag (see integration_status)
              */
-            int integrate(const double &ti, const double &tend, const int &nsteps, const std::vector<T> &x0, std::vector<std::vector<T> > &x_history, std::vector<double> &t_history) const{
-    
-                t_history.clear();
-                x_history.clear();
+            int integrate(const double &ti, const double &tend, const int &nsteps, const State &x0, base_observer<T, State> &observer) const{
+
+                this->check_entry(ti, tend, x0);
+                SMARTMATH_TRACE_SCOPE("integrate");
+                integration_record record(this->m_statistics);
 
-                std::vector<T> x(x0), xp(x0);
+                observer.start(ti, x0);
+
+                State x(x0), xp(x0);
                 double t = ti, H = (tend - ti) / double(nsteps);
 
+                record.start_steps();
                 for(int k = 0; k < nsteps; k++){
 
-                    integration_step(t, H, x, xp);
+                    SMARTMATH_TRACE_SCOPE("step");
+                    int status = this->check_limits(record, k);
+                    if(status != INTEGRATION_SUCCESS)
+                    {
+                        observer.finish(t, x);
+                        return record.finish(status, k);
+                    }
+
+                    {
+                        /* temporaries of the step drawn from the arena of the thread for states using step_allocator */
+                        step_scope scope;
+                        integration_step(t, H, x, xp);
+                    }
 
                     /* Saving states */
                     t += H;
                     x = xp;
-                    t_history.push_back(t);
-                    x_history.push_back(x);
+                    observer.observe(t, x);
 
                 }
 
-                return 0;
+                observer.finish(t, x);
+                return record.finish(0, nsteps);
             }
 
             /**
@@ -142,35 +158,34 @@ namespace smartmath
              * @param[out] eta estimation of the state at t + H
              * @return
              */ 
-            int midpoint(const unsigned int &n, const double &H, const std::vector<T> &y, const double &t, std::vector<T> &eta) const{
+            int midpoint(const unsigned int &n, const double &H, const State &y, const double &t, State &eta) const{
 
                 /* sanity checks */
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
                 if(n < 2)
                     smartmath_throw("MIDPOINT: number of micro-steps needs to be higher or equal to 2"); 
                 if(floor(double(n) / 2.0) != double(n) / 2.0)
                     smartmath_throw("MIDPOINT: number of micro-steps has to be even");                 
+#endif
 
                 unsigned int s = y.size();
-                std::vector<T> f = y, u0 = y, u1 = y;
+                State f = y, u0 = y, u1 = y;
                 double h = H / double(n), h2 = 2.0 * h;
 
-                m_dyn->evaluate(t, y, f);
-                for(unsigned int j = 0; j < s; j++)
-                    u1[j] += h * f[j];
+                evaluate(t, y, f);
+                state_traits<State>::axpy(u1, h, f);
 
-                std::vector<T> u2 = u0;
-                m_dyn->evaluate(t + h, u1, f);
-                for(unsigned int j = 0; j < s; j++)
-                    u2[j] += h2 * f[j];
+                State u2 = u0;
+                evaluate(t + h, u1, f);
+                state_traits<State>::axpy(u2, h2, f);
 
-                std::vector<T> v = y, w = y;
+                State v = y, w = y;
                 for(unsigned int i = 2; i <= n; i++)
                 {
                     v = u2;
                     u2 = u1;
-                    m_dyn->evaluate(t + i * h, v, f);
-                    for(unsigned int j = 0; j < s; j++)
-                        u2[j] += h2 * f[j];
+                    evaluate(t + i * h, v, f);
+                    state_traits<State>::axpy(u2, h2, f);
                     w = u1;
                     u1 = v;
                     u0 = w;
@@ -194,14 +209,16 @@ namespace smartmath
              * @param[out] M last line of extrapolatio table (vector of state vectors)
              * @return
              */ 
-            int extrapolation(const unsigned int &i, const double &H, const std::vector<T> &y, const double &t, std::vector<std::vector<T> > &M) const{
+            int extrapolation(const unsigned int &i, const double &H, const State &y, const double &t, state_history<State> &M) const{
 
                 /* sanity checks */
+#if SMARTMATH_CHECK_LEVEL >= SMARTMATH_CHECK_FULL
                 if(i < 1)
                     smartmath_throw("EXTRAPOLATION: the extrapolation scheme needs to have at least one step"); 
+#endif
                 
                 double aux1, aux2;
-                std::vector<T> eta = y;
+                State eta = y;
                 unsigned int s = y.size();
 
                 midpoint(m_sequence[i-1], H, y, t, eta);
@@ -210,7 +227,7 @@ namespace smartmath
 
                 if(i > 1)
                 {
-                    std::vector<std::vector<T> > Mp;
+                    state_history<State> Mp;
                     extrapolation(i - 1, H, y, t, Mp); // recursive call
 
                     for(unsigned int j = 1; j < i; j++)
@@ -227,6 +244,19 @@ namespace smartmath
                 return 0;
             } 
 
+        protected:
+            /**
+             * @brief dense_step performs one step of the Bulirsch-Stoer method from a given state, used for the states at the output times
+             * @param[in] t initial time of the step
+             * @param[in] h step-size
+             * @param[in] x vector of states at time t
+             * @param[out] xh vector of states at time t + h
+             * @return true
+             */
+            bool dense_step(const double &t, const double &h, const State &x, State &xh) const{
+                integration_step(t, h, x, xh);
+                return true;
+            }
 
         };
 
@@ -0,0 +1,313 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_CHECKPOINT_H
+#define SMARTMATH_CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <type_traits>
+#include <stdint.h>
+#include "../exception.h"
+#include "../Utils/state_traits.h"
+/* Eigen triggers -Wint-in-bool-context with recent GCC */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wint-in-bool-context"
+#endif
+#include "../LinearAlgebra/Eigen/Core"
+#include "../LinearAlgebra/Eigen/Sparse"
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace smartmath
+{
+    namespace integrator {
+
+        /**
+         * @brief The %checkpoint_output class writes the internal state of an integration to a binary checkpoint file
+         *
+         * Values are written with their exact bit patterns, in the byte order of the machine, so that an integration restarted from the file continues bit for bit.
+         * The file is first written under a temporary name and renamed by commit(), so that a run interrupted while writing leaves the previous checkpoint intact.
+         * Only states with arithmetic scalars (float, double, ...) can be written.
+         */
+        class checkpoint_output
+        {
+
+        public:
+            /**
+             * @brief checkpoint_output constructor opening the temporary file and writing the header
+             * @param filename path of the checkpoint file
+             */
+            checkpoint_output(const std::string &filename): m_filename(filename), m_os((filename + ".tmp").c_str(), std::ios::binary | std::ios::trunc){
+                if(!m_os)
+                    smartmath_throw("CHECKPOINT: cannot open " + filename + ".tmp");
+                m_os.write("SMCKPT\0\0", 8);
+                write(uint32_t(1));
+            }
+
+            /**
+             * @brief commit closes the temporary file and replaces the checkpoint file with it
+             */
+            void commit(){
+                m_os.close();
+                if(m_os.fail())
+                    smartmath_throw("CHECKPOINT: cannot write " + m_filename + ".tmp");
+                if(std::rename((m_filename + ".tmp").c_str(), m_filename.c_str()) != 0)
+                    smartmath_throw("CHECKPOINT: cannot replace " + m_filename);
+            }
+
+            /**
+             * @brief write writes a value of arithmetic type
+             * @param[in] v value
+             */
+            template < class V >
+            void write(const V &v){
+                write_scalars(&v, 1);
+            }
+
+            /**
+             * @brief write_string writes a string with its length
+             * @param[in] s string
+             */
+            void write_string(const std::string &s){
+                write(uint64_t(s.size()));
+                m_os.write(s.data(), s.size());
+            }
+
+            /**
+             * @brief write_state writes a state with its dimension
+             * @param[in] x state (std::vector, std::array or Eigen vector)
+             */
+            template < class State >
+            void write_state(const State &x){
+                write(uint64_t(x.size()));
+                write_scalars(x.data(), x.size());
+            }
+
+            /**
+             * @brief write_history writes a sequence of states with its length
+             * @param[in] h sequence of states
+             */
+            template < class History >
+            void write_history(const History &h){
+                write(uint64_t(h.size()));
+                for(unsigned int k = 0; k < h.size(); k++)
+                    write_state(h[k]);
+            }
+
+            /**
+             * @brief write_matrix writes a dense Eigen matrix with its dimensions
+             * @param[in] M matrix
+             */
+            template < class T >
+            void write_matrix(const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &M){
+                write(uint64_t(M.rows()));
+                write(uint64_t(M.cols()));
+                write_scalars(M.data(), M.size());
+            }
+
+            /**
+             * @brief write_matrix writes a sparse Eigen matrix as its dimensions and its non-zero entries
+             * @param[in] M matrix
+             */
+            template < class T >
+            void write_matrix(const Eigen::SparseMatrix<T> &M){
+                write(uint64_t(M.rows()));
+                write(uint64_t(M.cols()));
+                write(uint64_t(M.nonZeros()));
+                for(int k = 0; k < M.outerSize(); k++)
+                {
+                    for(typename Eigen::SparseMatrix<T>::InnerIterator it(M, k); it; ++it)
+                    {
+                        write(uint64_t(it.row()));
+                        write(uint64_t(it.col()));
+                        write(it.value());
+                    }
+                }
+            }
+
+        private:
+            template < class V >
+            typename std::enable_if<std::is_arithmetic<V>::value>::type write_scalars(const V *v, const std::size_t &n){
+                m_os.write(reinterpret_cast<const char *>(v), n * sizeof(V));
+            }
+
+            template < class V >
+            typename std::enable_if<!std::is_arithmetic<V>::value>::type write_scalars(const V *v, const std::size_t &n){
+                smartmath_throw("CHECKPOINT: only states with arithmetic scalars can be saved");
+            }
+
+            /**
+             * @brief m_filename path of the checkpoint file
+             */
+            std::string m_filename;
+            /**
+             * @brief m_os temporary file
+             */
+            std::ofstream m_os;
+        };
+
+        /**
+         * @brief The %checkpoint_input class reads the internal state of an integration from a binary checkpoint file written by %checkpoint_output
+         */
+        class checkpoint_input
+        {
+
+        public:
+            /**
+             * @brief checkpoint_input constructor opening the file and checking its header
+             * @param filename path of the checkpoint file
+             */
+            checkpoint_input(const std::string &filename): m_filename(filename), m_is(filename.c_str(), std::ios::binary){
+                if(!m_is)
+                    smartmath_throw("CHECKPOINT: cannot open " + filename);
+                char magic[8];
+                m_is.read(magic, 8);
+                if(!m_is || std::memcmp(magic, "SMCKPT\0\0", 8) != 0)
+                    smartmath_throw("CHECKPOINT: " + filename + " is not a checkpoint file");
+                if(read<uint32_t>() != 1)
+                    smartmath_throw("CHECKPOINT: " + filename + " has an unsupported version");
+            }
+
+            /**
+             * @brief read reads a value of arithmetic type
+             * @return value
+             */
+            template < class V >
+            V read(){
+                V v;
+                read_scalars(&v, 1);
+                return v;
+            }
+
+            /**
+             * @brief read_string reads a string written with its length
+             * @return string
+             */
+            std::string read_string(){
+                uint64_t n = read<uint64_t>();
+                check_length(n);
+                std::string s(n, ' ');
+                if(n > 0)
+                    m_is.read(&s[0], n);
+                check();
+                return s;
+            }
+
+            /**
+             * @brief read_state reads a state written with its dimension
+             * @param[out] x state (std::vector, std::array or Eigen vector)
+             */
+            template < class State >
+            void read_state(State &x){
+                uint64_t n = read<uint64_t>();
+                check_length(n);
+                state_traits<State>::resize(x, n);
+                read_scalars(x.data(), n);
+            }
+
+            /**
+             * @brief read_history reads a sequence of states written with its length
+             * @param[out] h sequence of states
+             */
+            template < class History >
+            void read_history(History &h){
+                uint64_t n = read<uint64_t>();
+                check_length(n);
+                h.resize(n);
+                for(unsigned int k = 0; k < n; k++)
+                    read_state(h[k]);
+            }
+
+            /**
+             * @brief read_matrix reads a dense Eigen matrix written with its dimensions
+             * @param[out] M matrix
+             */
+            template < class T >
+            void read_matrix(Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &M){
+                uint64_t rows = read<uint64_t>(), cols = read<uint64_t>();
+                check_length(rows);
+                check_length(cols);
+                M.resize(rows, cols);
+                read_scalars(M.data(), M.size());
+            }
+
+            /**
+             * @brief read_matrix reads a sparse Eigen matrix written as its dimensions and its non-zero entries
+             * @param[out] M matrix
+             */
+            template < class T >
+            void read_matrix(Eigen::SparseMatrix<T> &M){
+                uint64_t rows = read<uint64_t>(), cols = read<uint64_t>(), nnz = read<uint64_t>();
+                check_length(rows);
+                check_length(cols);
+                check_length(nnz);
+                std::vector< Eigen::Triplet<T> > entries;
+                entries.reserve(nnz);
+                for(uint64_t k = 0; k < nnz; k++)
+                {
+                    uint64_t i = read<uint64_t>(), j = read<uint64_t>();
+                    T v = read<T>();
+                    if(i >= rows || j >= cols)
+                        smartmath_throw("CHECKPOINT: " + m_filename + " is corrupted");
+                    entries.push_back(Eigen::Triplet<T>(i, j, v));
+                }
+                M.resize(rows, cols);
+                M.setFromTriplets(entries.begin(), entries.end());
+            }
+
+        private:
+            template < class V >
+            typename std::enable_if<std::is_arithmetic<V>::value>::type read_scalars(V *v, const std::size_t &n){
+                m_is.read(reinterpret_cast<char *>(v), n * sizeof(V));
+                check();
+            }
+
+            template < class V >
+            typename std::enable_if<!std::is_arithmetic<V>::value>::type read_scalars(V *v, const std::size_t &n){
+                smartmath_throw("CHECKPOINT: only states with arithmetic scalars can be restored");
+            }
+
+            /**
+             * @brief check throws if the end of the file has been reached
+             */
+            void check(){
+                if(!m_is)
+                    smartmath_throw("CHECKPOINT: " + m_filename + " is truncated");
+            }
+
+            /**
+             * @brief check_length throws if a length read in the file is not plausible
+             * @param[in] n length
+             */
+            void check_length(const uint64_t &n){
+                if(n > (uint64_t(1) << 40))
+                    smartmath_throw("CHECKPOINT: " + m_filename + " is corrupted");
+            }
+
+            /**
+             * @brief m_filename path of the checkpoint file
+             */
+            std::string m_filename;
+            /**
+             * @brief m_is checkpoint file
+             */
+            std::ifstream m_is;
+        };
+
+    }
+}
+
+#endif // SMARTMATH_CHECKPOINT_H
@@ -22,22 +22,22 @@ namespace smartmath
          *
          * The class model the Euler explicit integration scheme
          */
-        template < class T >
-        class euler: public base_rungekutta<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class euler: public base_rungekutta<T, State, Dyn>
         {
 
         private:
-            using base_rungekutta<T>::m_name;
-            using base_rungekutta<T>::m_dyn;
-            using base_rungekutta<T>::m_stages;
-            using base_rungekutta<T>::m_coeT;
-            using base_rungekutta<T>::m_coeK;
-            using base_rungekutta<T>::m_coeX;
+            using base_rungekutta<T, State, Dyn>::m_name;
+            using base_rungekutta<T, State, Dyn>::m_dyn;
+            using base_rungekutta<T, State, Dyn>::evaluate;
+            using base_rungekutta<T, State, Dyn>::m_stages;
+            using base_rungekutta<T, State, Dyn>::m_coeT;
+            using base_rungekutta<T, State, Dyn>::m_coeK;
+            using base_rungekutta<T, State, Dyn>::m_coeX;
 
         public:
 
-            using base_rungekutta<T>::integrate;
-            using base_rungekutta<T>::integrate_eigen;
+            using base_rungekutta<T, State, Dyn>::integrate;
 
             /**
              * @brief euler constructor
@@ -45,7 +45,7 @@ namespace smartmath
              * The integrator is initialized with the super class constructor. No additional parameters are set.
              * @param dyn
              */
-            euler(const dynamics::base_dynamics<T> *dyn): base_rungekutta<T>("Explicit Euler integration scheme", dyn){
+            euler(const Dyn *dyn): base_rungekutta<T, State, Dyn>("Explicit Euler integration scheme", dyn){
 
                 m_stages = 1;
 
@@ -22,22 +22,22 @@ namespace smartmath
          *
          * The class models the Heun second order integration scheme
          */
-        template < class T >
-        class heun: public base_rungekutta<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class heun: public base_rungekutta<T, State, Dyn>
         {
 
         private:
-            using base_rungekutta<T>::m_name;
-            using base_rungekutta<T>::m_dyn;
-            using base_rungekutta<T>::m_stages;
-            using base_rungekutta<T>::m_coeT;
-            using base_rungekutta<T>::m_coeK;
-            using base_rungekutta<T>::m_coeX;
+            using base_rungekutta<T, State, Dyn>::m_name;
+            using base_rungekutta<T, State, Dyn>::m_dyn;
+            using base_rungekutta<T, State, Dyn>::evaluate;
+            using base_rungekutta<T, State, Dyn>::m_stages;
+            using base_rungekutta<T, State, Dyn>::m_coeT;
+            using base_rungekutta<T, State, Dyn>::m_coeK;
+            using base_rungekutta<T, State, Dyn>::m_coeX;
 
         public:
 
-            using base_rungekutta<T>::integrate;
-            using base_rungekutta<T>::integrate_eigen;
+            using base_rungekutta<T, State, Dyn>::integrate;
 
             /**
              * @brief heun constructor
@@ -45,7 +45,7 @@ namespace smartmath
              * The integrator is initialized with the super class constructor. No additional parameters are set.
              * @param dyn
              */
-            heun(const dynamics::base_dynamics<T> *dyn): base_rungekutta<T>("Heun's method of order 2 with fixed step-size", dyn){
+            heun(const Dyn *dyn): base_rungekutta<T, State, Dyn>("Heun's method of order 2 with fixed step-size", dyn){
 
                 m_stages = 2;
 
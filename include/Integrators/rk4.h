@@ -22,21 +22,22 @@ namespace smartmath
          *
          * The class model the Runge Kutta fourth order integration scheme
          */
-        template < class T >
-        class rk4: public base_rungekutta<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class rk4: public base_rungekutta<T, State, Dyn>
         {
 
         private:
-            using base_rungekutta<T>::m_name;
-            using base_rungekutta<T>::m_dyn;
-            using base_rungekutta<T>::m_stages;
-            using base_rungekutta<T>::m_coeT;
-            using base_rungekutta<T>::m_coeK;
-            using base_rungekutta<T>::m_coeX;
+            using base_rungekutta<T, State, Dyn>::m_name;
+            using base_rungekutta<T, State, Dyn>::m_dyn;
+            using base_rungekutta<T, State, Dyn>::evaluate;
+            using base_rungekutta<T, State, Dyn>::m_stages;
+            using base_rungekutta<T, State, Dyn>::m_coeT;
+            using base_rungekutta<T, State, Dyn>::m_coeK;
+            using base_rungekutta<T, State, Dyn>::m_coeX;
 
         public:
 
-            using base_rungekutta<T>::integrate;
+            using base_rungekutta<T, State, Dyn>::integrate;
 
             /**
              * @brief rk4 constructor
@@ -44,7 +45,7 @@ namespace smartmath
              * The integrator is initialized with the super class constructor. No additional parameters are set.
              * @param dyn pointer to dynamical system to be integrated
              */
-            rk4(const dynamics::base_dynamics<T> *dyn) : base_rungekutta<T>("Runge Kutta 4 fixed time-step", dyn){
+            rk4(const Dyn *dyn) : base_rungekutta<T, State, Dyn>("Runge Kutta 4 fixed time-step", dyn){
 
                 m_stages = 4;
 
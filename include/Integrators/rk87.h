@@ -12,6 +12,7 @@
 
 #include "base_embeddedRK.h"
 #include "../exception.h"
+#include "../Utils/state_expression.h"
 
 namespace smartmath
 {
@@ -22,22 +23,23 @@ namespace smartmath
          *
          * The class model the Runge Kutta Felhberg integration scheme
          */
-        template < class T >
-        class rk87: public base_embeddedRK<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class rk87: public base_embeddedRK<T, State, Dyn>
         {
 
         private:
-            using base_embeddedRK<T>::m_name;
-            using base_embeddedRK<T>::m_dyn;
-            using base_embeddedRK<T>::m_tol;
-            using base_embeddedRK<T>::m_multiplier;            
-            using base_embeddedRK<T>::m_control;
-            using base_embeddedRK<T>::m_minstep_events;
-            using base_embeddedRK<T>::m_maxstep_events;
+            using base_embeddedRK<T, State, Dyn>::m_name;
+            using base_embeddedRK<T, State, Dyn>::m_dyn;
+            using base_embeddedRK<T, State, Dyn>::evaluate;
+            using base_embeddedRK<T, State, Dyn>::m_tol;
+            using base_embeddedRK<T, State, Dyn>::m_multiplier;            
+            using base_embeddedRK<T, State, Dyn>::m_control;
+            using base_embeddedRK<T, State, Dyn>::m_minstep_events;
+            using base_embeddedRK<T, State, Dyn>::m_maxstep_events;
 
         public:
         	
-        	using base_embeddedRK<T>::integrate;
+        	using base_embeddedRK<T, State, Dyn>::integrate;
 
             /**
              * @brief rk87 constructor
@@ -48,7 +50,7 @@ namespace smartmath
              * @param minstep_events minimum time step for events detection
              * @param maxstep_events maximum time step for events detection
              */
-            rk87(const dynamics::base_dynamics<T> *dyn, const double tol = 1.0e-7, const double multiplier = 5.0, const double minstep_events = 1.0e-4, const double maxstep_events = 0.0): base_embeddedRK<T>("Runge Kutta 8-7 variable step time", dyn, tol, multiplier, minstep_events, maxstep_events)
+            rk87(const Dyn *dyn, const double tol = 1.0e-7, const double multiplier = 5.0, const double minstep_events = 1.0e-4, const double maxstep_events = 0.0): base_embeddedRK<T, State, Dyn>("Runge Kutta 8-7 variable step time", dyn, tol, multiplier, minstep_events, maxstep_events)
             {
 
                m_control = 8;
@@ -72,12 +74,14 @@ namespace smartmath
              * @param[out] er estimated error 
              * @return
              */
-            int integration_step(const double &t, const unsigned int &m, const double &h, const std::vector<T> &x, const std::vector<std::vector<T> > &f, std::vector<T> &xfinal, T &er) const{
+            int integration_step(const double &t, const unsigned int &m, const double &h, const State &x, const state_history<State> &f, State &xfinal, T &er) const{
 		
 		        unsigned int n = x.size();
-		        std::vector<T> xtemp(x), xbar(x), k1(x), k2(x), k3(x), k4(x), k5(x), k6(x), k7(x), k8(x), k9(x), k10(x), k11(x), k12(x), k13(x);
+		        State xtemp(x), xbar(x), k1(x), k2(x), k3(x), k4(x), k5(x), k6(x), k7(x), k8(x), k9(x), k10(x), k11(x), k12(x), k13(x);
 		        double t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13;
-		        xfinal = x;
+		        
+		        /* the stages are expressions on the states evaluated in one loop each */
+		        const state_terminal<State> X(x), K1(k1), K2(k2), K3(k3), K4(k4), K5(k5), K6(k6), K7(k7), K8(k8), K9(k9), K10(k10), K11(k11), K12(k12), K13(k13);
 
 		        t1 = t;
 		        t2 = t + h / 18.0;
@@ -94,86 +98,72 @@ namespace smartmath
 		        t13 = t + h;
 
 		        //* Evaluate k1 
-		        m_dyn->evaluate(t1, x, k1);
+		        evaluate(t1, x, k1);
 
-		        //* Evaluate k2 
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h/18.0;
-		        m_dyn->evaluate(t2, xtemp, k2);
+		        //* Evaluate k2
+		        state_assign(xtemp, X + h * (1.0 / 18.0 * K1));
+		        evaluate(t2, xtemp, k2);
 
-		        //* Evaluate k3 
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h/48.0+k2[j]*h/16.0;
-		        m_dyn->evaluate(t3, xtemp, k3);
+		        //* Evaluate k3
+		        state_assign(xtemp, X + h * (1.0 / 48.0 * K1 + 1.0 / 16.0 * K2));
+		        evaluate(t3, xtemp, k3);
 
-		        //* Evaluate k4 
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h/32.0+k3[j]*h*3.0/32.0;
-		        m_dyn->evaluate(t4, xtemp, k4);
+		        //* Evaluate k4
+		        state_assign(xtemp, X + h * (1.0 / 32.0 * K1 + 3.0 / 32.0 * K3));
+		        evaluate(t4, xtemp, k4);
 
 		        //* Evaluate k5
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*5.0/16.0-k3[j]*h*75.0/64.0+k4[j]*h*75.0/64.0;
-		        m_dyn->evaluate(t5, xtemp, k5);		
+		        state_assign(xtemp, X + h * (5.0 / 16.0 * K1 - 75.0 / 64.0 * K3 + 75.0 / 64.0 * K4));
+		        evaluate(t5, xtemp, k5);
 
 		        //* Evaluate k6
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*3.0/80.0+k4[j]*h*3.0/16.0+k5[j]*h*3.0/20.0;
-		        m_dyn->evaluate(t6, xtemp, k6);
+		        state_assign(xtemp, X + h * (3.0 / 80.0 * K1 + 3.0 / 16.0 * K4 + 3.0 / 20.0 * K5));
+		        evaluate(t6, xtemp, k6);
 
 		        //* Evaluate k7
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*29443841.0/614563906.0 +k4[j]*h*77736538.0/692538347.0 -k5[j]*h*28693883.0/1125000000.0 +k6[j]*h*23124283.0/1800000000.0;
-		        m_dyn->evaluate(t7, xtemp, k7);
+		        state_assign(xtemp, X + h * (29443841.0 / 614563906.0 * K1 + 77736538.0 / 692538347.0 * K4 - 28693883.0 / 1125000000.0 * K5 + 23124283.0 / 1800000000.0 * K6));
+		        evaluate(t7, xtemp, k7);
 
 		        //* Evaluate k8
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*16016141.0/946692911.0 +k4[j]*h*61564180.0/158732637.0 +k5[j]*h*22789713.0/633445777.0
-		             +k6[j]*h*545815736.0/2771057229.0 -k7[j]*h*180193667.0/1043307555.0;
-		        m_dyn->evaluate(t8, xtemp, k8);
+		        state_assign(xtemp, X + h * (16016141.0 / 946692911.0 * K1 + 61564180.0 / 158732637.0 * K4 + 22789713.0 / 633445777.0 * K5
+		             + 545815736.0 / 2771057229.0 * K6 - 180193667.0 / 1043307555.0 * K7));
+		        evaluate(t8, xtemp, k8);
 
 		        //* Evaluate k9
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*39632708.0/573591083.0 -k4[j]*h*433636366.0/683701615.0 -k5[j]*h*421739975.0/2616292301.0
-		             +k6[j]*h*100302831.0/723423059.0 +k7[j]*h*790204164.0/839813087.0  +k8[j]*h* 800635310.0/3783071287.0;
-		        m_dyn->evaluate(t9, xtemp, k9);
+		        state_assign(xtemp, X + h * (39632708.0 / 573591083.0 * K1 - 433636366.0 / 683701615.0 * K4 - 421739975.0 / 2616292301.0 * K5
+		             + 100302831.0 / 723423059.0 * K6 + 790204164.0 / 839813087.0 * K7 + 800635310.0 / 3783071287.0 * K8));
+		        evaluate(t9, xtemp, k9);
 
 		        //* Evaluate k10
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*246121993.0/1340847787.0 -k4[j]*h*37695042795.0/15268766246.0-k5[j]*h*309121744.0/1061227803.0
-		             -k6[j]*h*12992083.0/490766935.0 +k7[j]*h*6005943493.0/2108947869.0  +k8[j]*h*393006217.0/1396673457.0 +k9[j]*h*123872331.0/1001029789.0;
-		        m_dyn->evaluate(t10, xtemp, k10);
+		        state_assign(xtemp, X + h * (246121993.0 / 1340847787.0 * K1 - 37695042795.0 / 15268766246.0 * K4 - 309121744.0 / 1061227803.0 * K5
+		             - 12992083.0 / 490766935.0 * K6 + 6005943493.0 / 2108947869.0 * K7 + 393006217.0 / 1396673457.0 * K8 + 123872331.0 / 1001029789.0 * K9));
+		        evaluate(t10, xtemp, k10);
 
 		        //* Evaluate k11
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]-k1[j]*h*1028468189.0/846180014.0 +k4[j]*h*8478235783.0/508512852.0  +k5[j]*h*1311729495.0/1432422823.0
-		             -k6[j]*h*10304129995.0/1701304382.0 -k7[j]*h*48777925059.0/3047939560.0  +k8[j]*h*15336726248.0/1032824649.0 -k9[j]*h*45442868181.0/3398467696.0 +k10[j]*h*3065993473.0/597172653.0;
-		        m_dyn->evaluate(t11, xtemp, k11);
+		        state_assign(xtemp, X + h * (-1028468189.0 / 846180014.0 * K1 + 8478235783.0 / 508512852.0 * K4 + 1311729495.0 / 1432422823.0 * K5
+		             - 10304129995.0 / 1701304382.0 * K6 - 48777925059.0 / 3047939560.0 * K7 + 15336726248.0 / 1032824649.0 * K8 - 45442868181.0 / 3398467696.0 * K9 + 3065993473.0 / 597172653.0 * K10));
+		        evaluate(t11, xtemp, k11);
 
 		        //* Evaluate k12
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*185892177.0/718116043.0 -k4[j]*h*3185094517.0/667107341.0-k5[j]*h*477755414.0/1098053517.0
-		             -k6[j]*h*703635378.0/230739211.0 +k7[j]*h*5731566787.0/1027545527.0  +k8[j]*h*5232866602.0/850066563.0 -k9[j]*h*4093664535.0/808688257.0 +k10[j]*h* 3962137247.0/1805957418.0
-		             +k11[j]*h*65686358.0/487910083.0;
-		        m_dyn->evaluate(t12, xtemp, k12);
+		        state_assign(xtemp, X + h * (185892177.0 / 718116043.0 * K1 - 3185094517.0 / 667107341.0 * K4 - 477755414.0 / 1098053517.0 * K5
+		             - 703635378.0 / 230739211.0 * K6 + 5731566787.0 / 1027545527.0 * K7 + 5232866602.0 / 850066563.0 * K8 - 4093664535.0 / 808688257.0 * K9 + 3962137247.0 / 1805957418.0 * K10
+		             + 65686358.0 / 487910083.0 * K11));
+		        evaluate(t12, xtemp, k12);
 
 		        //* Evaluate k13
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x[j]+k1[j]*h*403863854.0/491063109.0 -k4[j]*h*5068492393.0/434740067.0-k5[j]*h*411421997.0/543043805.0
-		             +k6[j]*h*652783627.0/914296604.0 +k7[j]*h*11173962825.0/925320556.0  -k8[j]*h*13158990841.0/6184727034.0 +k9[j]*h*3936647629.0/1978049680.0 -k10[j]*h*160528059.0/685178525.0 
-		             +k11[j]*h*248638103.0/1413531060.0;
-		        m_dyn->evaluate(t13, xtemp, k13);
+		        state_assign(xtemp, X + h * (403863854.0 / 491063109.0 * K1 - 5068492393.0 / 434740067.0 * K4 - 411421997.0 / 543043805.0 * K5
+		             + 652783627.0 / 914296604.0 * K6 + 11173962825.0 / 925320556.0 * K7 - 13158990841.0 / 6184727034.0 * K8 + 3936647629.0 / 1978049680.0 * K9 - 160528059.0 / 685178525.0 * K10
+		             + 248638103.0 / 1413531060.0 * K11));
+		        evaluate(t13, xtemp, k13);
 
 		        //* Return x(t+h) computed from Runge Kutta.
+		        state_assign(xbar, X + h * (14005451.0 / 335480064.0 * K1 - 59238493.0 / 1068277825.0 * K6 + 181606767.0 / 758867731.0 * K7 + 561292985.0 / 797845732.0 * K8
+		             - 1041891430.0 / 1371343529.0 * K9 + 760417239.0 / 1151165299.0 * K10 + 118820643.0 / 751138087.0 * K11 - 528747749.0 / 2220607170.0 * K12 + 1.0 / 4.0 * K13));
+		        state_assign(xfinal, X + h * (13451932.0 / 455176623.0 * K1 - 808719846.0 / 976000145.0 * K6 + 1757004468.0 / 5645159321.0 * K7 + 656045339.0 / 265891186.0 * K8
+		             - 3867574721.0 / 1518517206.0 * K9 + 465885868.0 / 322736535.0 * K10 + 53011238.0 / 667516719.0 * K11 + 2.0 / 45.0 * K12));
 		        er = 0.0;
 		        for(unsigned int j = 0; j < n; j++)
-		        {
-		            xbar[j] += (k1[j]*14005451.0/335480064.0 -k6[j]*59238493.0/1068277825.0 +k7[j]*181606767.0/758867731.0 +k8[j]* 561292985.0/797845732.0
-		             -k9[j]*1041891430.0/1371343529.0 +k10[j]*760417239.0/1151165299.0  +k11[j]*118820643.0/751138087.0 -k12[j]*528747749.0/2220607170.0 + k13[j]/4.0)*h;
-		            xfinal[j] += (k1[j]*13451932.0/455176623.0 -k6[j]*808719846.0/976000145.0 +k7[j]*1757004468.0/5645159321.0 +k8[j]*656045339.0/265891186.0
-		             -k9[j]*3867574721.0/1518517206.0 +k10[j]*465885868.0/322736535.0  +k11[j]*53011238.0/667516719.0 +k12[j]*2.0/45.0)*h;
-		            er += pow(xbar[j]-xfinal[j], 2);
-		        }
+		            er += pow(xbar[j] - xfinal[j], 2);
 		        er = sqrt(er);
 
 		        return 0;
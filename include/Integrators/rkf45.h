@@ -12,6 +12,7 @@
 
 #include "base_embeddedRK.h"
 #include "../exception.h"
+#include "../Utils/state_expression.h"
 
 namespace smartmath
 {
@@ -22,23 +23,24 @@ namespace smartmath
          *
          * The class model the Runge Kutta Felhberg integration scheme
          */
-        template < class T >
-        class rkf45: public base_embeddedRK<T>
+        template < class T, class State = std::vector<T>, class Dyn = dynamics::base_dynamics<T, State> >
+        class rkf45: public base_embeddedRK<T, State, Dyn>
         {
 
         private:
-            using base_embeddedRK<T>::m_name;
-            using base_embeddedRK<T>::m_dyn;
-            using base_embeddedRK<T>::m_tol;
-            using base_embeddedRK<T>::m_multiplier;
-            using base_embeddedRK<T>::m_control;
-            using base_embeddedRK<T>::m_minstep_events;
-            using base_embeddedRK<T>::m_maxstep_events;
+            using base_embeddedRK<T, State, Dyn>::m_name;
+            using base_embeddedRK<T, State, Dyn>::m_dyn;
+            using base_embeddedRK<T, State, Dyn>::evaluate;
+            using base_embeddedRK<T, State, Dyn>::m_tol;
+            using base_embeddedRK<T, State, Dyn>::m_multiplier;
+            using base_embeddedRK<T, State, Dyn>::m_control;
+            using base_embeddedRK<T, State, Dyn>::m_minstep_events;
+            using base_embeddedRK<T, State, Dyn>::m_maxstep_events;
 
         public:
 
-            using base_embeddedRK<T>::integrate;
-            using base_embeddedRK<T>::dummy_event;
+            using base_embeddedRK<T, State, Dyn>::integrate;
+            using base_embeddedRK<T, State, Dyn>::dummy_event;
             
             /**
              * @brief rkf45 constructor
@@ -49,7 +51,7 @@ namespace smartmath
              * @param minstep_events minimum time step for events detection
              * @param maxstep_events maximum time step for events detection
              */
-            rkf45(const dynamics::base_dynamics<T> *dyn, const double tol = 1.0e-7, const double multiplier = 5.0, const double minstep_events = 1.0e-4, const double maxstep_events = 0.0): base_embeddedRK<T>("Runge Kutta 4-5 variable step time", dyn, tol, multiplier, minstep_events, maxstep_events)
+            rkf45(const Dyn *dyn, const double tol = 1.0e-7, const double multiplier = 5.0, const double minstep_events = 1.0e-4, const double maxstep_events = 0.0): base_embeddedRK<T, State, Dyn>("Runge Kutta 4-5 variable step time", dyn, tol, multiplier, minstep_events, maxstep_events)
             {
 
                m_control = 4;
@@ -75,12 +77,14 @@ namespace smartmath
              * @param[out] er estimated error 
              * @return
              */
-            int integration_step(const double &ti, const unsigned int &m, const double &h, const std::vector<T> &x0, const std::vector<std::vector<T> > &f, std::vector<T> &xfinal, T &er) const{
+            int integration_step(const double &ti, const unsigned int &m, const double &h, const State &x0, const state_history<State> &f, State &xfinal, T &er) const{
 		
 		        unsigned int n = x0.size();
-		        std::vector<T> k1(x0), k2(x0), k3(x0), k4(x0), k5(x0), k6(x0), xbar(x0), xtemp(x0);
+		        State k1(x0), k2(x0), k3(x0), k4(x0), k5(x0), k6(x0), xbar(x0), xtemp(x0);
 		        double t1, t2, t3, t4, t5, t6;
-                xfinal = x0;
+
+		        /* the stages are expressions on the states evaluated in one loop each */
+		        const state_terminal<State> X(x0), K1(k1), K2(k2), K3(k3), K4(k4), K5(k5), K6(k6);
 
 		        t1 = ti;
 		        t2 = t1 + h / 4.0;
@@ -90,41 +94,34 @@ namespace smartmath
 		        t6 = t1 + h / 2.0;
 
 		        //* Evaluate k1 
-		        m_dyn->evaluate(t1, x0, k1);
+		        evaluate(t1, x0, k1);
 
 		        //* Evaluate k2 
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x0[j]+k1[j]*h/4.0;
-		        m_dyn->evaluate(t2, xtemp, k2);
+		        state_assign(xtemp, X + h * (1.0 / 4.0 * K1));
+		        evaluate(t2, xtemp, k2);
 
 		        //* Evaluate k3 
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x0[j]+k1[j]*h*3.0/32.0+k2[j]*h*9.0/32.0;
-		        m_dyn->evaluate(t3, xtemp, k3);
+		        state_assign(xtemp, X + h * (3.0 / 32.0 * K1 + 9.0 / 32.0 * K2));
+		        evaluate(t3, xtemp, k3);
 
 		        //* Evaluate k4 
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x0[j]+k1[j]*h*1932.0/2197.0-k2[j]*h*7200.0/2197.0+k3[j]*h*7296.0/2197.0;
-		        m_dyn->evaluate(t4, xtemp, k4);
+		        state_assign(xtemp, X + h * (1932.0 / 2197.0 * K1 - 7200.0 / 2197.0 * K2 + 7296.0 / 2197.0 * K3));
+		        evaluate(t4, xtemp, k4);
 
 		        //* Evaluate k5
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x0[j]+k1[j]*h*439.0/216.0-k2[j]*h*8.0+k3[j]*h*3680.0/513.0-k4[j]*h*845.0/4104.0;
-		        m_dyn->evaluate(t5, xtemp, k5);
+		        state_assign(xtemp, X + h * (439.0 / 216.0 * K1 - 8.0 * K2 + 3680.0 / 513.0 * K3 - 845.0 / 4104.0 * K4));
+		        evaluate(t5, xtemp, k5);
 
 		        //* Evaluate k6
-		        for(unsigned int j = 0; j < n; j++)
-		            xtemp[j] = x0[j]-k1[j]*h*8.0/27.0+k2[j]*h*2.0-k3[j]*h*3544.0/2565.0+k4[j]*h*1859.0/4104.0-k5[j]*h*11.0/40.0;
-		        m_dyn->evaluate(t6, xtemp, k6);
+		        state_assign(xtemp, X + h * (-8.0 / 27.0 * K1 + 2.0 * K2 - 3544.0 / 2565.0 * K3 + 1859.0 / 4104.0 * K4 - 11.0 / 40.0 * K5));
+		        evaluate(t6, xtemp, k6);
 
 		        //* Return x(t+h) computed from fourth-order Runge Kutta.
+		        state_assign(xbar, X + h * (16.0 / 135.0 * K1 + 6656.0 / 12825.0 * K3 + 28561.0 / 56430.0 * K4 - 9.0 / 50.0 * K5 + 2.0 / 55.0 * K6));
+		        state_assign(xfinal, X + h * (25.0 / 216.0 * K1 + 1408.0 / 2565.0 * K3 + 2197.0 / 4104.0 * K4 - 1.0 / 5.0 * K5));
 		        er = 0.0 * x0[0];
 		        for(unsigned int j = 0; j < n; j++)
-                {
-		            xbar[j] += (k1[j]*16.0/135.0+k3[j]*6656.0/12825.0+k4[j]*28561.0/56430.0-k5[j]*9.0/50.0+k6[j]*2.0/55.0) * h;
-		            xfinal[j] += (k1[j]*25.0/216.0+k3[j]*1408.0/2565.0+k4[j]*2197.0/4104.0-k5[j]/5.0) * h;
 		            er += pow(xbar[j] - xfinal[j], 2);
-		        }
 		        er = sqrt(er);
 
 	           return 0;
@@ -13,6 +13,8 @@
 #define SMARTMATH_INTEGRATORS_H
 
 #include "base_integrator.h"
+#include "base_observer.h"
+#include "trajectory_observer.h"
 #include "base_rungekutta.h"
 #include "euler.h"
 #include "midpoint.h"
@@ -21,6 +23,7 @@
 #include "base_multistep.h"
 #include "AB.h"
 #include "ABM.h"
+#include "BDF.h"
 #include "base_integrationwevent.h"
 #include "base_embeddedRK.h"
 #include "rkf45.h"
@@ -36,5 +39,7 @@
 #include "leapfrog_mixedvar.h"
 #include "forest_mixedvar.h"
 #include "yoshida6_mixedvar.h"
+#include "checkpoint.h"
+#include "stepper.h"
 
 #endif // SMARTMATH_INTEGRATORS_H
@@ -0,0 +1,1006 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_STEPPER_H
+#define SMARTMATH_STEPPER_H
+
+#include <cmath>
+#include <limits>
+#include "base_rungekutta.h"
+#include "base_multistep.h"
+#include "BDF.h"
+#include "base_embeddedRK.h"
+#include "bulirschstoer.h"
+#include "base_symplectic.h"
+#include "symplectic_mixedvar.h"
+#include "checkpoint.h"
+#include "../exception.h"
+
+namespace smartmath
+{
+    namespace integrator {
+
+        /**
+         * @brief The %base_stepper class is a template abstract class for the step by step use of an integrator
+         *
+         * A stepper is initialised once with init() and then advanced with step() or step_to(). Contrary to successive calls to integrate(), the internal state of the integrator
+         * (history of a multistep scheme, step-size proposed by the controller, order and Nordsieck history of BDF) is kept from one call to the next, so that consecutive segments continue without a new start.
+         * The stepper refers to the integrator, which needs to outlive it. The integration limits of the integrator are not checked since the loop is in the hands of the caller.
+         * The cost of the steps is added to the statistics of the stepper (see get_statistics()), not to the ones of the integrator.
+         *
+         * The whole internal state can be written to a checkpoint file with checkpoint() and restored with restart() by a stepper of the same integrator, possibly in another process:
+         * the integration then continues bit for bit as if it had not been interrupted. checkpointed_step_to() writes checkpoints periodically during a long propagation.
+         */
+        template < class T, class State = std::vector<T> >
+        class base_stepper
+        {
+
+        public:
+            /**
+             * @brief base_stepper constructor
+             * @param name stepper name used in the error messages
+             */
+            base_stepper(const std::string &name): m_name(name), m_t0(0.0), m_t(0.0), m_h(0.0), m_initialised(false){}
+
+            /**
+             * @brief ~base_stepper deconstructor
+             */
+            virtual ~base_stepper(){}
+
+            /**
+             * @brief init sets the initial conditions and starts the integrator
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             * @param[in] h step-size (initial guess for variable step-size methods)
+             */
+            virtual void init(const double &t0, const State &x0, const double &h) = 0;
+
+            /**
+             * @brief step performs one step of the integrator
+             * @return exit flag (0=success)
+             */
+            virtual int step() = 0;
+
+            /**
+             * @brief step_to advances the integration up to a given time, which is reached exactly
+             * @param[in] t target time
+             * @return exit flag (0=success)
+             */
+            virtual int step_to(const double &t) = 0;
+
+            /**
+             * @brief state returns the current state
+             * @return reference to the current state
+             */
+            const State &state() const{
+                return m_x;
+            }
+
+            /**
+             * @brief time returns the current time
+             * @return current time
+             */
+            double time() const{
+                return m_t;
+            }
+
+            /**
+             * @brief get_step returns the step-size of the next step
+             * @return step-size
+             */
+            double get_step() const{
+                return m_h;
+            }
+
+            /**
+             * @brief get_statistics returns the cost of the steps since init() or restart(), the one of the starting values being counted as bootstrap
+             * @return statistics
+             */
+            integration_statistics get_statistics() const{
+                return m_statistics;
+            }
+
+            /**
+             * @brief save writes the internal state of the stepper and of its integrator
+             * @param[in,out] out checkpoint file
+             */
+            virtual void save(checkpoint_output &out) const{
+                if(!m_initialised)
+                    smartmath_throw(m_name + ": the stepper needs to be initialised with init()");
+                out.write_string(m_name);
+                out.write(m_t0);
+                out.write(m_t);
+                out.write(m_h);
+                out.write_state(m_x);
+            }
+
+            /**
+             * @brief load restores the internal state written by save()
+             * @param[in,out] in checkpoint file
+             */
+            virtual void load(checkpoint_input &in){
+                std::string name = in.read_string();
+                if(name != m_name)
+                    smartmath_throw(m_name + ": the checkpoint has been written by a " + name);
+                m_t0 = in.read<double>();
+                m_t = in.read<double>();
+                m_h = in.read<double>();
+                in.read_state(m_x);
+                m_statistics = integration_statistics();
+                m_initialised = true;
+            }
+
+            /**
+             * @brief checkpoint writes the internal state to a checkpoint file, replacing the previous one only once the new one is complete
+             * @param[in] filename path of the checkpoint file
+             */
+            void checkpoint(const std::string &filename) const{
+                checkpoint_output out(filename);
+                save(out);
+                out.commit();
+            }
+
+            /**
+             * @brief restart restores the internal state from a checkpoint file, instead of init()
+             * @param[in] filename path of the checkpoint file
+             */
+            void restart(const std::string &filename){
+                checkpoint_input in(filename);
+                load(in);
+            }
+
+            /**
+             * @brief checkpointed_step_to advances the integration up to a given time, writing a checkpoint every interval of time
+             *
+             * The checkpoints are written at the times t0 + k interval, t0 being the initial time given to init(), and at the target time. Since the segments only depend on t0,
+             * a propagation restarted from any of the checkpoints and continued with the same call goes through the same steps as an uninterrupted one.
+             * For a fixed step-size method, an interval multiple of the step-size keeps the steps unchanged (it is required for a multistep scheme).
+             * @param[in] t target time
+             * @param[in] interval time between two checkpoints
+             * @param[in] filename path of the checkpoint file
+             * @return exit flag (0=success)
+             */
+            int checkpointed_step_to(const double &t, const double &interval, const std::string &filename){
+                check_target(t);
+                if(interval <= 0.0)
+                    smartmath_throw(m_name + ": the interval between two checkpoints needs to be positive");
+
+                const double direction = (m_h > 0.0) ? 1.0 : -1.0;
+                while((t - m_t) * direction > 0.0)
+                {
+                    double k = floor((m_t - m_t0) * direction / interval + 1.0e-9) + 1.0;
+                    double next = m_t0 + direction * k * interval;
+                    if((next - t) * direction > 0.0)
+                        next = t;
+                    int flag = step_to(next);
+                    if(flag != 0)
+                        return flag;
+                    checkpoint(filename);
+                }
+
+                return 0;
+            }
+
+        protected:
+            /**
+             * @brief start checks the step-size and stores the initial conditions
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             * @param[in] h step-size
+             */
+            void start(const double &t0, const State &x0, const double &h){
+                if(h == 0.0)
+                    smartmath_throw(m_name + ": the step-size needs to be non-zero");
+                m_t0 = t0;
+                m_t = t0;
+                m_x = x0;
+                m_h = h;
+                m_statistics = integration_statistics();
+                m_initialised = true;
+            }
+
+            /**
+             * @brief check_integrator checks that a checkpoint has been written with the same integrator
+             * @param[in,out] in checkpoint file
+             * @param[in] name name of the integrator of the stepper
+             */
+            void check_integrator(checkpoint_input &in, const std::string &name) const{
+                std::string saved = in.read_string();
+                if(saved != name)
+                    smartmath_throw(m_name + ": the checkpoint has been written with the integrator " + saved + " instead of " + name);
+            }
+
+            /**
+             * @brief check_target checks that the stepper is initialised and that a target time is not behind the current time
+             * @param[in] t target time
+             */
+            void check_target(const double &t) const{
+                if(!m_initialised)
+                    smartmath_throw(m_name + ": the stepper needs to be initialised with init()");
+                if((t - m_t) * m_h < 0.0)
+                    smartmath_throw(m_name + ": the target time needs to be ahead in the direction of integration");
+            }
+
+            /**
+             * @brief count_steps splits the distance to a target time into steps of the current step-size
+             * @param[in] t target time
+             * @param[out] n number of full steps before the target
+             * @return true if the target is reached by the n full steps up to round-off
+             */
+            bool count_steps(const double &t, unsigned int &n) const{
+                double r = (t - m_t) / m_h, k = floor(r + 0.5);
+                if(fabs(r - k) <= 1.0e-9)
+                {
+                    n = (unsigned int) k;
+                    return true;
+                }
+                n = (unsigned int) floor(r);
+                return false;
+            }
+
+            /**
+             * @brief m_name stepper name
+             */
+            std::string m_name;
+            /**
+             * @brief m_t0 initial time given to init()
+             */
+            double m_t0;
+            /**
+             * @brief m_t current time
+             */
+            double m_t;
+            /**
+             * @brief m_x current state
+             */
+            State m_x;
+            /**
+             * @brief m_h step-size of the next step
+             */
+            double m_h;
+            /**
+             * @brief m_initialised true once init() has been called
+             */
+            bool m_initialised;
+            /**
+             * @brief m_statistics cost of the steps since init() or restart()
+             */
+            integration_statistics m_statistics;
+        };
+
+        /**
+         * @brief The %single_step_stepper class advances a one-step method (fixed-step Runge-Kutta or Bulirsch-Stoer)
+         *
+         * step_to() shortens the last step to reach the target exactly, the step-size being restored for the next call.
+         */
+        template < class Integrator >
+        class single_step_stepper: public base_stepper<typename Integrator::value_type, typename Integrator::state_type>
+        {
+
+        private:
+            typedef typename Integrator::value_type T;
+            typedef typename Integrator::state_type State;
+            using base_stepper<T, State>::m_name;
+            using base_stepper<T, State>::m_t;
+            using base_stepper<T, State>::m_x;
+            using base_stepper<T, State>::m_h;
+
+        public:
+            /**
+             * @brief single_step_stepper constructor
+             * @param integrator pointer to the integrator
+             */
+            single_step_stepper(const Integrator *integrator): base_stepper<T, State>("SINGLE_STEP_STEPPER"), m_integrator(integrator){}
+
+            /**
+             * @brief save writes the internal state of the stepper
+             * @param[in,out] out checkpoint file
+             */
+            void save(checkpoint_output &out) const{
+                base_stepper<T, State>::save(out);
+                out.write_string(m_integrator->get_name());
+            }
+
+            /**
+             * @brief load restores the internal state written by save()
+             * @param[in,out] in checkpoint file
+             */
+            void load(checkpoint_input &in){
+                base_stepper<T, State>::load(in);
+                this->check_integrator(in, m_integrator->get_name());
+                m_xp = m_x;
+            }
+
+            /**
+             * @brief init sets the initial conditions
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             * @param[in] h step-size
+             */
+            void init(const double &t0, const State &x0, const double &h){
+                this->start(t0, x0, h);
+                m_xp = x0;
+            }
+
+            /**
+             * @brief step performs one step with the current step-size
+             * @return exit flag (0=success)
+             */
+            int step(){
+                this->check_target(m_t);
+                return advance(m_h);
+            }
+
+            /**
+             * @brief step_to advances the integration up to a given time
+             * @param[in] t target time
+             * @return exit flag (0=success)
+             */
+            int step_to(const double &t){
+                this->check_target(t);
+
+                unsigned int n;
+                bool whole = this->count_steps(t, n);
+                for(unsigned int i = 0; i < n; i++)
+                {
+                    int flag = advance(m_h);
+                    if(flag != 0)
+                        return flag;
+                }
+                if(!whole)
+                {
+                    int flag = advance(t - m_t);
+                    if(flag != 0)
+                        return flag;
+                }
+                m_t = t;
+
+                return 0;
+            }
+
+        private:
+            /**
+             * @brief advance performs one step with a given step-size
+             * @param[in] h step-size
+             * @return exit flag (0=success)
+             */
+            int advance(const double &h){
+                integration_record record(this->m_statistics);
+                step_scope scope;
+                int flag = m_integrator->integration_step(m_t, h, m_x, m_xp);
+                m_t += h;
+                m_x = m_xp;
+                record.statistics().steps_accepted++;
+                return flag;
+            }
+
+            /**
+             * @brief m_integrator pointer to the integrator
+             */
+            const Integrator *m_integrator;
+            /**
+             * @brief m_xp work state
+             */
+            State m_xp;
+        };
+
+        /**
+         * @brief The %multistep_stepper class advances a fixed step-size multistep method (Adams-Bashforth, Adams-Bashforth-Moulton)
+         *
+         * The history of the scheme is computed once by init() and kept afterwards. Since the history is tied to the step-size, step_to() requires the target to be a whole number of steps away.
+         */
+        template < class Integrator >
+        class multistep_stepper: public base_stepper<typename Integrator::value_type, typename Integrator::state_type>
+        {
+
+        private:
+            typedef typename Integrator::value_type T;
+            typedef typename Integrator::state_type State;
+            using base_stepper<T, State>::m_name;
+            using base_stepper<T, State>::m_t;
+            using base_stepper<T, State>::m_x;
+            using base_stepper<T, State>::m_h;
+
+        public:
+            /**
+             * @brief multistep_stepper constructor
+             * @param integrator pointer to the integrator
+             */
+            multistep_stepper(const Integrator *integrator): base_stepper<T, State>("MULTISTEP_STEPPER"), m_integrator(integrator){}
+
+            /**
+             * @brief save writes the internal state of the stepper, including the history of the scheme
+             * @param[in,out] out checkpoint file
+             */
+            void save(checkpoint_output &out) const{
+                base_stepper<T, State>::save(out);
+                out.write_string(m_integrator->get_name());
+                out.write_history(m_f);
+            }
+
+            /**
+             * @brief load restores the internal state written by save()
+             * @param[in,out] in checkpoint file
+             */
+            void load(checkpoint_input &in){
+                base_stepper<T, State>::load(in);
+                this->check_integrator(in, m_integrator->get_name());
+                in.read_history(m_f);
+                m_xp = m_x;
+            }
+
+            /**
+             * @brief init sets the initial conditions and computes the history of the scheme
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             * @param[in] h step-size
+             */
+            void init(const double &t0, const State &x0, const double &h){
+                this->start(t0, x0, h);
+                m_xp = x0;
+                integration_record record(this->m_statistics);
+                m_integrator->initialize(m_integrator->get_order(), t0, h, x0, m_f);
+                record.start_steps();
+            }
+
+            /**
+             * @brief step performs one step
+             * @return exit flag (0=success)
+             */
+            int step(){
+                this->check_target(m_t);
+                integration_record record(this->m_statistics);
+                step_scope scope;
+                int flag = m_integrator->integration_step(m_t, m_integrator->get_order(), m_h, m_x, m_f, m_xp);
+                m_t += m_h;
+                m_x = m_xp;
+                record.statistics().steps_accepted++;
+                return flag;
+            }
+
+            /**
+             * @brief step_to advances the integration up to a given time
+             * @param[in] t target time, a whole number of steps away from the current time
+             * @return exit flag (0=success)
+             */
+            int step_to(const double &t){
+                this->check_target(t);
+
+                unsigned int n;
+                if(!this->count_steps(t, n))
+                    smartmath_throw(m_name + ": the target time needs to be a whole number of steps away for a multistep scheme");
+                for(unsigned int i = 0; i < n; i++)
+                {
+                    int flag = step();
+                    if(flag != 0)
+                        return flag;
+                }
+                m_t = t;
+
+                return 0;
+            }
+
+        private:
+            /**
+             * @brief m_integrator pointer to the integrator
+             */
+            const Integrator *m_integrator;
+            /**
+             * @brief m_f saved state vectors of the multistep scheme
+             */
+            state_history<State> m_f;
+            /**
+             * @brief m_xp work state
+             */
+            State m_xp;
+        };
+
+        /**
+         * @brief The %embeddedRK_stepper class advances a variable step-size Runge-Kutta method (rkf45, rk87)
+         *
+         * The step-size proposed by the controller after the last accepted step is kept between calls. When step_to() shortens a step to reach the target, the proposal made before the shortening is kept.
+         * Events are not handled by the stepper. The schemes of the toolbox do not have the first-same-as-last property, so no stage is carried over from one step to the next.
+         */
+        template < class Integrator >
+        class embeddedRK_stepper: public base_stepper<typename Integrator::value_type, typename Integrator::state_type>
+        {
+
+        private:
+            typedef typename Integrator::value_type T;
+            typedef typename Integrator::state_type State;
+            using base_stepper<T, State>::m_name;
+            using base_stepper<T, State>::m_t;
+            using base_stepper<T, State>::m_x;
+            using base_stepper<T, State>::m_h;
+
+        public:
+            /**
+             * @brief embeddedRK_stepper constructor
+             * @param integrator pointer to the integrator
+             */
+            embeddedRK_stepper(const Integrator *integrator): base_stepper<T, State>("EMBEDDEDRK_STEPPER"), m_integrator(integrator){}
+
+            /**
+             * @brief save writes the internal state of the stepper, the step-size proposed by the controller being its current step-size
+             * @param[in,out] out checkpoint file
+             */
+            void save(checkpoint_output &out) const{
+                base_stepper<T, State>::save(out);
+                out.write_string(m_integrator->get_name());
+            }
+
+            /**
+             * @brief load restores the internal state written by save()
+             * @param[in,out] in checkpoint file
+             */
+            void load(checkpoint_input &in){
+                base_stepper<T, State>::load(in);
+                this->check_integrator(in, m_integrator->get_name());
+                m_xp = m_x;
+            }
+
+            /**
+             * @brief init sets the initial conditions
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             * @param[in] h initial guess for the step-size
+             */
+            void init(const double &t0, const State &x0, const double &h){
+                this->start(t0, x0, h);
+                m_xp = x0;
+            }
+
+            /**
+             * @brief step performs one accepted step, retrying with smaller step-sizes as needed
+             *
+             * An exception is thrown if a step is rejected with the minimum step-size or too many times in a row
+             * @return exit flag (0=success)
+             */
+            int step(){
+                this->check_target(m_t);
+
+                double tend = (m_h > 0.0) ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+                double h, factor;
+                const double hmin = 16.0 * std::numeric_limits<double>::epsilon() * (fabs(m_t) + fabs(m_t + m_h));
+                unsigned int rejections = 0;
+                integration_record record(this->m_statistics);
+                step_scope scope;
+                while(true)
+                {
+                    h = m_h;
+                    if(m_integrator->controlled_step(m_t, tend, h, m_x, m_xp, factor))
+                        break;
+                    m_h = h * (0.9 * factor);
+                    reject(hmin, rejections);
+                }
+                m_t += h;
+                m_x = m_xp;
+                m_h = h * factor;
+                record.statistics().steps_accepted++;
+
+                return 0;
+            }
+
+            /**
+             * @brief step_to advances the integration up to a given time
+             *
+             * An exception is thrown if a step is rejected with the minimum step-size or too many times in a row
+             * @param[in] t target time
+             * @return exit flag (0=success)
+             */
+            int step_to(const double &t){
+                this->check_target(t);
+
+                const double t0 = m_t;
+                const double hmin = 16.0 * std::numeric_limits<double>::epsilon() * (fabs(t0) + fabs(t));
+                double h, factor;
+                unsigned int rejections = 0;
+                integration_record record(this->m_statistics);
+                while(fabs(m_t - t0) < fabs(t - t0))
+                {
+                    step_scope scope;
+                    h = m_h;
+                    bool shortened = (fabs(t - m_t) < fabs(h));
+                    if(!m_integrator->controlled_step(m_t, t, h, m_x, m_xp, factor))
+                    {
+                        m_h = h * (0.9 * factor);
+                        reject(hmin, rejections);
+                    }
+                    else
+                    {
+                        rejections = 0;
+                        m_t += h;
+                        m_x = m_xp;
+                        record.statistics().steps_accepted++;
+                        if(!shortened)
+                            m_h = h * factor;
+                    }
+                }
+                m_t = t;
+
+                return 0;
+            }
+
+        private:
+            /**
+             * @brief reject counts a rejected step and throws if the reduced step-size is below the minimum
+             * @param[in] hmin minimum step-size
+             * @param[in,out] rejections number of consecutive rejections
+             */
+            void reject(const double &hmin, unsigned int &rejections) const{
+                if(!(fabs(m_h) > hmin))
+                    smartmath_throw(m_name + ": step-size reduced below the minimum after a rejected step");
+                if(++rejections >= m_max_rejections)
+                    smartmath_throw(m_name + ": too many consecutive rejected steps");
+            }
+
+            /**
+             * @brief m_max_rejections number of consecutive rejections after which a step fails
+             */
+            static const unsigned int m_max_rejections = 100;
+
+            /**
+             * @brief m_integrator pointer to the integrator
+             */
+            const Integrator *m_integrator;
+            /**
+             * @brief m_xp work state
+             */
+            State m_xp;
+        };
+
+        /**
+         * @brief The %BDF_stepper class advances the variable step-size, variable order BDF method
+         *
+         * The order, the step-size, the Nordsieck history, the Jacobian and the factorisation of the iteration matrix are kept between calls. They belong to the stepper, so that several steppers can share an integrator.
+         */
+        template < class Integrator >
+        class BDF_stepper: public base_stepper<typename Integrator::value_type, typename Integrator::state_type>
+        {
+
+        private:
+            typedef typename Integrator::value_type T;
+            typedef typename Integrator::state_type State;
+            using base_stepper<T, State>::m_name;
+            using base_stepper<T, State>::m_t;
+            using base_stepper<T, State>::m_x;
+            using base_stepper<T, State>::m_h;
+
+        public:
+            /**
+             * @brief BDF_stepper constructor
+             * @param integrator pointer to the integrator
+             */
+            BDF_stepper(const Integrator *integrator): base_stepper<T, State>("BDF_STEPPER"), m_integrator(integrator){}
+
+            /**
+             * @brief save writes the internal state of the stepper: order, step-size, Nordsieck history and Jacobian of the iteration matrix
+             * @param[in,out] out checkpoint file
+             */
+            void save(checkpoint_output &out) const{
+                base_stepper<T, State>::save(out);
+                out.write_string(m_integrator->get_name());
+                out.write(m_mem.q);
+                out.write(m_mem.steps_at_order);
+                out.write(m_mem.previous_error);
+                out.write(m_mem.h);
+                out.write(m_mem.hmin);
+                out.write_history(m_mem.f);
+                out.write_history(m_mem.z);
+                out.write_state(m_mem.e);
+                out.write_state(m_mem.e_previous);
+                m_mem.iteration.save(out);
+            }
+
+            /**
+             * @brief load restores the internal state written by save()
+             * @param[in,out] in checkpoint file
+             */
+            void load(checkpoint_input &in){
+                base_stepper<T, State>::load(in);
+                this->check_integrator(in, m_integrator->get_name());
+                m_mem.q = in.read<unsigned int>();
+                m_mem.steps_at_order = in.read<unsigned int>();
+                m_mem.previous_error = in.read<bool>();
+                m_mem.h = in.read<double>();
+                m_mem.hmin = in.read<double>();
+                in.read_history(m_mem.f);
+                in.read_history(m_mem.z);
+                in.read_state(m_mem.e);
+                in.read_state(m_mem.e_previous);
+                m_mem.iteration.load(in);
+            }
+
+            /**
+             * @brief init sets the initial conditions and starts the method at first order
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             * @param[in] h initial guess for the step-size
+             */
+            void init(const double &t0, const State &x0, const double &h){
+                this->start(t0, x0, h);
+                integration_record record(this->m_statistics);
+                m_integrator->start(t0, h, x0, m_mem);
+                record.start_steps();
+            }
+
+            /**
+             * @brief step performs one accepted step, retrying with smaller step-sizes as needed
+             * @return exit flag (0=success)
+             */
+            int step(){
+                this->check_target(m_t);
+
+                double tend = (m_h > 0.0) ? std::numeric_limits<double>::infinity() : -std::numeric_limits<double>::infinity();
+                m_mem.hmin = 16.0 * std::numeric_limits<double>::epsilon() * (fabs(m_t) + fabs(m_t + m_h));
+                integration_record record(this->m_statistics);
+                while(m_integrator->attempt_step(m_t, tend, m_mem) != 0){}
+                record.statistics().steps_accepted++;
+                m_x = m_mem.f[0];
+                m_h = m_mem.h;
+
+                return 0;
+            }
+
+            /**
+             * @brief step_to advances the integration up to a given time
+             * @param[in] t target time
+             * @return exit flag (0=success)
+             */
+            int step_to(const double &t){
+                this->check_target(t);
+
+                const double t0 = m_t;
+                double h = 0.0;
+                bool shortened = false;
+                m_mem.hmin = 16.0 * std::numeric_limits<double>::epsilon() * (fabs(t0) + fabs(t));
+                integration_record record(this->m_statistics);
+                while(fabs(m_t - t0) < fabs(t - t0))
+                {
+                    h = m_mem.h;
+                    shortened = (fabs(t - m_t) < fabs(h));
+                    if(m_integrator->attempt_step(m_t, t, m_mem) == 0)
+                        record.statistics().steps_accepted++;
+                }
+                /* the step-size before the last step was shortened to reach t is restored for the next call, unless the controller proposes a larger one */
+                if(shortened && (fabs(m_mem.h) < fabs(h)))
+                    m_integrator->change_step(h / m_mem.h, m_mem);
+                m_t = t;
+                m_x = m_mem.f[0];
+                m_h = m_mem.h;
+
+                return 0;
+            }
+
+        private:
+            /**
+             * @brief m_integrator pointer to the integrator
+             */
+            const Integrator *m_integrator;
+            /**
+             * @brief m_mem memory of the step-size and order control
+             */
+            typename Integrator::step_memory m_mem;
+        };
+
+        /**
+         * @brief The %symplectic_stepper class advances a symplectic integrator
+         *
+         * The state is made of the coordinates followed by the momenta, as for integrate(). step_to() shortens the last step to reach the target exactly, the step-size being restored for the next call.
+         */
+        template < class Integrator >
+        class symplectic_stepper: public base_stepper<typename Integrator::value_type, std::vector<typename Integrator::value_type> >
+        {
+
+        private:
+            typedef typename Integrator::value_type T;
+            typedef std::vector<T> State;
+            using base_stepper<T, State>::m_name;
+            using base_stepper<T, State>::m_t;
+            using base_stepper<T, State>::m_x;
+            using base_stepper<T, State>::m_h;
+
+        public:
+            /**
+             * @brief symplectic_stepper constructor
+             * @param integrator pointer to the integrator
+             */
+            symplectic_stepper(const Integrator *integrator): base_stepper<T, State>("SYMPLECTIC_STEPPER"), m_integrator(integrator){}
+
+            /**
+             * @brief save writes the internal state of the stepper
+             * @param[in,out] out checkpoint file
+             */
+            void save(checkpoint_output &out) const{
+                base_stepper<T, State>::save(out);
+                out.write_string(m_integrator->get_name());
+            }
+
+            /**
+             * @brief load restores the internal state written by save() and splits the state into coordinates and momenta
+             * @param[in,out] in checkpoint file
+             */
+            void load(checkpoint_input &in){
+                base_stepper<T, State>::load(in);
+                this->check_integrator(in, m_integrator->get_name());
+                if(m_x.size() % 2 != 0)
+                    smartmath_throw(m_name + ": state vector must contain as many coordinates as momenta");
+                unsigned int n = m_x.size() / 2;
+                m_q.assign(m_x.begin(), m_x.begin() + n);
+                m_p.assign(m_x.begin() + n, m_x.end());
+                m_qf = m_q;
+                m_pf = m_p;
+            }
+
+            /**
+             * @brief init sets the initial conditions
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states (coordinates followed by momenta)
+             * @param[in] h step-size
+             */
+            void init(const double &t0, const State &x0, const double &h){
+                if(x0.size() % 2 != 0)
+                    smartmath_throw(m_name + ": state vector must contain as many coordinates as momenta");
+                this->start(t0, x0, h);
+
+                unsigned int n = x0.size() / 2;
+                m_q.assign(x0.begin(), x0.begin() + n);
+                m_p.assign(x0.begin() + n, x0.end());
+                m_qf = m_q;
+                m_pf = m_p;
+            }
+
+            /**
+             * @brief step performs one step with the current step-size
+             * @return exit flag (0=success)
+             */
+            int step(){
+                this->check_target(m_t);
+                return advance(m_h);
+            }
+
+            /**
+             * @brief step_to advances the integration up to a given time
+             * @param[in] t target time
+             * @return exit flag (0=success)
+             */
+            int step_to(const double &t){
+                this->check_target(t);
+
+                unsigned int n;
+                bool whole = this->count_steps(t, n);
+                for(unsigned int i = 0; i < n; i++)
+                {
+                    int flag = advance(m_h);
+                    if(flag != 0)
+                        return flag;
+                }
+                if(!whole)
+                {
+                    int flag = advance(t - m_t);
+                    if(flag != 0)
+                        return flag;
+                }
+                m_t = t;
+
+                return 0;
+            }
+
+        private:
+            /**
+             * @brief advance performs one step with a given step-size
+             * @param[in] h step-size
+             * @return exit flag (0=success)
+             */
+            int advance(const double &h){
+                integration_record record(this->m_statistics);
+                step_scope scope;
+                int flag = m_integrator->integration_step(m_t, h, m_q, m_p, m_qf, m_pf);
+                m_t += h;
+                m_q = m_qf;
+                m_p = m_pf;
+                record.statistics().steps_accepted++;
+                unsigned int n = m_q.size();
+                for(unsigned int j = 0; j < n; j++)
+                {
+                    m_x[j] = m_q[j];
+                    m_x[j + n] = m_p[j];
+                }
+                return flag;
+            }
+
+            /**
+             * @brief m_integrator pointer to the integrator
+             */
+            const Integrator *m_integrator;
+            /**
+             * @brief m_q, m_p current coordinates and momenta
+             */
+            std::vector<T> m_q, m_p;
+            /**
+             * @brief m_qf, m_pf coordinates and momenta at the end of a step
+             */
+            std::vector<T> m_qf, m_pf;
+        };
+
+        /**
+         * @brief make_stepper returns the stepper of a fixed-step Runge-Kutta integrator
+         * @param integrator integrator, which needs to outlive the stepper
+         * @return stepper
+         */
+        template < class T, class State, class Dyn >
+        single_step_stepper< base_rungekutta<T, State, Dyn> > make_stepper(const base_rungekutta<T, State, Dyn> &integrator){
+            return single_step_stepper< base_rungekutta<T, State, Dyn> >(&integrator);
+        }
+
+        /**
+         * @brief make_stepper returns the stepper of a Bulirsch-Stoer integrator
+         * @param integrator integrator, which needs to outlive the stepper
+         * @return stepper
+         */
+        template < class T, class State, class Dyn >
+        single_step_stepper< bulirschstoer<T, State, Dyn> > make_stepper(const bulirschstoer<T, State, Dyn> &integrator){
+            return single_step_stepper< bulirschstoer<T, State, Dyn> >(&integrator);
+        }
+
+        /**
+         * @brief make_stepper returns the stepper of a fixed step-size multistep integrator
+         * @param integrator integrator, which needs to outlive the stepper
+         * @return stepper
+         */
+        template < class T, class State, class Dyn >
+        multistep_stepper< base_multistep<T, State, Dyn> > make_stepper(const base_multistep<T, State, Dyn> &integrator){
+            return multistep_stepper< base_multistep<T, State, Dyn> >(&integrator);
+        }
+
+        /**
+         * @brief make_stepper returns the stepper of a BDF integrator
+         * @param integrator integrator, which needs to outlive the stepper
+         * @return stepper
+         */
+        template < class T, class State, class Dyn >
+        BDF_stepper< BDF<T, State, Dyn> > make_stepper(const BDF<T, State, Dyn> &integrator){
+            return BDF_stepper< BDF<T, State, Dyn> >(&integrator);
+        }
+
+        /**
+         * @brief make_stepper returns the stepper of a variable step-size Runge-Kutta integrator
+         * @param integrator integrator, which needs to outlive the stepper
+         * @return stepper
+         */
+        template < class T, class State, class Dyn >
+        embeddedRK_stepper< base_embeddedRK<T, State, Dyn> > make_stepper(const base_embeddedRK<T, State, Dyn> &integrator){
+            return embeddedRK_stepper< base_embeddedRK<T, State, Dyn> >(&integrator);
+        }
+
+        /**
+         * @brief make_stepper returns the stepper of a symplectic integrator
+         * @param integrator integrator, which needs to outlive the stepper
+         * @return stepper
+         */
+        template < class T >
+        symplectic_stepper< base_symplectic<T> > make_stepper(const base_symplectic<T> &integrator){
+            return symplectic_stepper< base_symplectic<T> >(&integrator);
+        }
+
+        /**
+         * @brief make_stepper returns the stepper of a symplectic integrator with mixed variables
+         * @param integrator integrator, which needs to outlive the stepper
+         * @return stepper
+         */
+        template < class T >
+        symplectic_stepper< symplectic_mixedvar<T> > make_stepper(const symplectic_mixedvar<T> &integrator){
+            return symplectic_stepper< symplectic_mixedvar<T> >(&integrator);
+        }
+
+    }
+}
+
+#endif // SMARTMATH_STEPPER_H
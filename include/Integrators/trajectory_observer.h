@@ -0,0 +1,77 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_TRAJECTORY_OBSERVER_H
+#define SMARTMATH_TRAJECTORY_OBSERVER_H
+
+#include "base_observer.h"
+#include "../Utils/trajectory_file.h"
+#include "../Utils/async_trajectory_writer.h"
+
+namespace smartmath
+{
+    namespace integrator {
+
+        /**
+         * @brief The %trajectory_observer class streams the states computed by an integrator to a binary trajectory file
+         *
+         * Unlike the history, the file starts with the initial state. The states are written as they are observed, so that the trajectory is never held in memory.
+         * The writer is not closed by the observer: several integrations can be appended to the same file before calling close().
+         * Writer is %trajectory_writer to write on the integration thread or %async_trajectory_writer to write from a background thread.
+         */
+        template < class T, class State = std::vector<T>, class Writer = trajectory_writer<T> >
+        class trajectory_observer: public base_observer<T, State>
+        {
+
+        public:
+            /**
+             * @brief trajectory_observer constructor
+             * @param writer trajectory file to be written, which needs to outlive the observer
+             * @param skip_initial true not to write the initial state, e.g. when it is the final state of a previous integration already written
+             */
+            trajectory_observer(Writer &writer, const bool &skip_initial = false): m_writer(writer), m_skip_initial(skip_initial){}
+
+            /**
+             * @brief start writes the initial state
+             * @param[in] t0 initial time instant
+             * @param[in] x0 vector of initial states
+             */
+            void start(const double &t0, const State &x0){
+                if(std::size_t(x0.size()) != m_writer.get_dimension())
+                    smartmath_throw("TRAJECTORY_OBSERVER: the state dimension does not match the one of the file");
+                if(!m_skip_initial)
+                    m_writer.append(t0, x0);
+            }
+
+            /**
+             * @brief observe writes a state
+             * @param[in] t time at the end of the step
+             * @param[in] x vector of states at time t
+             */
+            void observe(const double &t, const State &x){
+                SMARTMATH_TRACE_SCOPE("write");
+                m_writer.append(t, x);
+            }
+
+        private:
+            /**
+             * @brief m_writer trajectory file
+             */
+            Writer &m_writer;
+            /**
+             * @brief m_skip_initial true not to write the initial state
+             */
+            bool m_skip_initial;
+        };
+
+    }
+}
+
+#endif // SMARTMATH_TRAJECTORY_OBSERVER_H
@@ -0,0 +1,293 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_ASYNC_TRAJECTORY_WRITER_H
+#define SMARTMATH_ASYNC_TRAJECTORY_WRITER_H
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include "../exception.h"
+#include "trajectory_file.h"
+
+namespace smartmath
+{
+
+    /**
+     * @brief The %async_trajectory_writer class writes a binary trajectory file from a background thread
+     *
+     * The states appended by the integration thread are copied into a ring of preallocated blocks of block_states states. A full block is handed to the writing thread
+     * through a single-producer/single-consumer lock-free ring (two atomic counters), so that the integration only waits when all the blocks are waiting to be written (back-pressure).
+     * close() hands the last partial block over, waits for all the blocks to be written and finalises the file. Only one thread may call append() and close().
+     * The file is the same as the one written by %trajectory_writer.
+     */
+    template < class T >
+    class async_trajectory_writer
+    {
+
+    public:
+        /**
+         * @brief async_trajectory_writer constructor opening the file and starting the writing thread
+         * @param filename path of the file, which is overwritten if it exists
+         * @param dimension number of scalars in a state
+         * @param block_states number of states in a block
+         * @param blocks number of blocks in the ring
+         * @param buffer_size size in bytes of the write buffer of the file
+         * @param codec compression of the states, done by the writing thread
+         */
+        async_trajectory_writer(const std::string &filename, const std::size_t &dimension, const std::size_t &block_states = 1024, const std::size_t &blocks = 8, const std::size_t &buffer_size = 1 << 20,
+                                const trajectory_codec &codec = trajectory_codec()):
+            m_writer(filename, dimension, trajectory_scalar<T>::code, buffer_size, codec), m_dimension(dimension), m_block_states(block_states), m_blocks(blocks),
+            m_times(block_states * blocks), m_states(block_states * blocks * dimension), m_counts(blocks, 0), m_fill(0), m_count(0), m_stalls(0), m_closed(false),
+            m_head(0), m_tail(0), m_done(false), m_failed(false){
+
+            if(block_states == 0 || blocks < 2)
+                smartmath_throw("ASYNC_TRAJECTORY_WRITER: the ring needs at least two blocks of one state");
+
+            m_thread = std::thread(&async_trajectory_writer::run, this);
+        }
+
+        /**
+         * @brief ~async_trajectory_writer closes the file if close() has not been called
+         */
+        ~async_trajectory_writer(){
+            if(!m_closed)
+            {
+                try
+                {
+                    close();
+                }
+                catch(const std::exception &e)
+                {
+                    std::cerr << e.what() << std::endl;
+                }
+            }
+        }
+
+        /**
+         * @brief append copies a state in the current block, waiting for a free block if the writing thread is behind
+         * @param[in] t time
+         * @param[in] x contiguous state at time t (std::vector, std::array or Eigen vector)
+         */
+        template < class State >
+        void append(const double &t, const State &x){
+            /* checked at every level since a shorter state would be read past its end */
+            if(std::size_t(x.size()) != m_dimension)
+                smartmath_throw("ASYNC_TRAJECTORY_WRITER: the state dimension does not match the one of the file");
+            if(m_closed)
+                smartmath_throw("ASYNC_TRAJECTORY_WRITER: the file is closed");
+
+            /* a new block can only be filled once the writing thread has released it */
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            if(m_fill == 0 && head - m_tail.load(std::memory_order_acquire) == m_blocks)
+            {
+                m_stalls++;
+                unsigned int spins = 0;
+                while(head - m_tail.load(std::memory_order_acquire) == m_blocks)
+                {
+                    if(m_failed.load(std::memory_order_acquire))
+                        break;
+                    backoff(spins);
+                }
+            }
+            if(m_failed.load(std::memory_order_acquire))
+                smartmath_throw("ASYNC_TRAJECTORY_WRITER: " + m_error);
+
+            const std::size_t slot = (head % m_blocks) * m_block_states + m_fill;
+            m_times[slot] = t;
+            const T *xi = x.data();
+            std::copy(xi, xi + m_dimension, m_states.begin() + slot * m_dimension);
+            m_count++;
+
+            if(++m_fill == m_block_states)
+                publish();
+        }
+
+        /**
+         * @brief close hands the last states over, waits for the writing thread and finalises the file
+         */
+        void close(){
+            if(m_closed)
+                return;
+            m_closed = true;
+
+            if(m_fill > 0)
+                publish();
+            m_done.store(true, std::memory_order_release);
+            m_thread.join();
+
+            if(m_failed.load(std::memory_order_acquire))
+                smartmath_throw("ASYNC_TRAJECTORY_WRITER: " + m_error);
+            m_writer.close();
+        }
+
+        /**
+         * @brief get_dimension returns the number of scalars in a state
+         * @return dimension
+         */
+        std::size_t get_dimension() const{
+            return m_dimension;
+        }
+
+        /**
+         * @brief get_count returns the number of states appended so far
+         * @return number of states
+         */
+        std::size_t get_count() const{
+            return m_count;
+        }
+
+        /**
+         * @brief get_stalls returns the number of times the integration thread had to wait for the writing thread
+         * @return number of stalls
+         */
+        std::size_t get_stalls() const{
+            return m_stalls;
+        }
+
+    private:
+        async_trajectory_writer(const async_trajectory_writer &);
+        async_trajectory_writer &operator=(const async_trajectory_writer &);
+
+        /**
+         * @brief publish hands the current block over to the writing thread
+         */
+        void publish(){
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+            m_counts[head % m_blocks] = m_fill;
+            m_fill = 0;
+            m_head.store(head + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief backoff waits a little, first by yielding and then by sleeping
+         * @param[in,out] spins number of times the caller has already waited
+         */
+        static void backoff(unsigned int &spins){
+            if(spins < 64)
+            {
+                spins++;
+                std::this_thread::yield();
+            }
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        /**
+         * @brief run writes the blocks handed over until close() is called
+         */
+        void run(){
+            try
+            {
+                unsigned int spins = 0;
+                while(true)
+                {
+                    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                    if(tail == m_head.load(std::memory_order_acquire))
+                    {
+                        /* the last block is published before m_done is set */
+                        if(m_done.load(std::memory_order_acquire) && tail == m_head.load(std::memory_order_acquire))
+                            break;
+                        backoff(spins);
+                        continue;
+                    }
+                    spins = 0;
+
+                    const std::size_t block = tail % m_blocks;
+                    m_writer.append(&m_times[block * m_block_states], &m_states[block * m_block_states * m_dimension], m_counts[block]);
+                    m_tail.store(tail + 1, std::memory_order_release);
+                }
+            }
+            catch(const std::exception &e)
+            {
+                m_error = e.what();
+                m_failed.store(true, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief m_writer trajectory file, only accessed by the writing thread until close()
+         */
+        trajectory_file_writer m_writer;
+        /**
+         * @brief m_dimension number of scalars in a state
+         */
+        std::size_t m_dimension;
+        /**
+         * @brief m_block_states number of states in a block
+         */
+        std::size_t m_block_states;
+        /**
+         * @brief m_blocks number of blocks in the ring
+         */
+        std::size_t m_blocks;
+        /**
+         * @brief m_times times of the blocks
+         */
+        std::vector<double> m_times;
+        /**
+         * @brief m_states states of the blocks
+         */
+        std::vector<T> m_states;
+        /**
+         * @brief m_counts number of states in each published block
+         */
+        std::vector<std::size_t> m_counts;
+        /**
+         * @brief m_fill number of states in the block being filled
+         */
+        std::size_t m_fill;
+        /**
+         * @brief m_count number of states appended
+         */
+        std::size_t m_count;
+        /**
+         * @brief m_stalls number of waits for a free block
+         */
+        std::size_t m_stalls;
+        /**
+         * @brief m_closed true once close() has been called
+         */
+        bool m_closed;
+        /**
+         * @brief m_error message of the error raised by the writing thread
+         */
+        std::string m_error;
+        /**
+         * @brief m_thread writing thread
+         */
+        std::thread m_thread;
+        /**
+         * @brief m_head number of blocks published by the integration thread (padded to its own cache line)
+         */
+        char m_padding_head[64];
+        std::atomic<std::size_t> m_head;
+        /**
+         * @brief m_tail number of blocks written by the writing thread (padded to its own cache line)
+         */
+        char m_padding_tail[64];
+        std::atomic<std::size_t> m_tail;
+        char m_padding_end[64];
+        /**
+         * @brief m_done true once the last block has been published
+         */
+        std::atomic<bool> m_done;
+        /**
+         * @brief m_failed true if the writing thread has stopped on an error
+         */
+        std::atomic<bool> m_failed;
+    };
+
+}
+
+#endif // SMARTMATH_ASYNC_TRAJECTORY_WRITER_H
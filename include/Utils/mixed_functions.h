@@ -26,8 +26,16 @@
 #include <vector>
 #include <cmath>
 #include <iostream>
+/* Eigen triggers -Wint-in-bool-context with recent GCC */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wint-in-bool-context"
+#endif
 #include "../LinearAlgebra/Eigen/Eigen"
 #include "../LinearAlgebra/Eigen/Core"
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
 #include "../exception.h"
 #include <time.h>
 #include <functional>
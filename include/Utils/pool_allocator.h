@@ -0,0 +1,534 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_POOL_ALLOCATOR_H
+#define SMARTMATH_POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <type_traits>
+#include "../exception.h"
+
+namespace smartmath
+{
+
+    /**
+     * @brief The %memory_pool class is a per-thread cache of memory blocks sorted by size class
+     *
+     * Blocks are rounded up to a power of two between 16 bytes and 1 MiB and are kept in a free list when released, so that a block of the same class is reused by the next allocation instead of going back to the heap.
+     * Each block is allocated individually, hence a block released by another thread than the one that allocated it simply joins the free list of the releasing thread. Larger requests are forwarded to the heap.
+     * Since blocks migrate from producer to consumer threads, each free list is capped (4 MiB of blocks, at least 4 blocks) and the blocks released beyond the cap go back to the heap.
+     * The cached blocks are returned to the heap when the thread terminates; blocks released after that (e.g. by objects with static storage) go directly to the heap.
+     */
+    class memory_pool
+    {
+
+    public:
+        /**
+         * @brief local returns the pool of the calling thread
+         * @return reference to the pool
+         */
+        static memory_pool &local(){
+            static thread_local memory_pool pool;
+            return pool;
+        }
+
+        /**
+         * @brief acquire returns a block of at least the requested size from the pool of the calling thread
+         * @param bytes size in bytes
+         * @return pointer to the block
+         */
+        static void *acquire(const std::size_t &bytes){
+            if(terminated())
+                return ::operator new(bytes);
+            return local().allocate(bytes);
+        }
+
+        /**
+         * @brief recycle releases a block into the pool of the calling thread
+         * @param p pointer to the block
+         * @param bytes size requested at allocation
+         */
+        static void recycle(void *p, const std::size_t &bytes){
+            if(terminated())
+                ::operator delete(p);
+            else
+                local().deallocate(p, bytes);
+        }
+
+        /**
+         * @brief allocate returns a block of at least the requested size
+         * @param bytes size in bytes
+         * @return pointer to the block
+         */
+        void *allocate(const std::size_t &bytes){
+            const unsigned int k = size_class(bytes);
+            if(k >= m_nclasses)
+                return ::operator new(bytes);
+
+            if(m_free[k] != NULL)
+            {
+                block *b = m_free[k];
+                m_free[k] = b->next;
+                m_cached[k]--;
+                return b;
+            }
+
+            return ::operator new(m_minsize << k);
+        }
+
+        /**
+         * @brief deallocate releases a block into the free list of its size class
+         * @param p pointer to the block
+         * @param bytes size requested at allocation
+         */
+        void deallocate(void *p, const std::size_t &bytes){
+            const unsigned int k = size_class(bytes);
+            if((k >= m_nclasses) || (m_cached[k] >= capacity(k)))
+            {
+                ::operator delete(p);
+                return;
+            }
+
+            block *b = static_cast<block *>(p);
+            b->next = m_free[k];
+            m_free[k] = b;
+            m_cached[k]++;
+        }
+
+        /**
+         * @brief release returns all the cached blocks of the pool to the heap
+         */
+        void release(){
+            for(unsigned int k = 0; k < m_nclasses; k++)
+            {
+                while(m_free[k] != NULL)
+                {
+                    block *b = m_free[k];
+                    m_free[k] = b->next;
+                    ::operator delete(b);
+                }
+                m_cached[k] = 0;
+            }
+        }
+
+        /**
+         * @brief ~memory_pool
+         */
+        ~memory_pool(){
+            release();
+            terminated() = true;
+        }
+
+    private:
+        memory_pool(){
+            for(unsigned int k = 0; k < m_nclasses; k++)
+            {
+                m_free[k] = NULL;
+                m_cached[k] = 0;
+            }
+        }
+
+        memory_pool(const memory_pool &);
+        memory_pool &operator=(const memory_pool &);
+
+        /**
+         * @brief terminated tells whether the pool of the calling thread has already been destroyed
+         * @return reference to the flag
+         */
+        static bool &terminated(){
+            static thread_local bool flag = false;
+            return flag;
+        }
+
+        /**
+         * @brief size_class returns the index of the smallest class holding the requested size
+         * @param bytes size in bytes
+         * @return class index (m_nclasses or more for requests forwarded to the heap)
+         */
+        static unsigned int size_class(const std::size_t &bytes){
+            unsigned int k = 0;
+            std::size_t size = m_minsize;
+            while(size < bytes && k < m_nclasses)
+            {
+                size <<= 1;
+                k++;
+            }
+            return k;
+        }
+
+        /**
+         * @brief capacity returns the maximum number of blocks kept in the free list of a size class
+         * @param k class index
+         * @return number of blocks
+         */
+        static std::size_t capacity(const unsigned int &k){
+            const std::size_t n = m_maxcached / (m_minsize << k);
+            return (n < 4) ? 4 : n;
+        }
+
+        struct block
+        {
+            block *next;
+        };
+
+        static const std::size_t m_minsize = 16;
+        static const unsigned int m_nclasses = 17;
+        static const std::size_t m_maxcached = std::size_t(1) << 22;
+
+        /**
+         * @brief m_free heads of the free lists of each size class
+         */
+        block *m_free[m_nclasses];
+        /**
+         * @brief m_cached number of blocks in the free list of each size class
+         */
+        std::size_t m_cached[m_nclasses];
+    };
+
+    /**
+     * @brief The %pool_allocator class is a standard allocator drawing from the pool of the calling thread
+     *
+     * It is meant for the storage of states of heavy scalar types, e.g. std::vector<T, pool_allocator<T> > (see pooled_state), which is accepted as state type by the dynamics and the integrators.
+     * The temporary states created at each integration step then recycle the blocks released at the previous step instead of calling the heap.
+     */
+    template < class T >
+    class pool_allocator
+    {
+
+    public:
+        typedef T value_type;
+
+        pool_allocator(){}
+
+        template < class U >
+        pool_allocator(const pool_allocator<U> &){}
+
+        T *allocate(const std::size_t n){
+            return static_cast<T *>(memory_pool::acquire(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, const std::size_t n){
+            memory_pool::recycle(p, n * sizeof(T));
+        }
+    };
+
+    template < class T, class U >
+    bool operator==(const pool_allocator<T> &, const pool_allocator<U> &){
+        return true;
+    }
+
+    template < class T, class U >
+    bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &){
+        return false;
+    }
+
+    /**
+     * @brief pooled_state state vector whose storage is drawn from the thread-local pools
+     */
+    template < class T >
+    using pooled_state = std::vector<T, pool_allocator<T> >;
+
+    /**
+     * @brief The %monotonic_arena class is a bump allocator released all at once
+     *
+     * Allocations move a pointer forward in a chunk of memory and deallocations do nothing. reset() makes the whole memory available again while keeping the chunks, so that a computation repeated at each step (e.g. the work buffers of a dynamics) does not access the heap once the arena has grown to its needs.
+     * Everything allocated from the arena must be destroyed before the call to reset(): it is therefore suited to scratch data local to a step, not to states kept in a trajectory.
+     */
+    class monotonic_arena
+    {
+
+    public:
+        /**
+         * @brief monotonic_arena constructor
+         * @param capacity size in bytes of the first chunk
+         */
+        explicit monotonic_arena(const std::size_t &capacity = 65536): m_current(0), m_offset(0){
+            if(capacity == 0)
+                smartmath_throw("MONOTONIC_ARENA: the capacity needs to be positive");
+            m_chunks.push_back(chunk(capacity));
+        }
+
+        /**
+         * @brief ~monotonic_arena
+         */
+        ~monotonic_arena(){
+            for(unsigned int i = 0; i < m_chunks.size(); i++)
+                ::operator delete(m_chunks[i].data);
+        }
+
+        /**
+         * @brief allocate returns a block from the current chunk, moving to a new twice larger chunk when it is full
+         * @param bytes size in bytes
+         * @param alignment alignment in bytes (power of two)
+         * @return pointer to the block
+         */
+        void *allocate(const std::size_t &bytes, const std::size_t &alignment = alignof(std::max_align_t)){
+            while(true)
+            {
+                chunk &c = m_chunks[m_current];
+                std::size_t start = (m_offset + alignment - 1) & ~(alignment - 1);
+                if(start + bytes <= c.size)
+                {
+                    m_offset = start + bytes;
+                    return static_cast<char *>(c.data) + start;
+                }
+
+                m_current++;
+                m_offset = 0;
+                if(m_current == m_chunks.size())
+                {
+                    std::size_t size = 2 * c.size;
+                    while(size < bytes + alignment)
+                        size *= 2;
+                    m_chunks.push_back(chunk(size));
+                }
+            }
+        }
+
+        /**
+         * @brief reset makes all the memory of the arena available again
+         */
+        void reset(){
+            m_current = 0;
+            m_offset = 0;
+        }
+
+        /**
+         * @brief capacity returns the total size of the chunks owned by the arena
+         * @return size in bytes
+         */
+        std::size_t capacity() const{
+            std::size_t size = 0;
+            for(unsigned int i = 0; i < m_chunks.size(); i++)
+                size += m_chunks[i].size;
+            return size;
+        }
+
+    private:
+        monotonic_arena(const monotonic_arena &);
+        monotonic_arena &operator=(const monotonic_arena &);
+
+        struct chunk
+        {
+            explicit chunk(const std::size_t &n): data(::operator new(n)), size(n){}
+            void *data;
+            std::size_t size;
+        };
+
+        /**
+         * @brief m_chunks memory owned by the arena
+         */
+        std::vector<chunk> m_chunks;
+        /**
+         * @brief m_current index of the chunk in use
+         */
+        unsigned int m_current;
+        /**
+         * @brief m_offset first free byte in the chunk in use
+         */
+        std::size_t m_offset;
+    };
+
+    /**
+     * @brief The %arena_allocator class is a standard allocator drawing from a monotonic_arena
+     */
+    template < class T >
+    class arena_allocator
+    {
+
+    public:
+        typedef T value_type;
+
+        /**
+         * @brief arena_allocator constructor
+         * @param arena arena providing the memory, which needs to outlive the allocator
+         */
+        arena_allocator(monotonic_arena *arena): m_arena(arena){}
+
+        template < class U >
+        arena_allocator(const arena_allocator<U> &other): m_arena(other.get_arena()){}
+
+        T *allocate(const std::size_t n){
+            return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *, const std::size_t){}
+
+        monotonic_arena *get_arena() const{
+            return m_arena;
+        }
+
+    private:
+        monotonic_arena *m_arena;
+    };
+
+    template < class T, class U >
+    bool operator==(const arena_allocator<T> &a, const arena_allocator<U> &b){
+        return a.get_arena() == b.get_arena();
+    }
+
+    template < class T, class U >
+    bool operator!=(const arena_allocator<T> &a, const arena_allocator<U> &b){
+        return a.get_arena() != b.get_arena();
+    }
+
+    /**
+     * @brief The %step_scope class makes the arena of the calling thread available to step_allocator for the duration of an integration step
+     *
+     * The integrators open a scope around each step attempt. Scopes nest (e.g. the step of an initialiser inside the step of a multistep method) and the arena is reset when the outermost one ends, so that the temporaries of a step reuse the memory of the previous one.
+     * A persistent_scope inside a step makes the allocations go to the pools again, for objects outliving the step that are constructed during it.
+     */
+    class step_scope
+    {
+
+    public:
+        /**
+         * @brief step_scope constructor
+         */
+        step_scope(){
+            depth()++;
+        }
+
+        /**
+         * @brief ~step_scope resets the arena of the thread at the end of the outermost scope
+         */
+        ~step_scope(){
+            if(--depth() == 0)
+                arena().reset();
+        }
+
+        /**
+         * @brief active returns the arena to draw from, if any
+         * @return arena of the thread inside a step and outside a persistent_scope, NULL otherwise
+         */
+        static monotonic_arena *active(){
+            if((depth() == 0) || (suspended() != 0))
+                return NULL;
+            return &arena();
+        }
+
+    private:
+        friend class persistent_scope;
+
+        step_scope(const step_scope &);
+        step_scope &operator=(const step_scope &);
+
+        static monotonic_arena &arena(){
+            static thread_local monotonic_arena a;
+            return a;
+        }
+
+        static unsigned int &depth(){
+            static thread_local unsigned int n = 0;
+            return n;
+        }
+
+        static unsigned int &suspended(){
+            static thread_local unsigned int n = 0;
+            return n;
+        }
+    };
+
+    /**
+     * @brief The %persistent_scope class suspends the arena of the current step_scope, for objects outliving the step
+     */
+    class persistent_scope
+    {
+
+    public:
+        /**
+         * @brief persistent_scope constructor
+         */
+        persistent_scope(){
+            step_scope::suspended()++;
+        }
+
+        /**
+         * @brief ~persistent_scope
+         */
+        ~persistent_scope(){
+            step_scope::suspended()--;
+        }
+
+    private:
+        persistent_scope(const persistent_scope &);
+        persistent_scope &operator=(const persistent_scope &);
+    };
+
+    /**
+     * @brief The %step_allocator class is a standard allocator drawing from the arena of the step being computed, and from the pool of the calling thread otherwise
+     *
+     * The source is fixed when the container is constructed and is not propagated by assignment: a state constructed before the integration (the current state, a trajectory, a multistep history) keeps pooled memory when a temporary of a step is assigned to it,
+     * while a copy made during a step draws from the arena whatever the source. The temporaries of the integrators are then released all at once after each step.
+     * It can also be used inside a heavy scalar type T (e.g. for the coefficients of a polynomial) with the same rules. Objects drawing from the arena must not be swapped with others.
+     */
+    template < class T >
+    class step_allocator
+    {
+
+    public:
+        typedef T value_type;
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::false_type propagate_on_container_move_assignment;
+        typedef std::false_type propagate_on_container_swap;
+
+        step_allocator(): m_arena(step_scope::active()){}
+
+        template < class U >
+        step_allocator(const step_allocator<U> &other): m_arena(other.get_arena()){}
+
+        /**
+         * @brief select_on_container_copy_construction binds a copy to the current step rather than to the source
+         * @return allocator of the current step
+         */
+        step_allocator select_on_container_copy_construction() const{
+            return step_allocator();
+        }
+
+        T *allocate(const std::size_t n){
+            if(m_arena != NULL)
+                return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+            return static_cast<T *>(memory_pool::acquire(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, const std::size_t n){
+            if(m_arena == NULL)
+                memory_pool::recycle(p, n * sizeof(T));
+        }
+
+        monotonic_arena *get_arena() const{
+            return m_arena;
+        }
+
+    private:
+        monotonic_arena *m_arena;
+    };
+
+    template < class T, class U >
+    bool operator==(const step_allocator<T> &a, const step_allocator<U> &b){
+        return a.get_arena() == b.get_arena();
+    }
+
+    template < class T, class U >
+    bool operator!=(const step_allocator<T> &a, const step_allocator<U> &b){
+        return a.get_arena() != b.get_arena();
+    }
+
+    /**
+     * @brief step_state state vector whose temporaries are drawn from the arena of the integration step
+     */
+    template < class T >
+    using step_state = std::vector<T, step_allocator<T> >;
+
+}
+
+#endif // SMARTMATH_POOL_ALLOCATOR_H
@@ -11,5 +11,12 @@
 #define SMARTMATH_UTILS_H
 
 #include "mixed_functions.h"
+#include "state_traits.h"
+#include "state_view.h"
+#include "state_expression.h"
+#include "pool_allocator.h"
+#include "trajectory_file.h"
+#include "async_trajectory_writer.h"
+#include "trace.h"
 
 #endif // SMARTMATH_UTILS_H
@@ -0,0 +1,418 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_STATE_EXPRESSION_H
+#define SMARTMATH_STATE_EXPRESSION_H
+
+#include <vector>
+#include <initializer_list>
+#include <type_traits>
+#include "state_traits.h"
+
+/**
+ * @brief SMARTMATH_STRONG_INLINE forces the inlining of the evaluation loops of expressions, which compilers otherwise tend to keep out of line because of the size of the expression types
+ */
+#if defined(_MSC_VER)
+#define SMARTMATH_STRONG_INLINE __forceinline
+#elif defined(__GNUC__)
+#define SMARTMATH_STRONG_INLINE inline __attribute__((always_inline))
+#else
+#define SMARTMATH_STRONG_INLINE inline
+#endif
+
+namespace smartmath
+{
+
+    /**
+     * @brief The %state_expression class is the base of the expression templates on state vectors
+     *
+     * Sums, differences and scalings of states are not evaluated when they are written but build a lightweight expression object.
+     * The expression is evaluated component by component when it is assigned to a state, so that e.g. x + h * (a1 * k1 + a4 * k4) is computed in one single loop without any intermediate state vector.
+     * Since the components are computed independently, a state can appear on both sides of an assignment.
+     */
+    template < class E >
+    class state_expression
+    {
+
+    public:
+        /**
+         * @brief derived returns the actual expression
+         * @return reference to the derived expression
+         */
+        const E &derived() const{
+            return static_cast<const E &>(*this);
+        }
+
+        /**
+         * @brief size returns the number of components of the expression
+         * @return size of the expression
+         */
+        unsigned int size() const{
+            return derived().size();
+        }
+    };
+
+    template < class T >
+    class state_vector;
+
+    /**
+     * @brief The %state_operand class gives how an operand is stored inside an expression: intermediate expressions by value, state vectors by reference
+     */
+    template < class E >
+    struct state_operand
+    {
+        typedef const E type;
+    };
+
+    template < class T >
+    struct state_operand< state_vector<T> >
+    {
+        typedef const state_vector<T> &type;
+    };
+
+    /**
+     * @brief The %state_terminal class wraps any state (std::vector, std::array, Eigen vector) so that it can be used in an expression
+     *
+     * The wrapped state is referenced, not copied, and needs to outlive the expression.
+     */
+    template < class State >
+    class state_terminal: public state_expression< state_terminal<State> >
+    {
+
+    public:
+        typedef typename state_traits<State>::value_type value_type;
+
+        /**
+         * @brief state_terminal constructor
+         * @param x wrapped state
+         */
+        explicit state_terminal(const State &x): m_x(x){}
+
+        /**
+         * @brief operator [] access to a component
+         * @param i index of the component
+         * @return constant reference to the component
+         */
+        const value_type &operator[](const unsigned int &i) const{
+            return m_x[i];
+        }
+
+        /**
+         * @brief size returns the number of components of the wrapped state
+         * @return size of the state
+         */
+        unsigned int size() const{
+            return m_x.size();
+        }
+
+    private:
+        const State &m_x;
+    };
+
+    /**
+     * @brief The %state_sum class is the expression of the sum of two expressions
+     */
+    template < class E1, class E2 >
+    class state_sum: public state_expression< state_sum<E1, E2> >
+    {
+
+    public:
+        typedef typename E1::value_type value_type;
+
+        state_sum(const E1 &e1, const E2 &e2): m_e1(e1), m_e2(e2){}
+
+        value_type operator[](const unsigned int &i) const{
+            return m_e1[i] + m_e2[i];
+        }
+
+        unsigned int size() const{
+            return m_e1.size();
+        }
+
+    private:
+        typename state_operand<E1>::type m_e1;
+        typename state_operand<E2>::type m_e2;
+    };
+
+    /**
+     * @brief The %state_difference class is the expression of the difference of two expressions
+     */
+    template < class E1, class E2 >
+    class state_difference: public state_expression< state_difference<E1, E2> >
+    {
+
+    public:
+        typedef typename E1::value_type value_type;
+
+        state_difference(const E1 &e1, const E2 &e2): m_e1(e1), m_e2(e2){}
+
+        value_type operator[](const unsigned int &i) const{
+            return m_e1[i] - m_e2[i];
+        }
+
+        unsigned int size() const{
+            return m_e1.size();
+        }
+
+    private:
+        typename state_operand<E1>::type m_e1;
+        typename state_operand<E2>::type m_e2;
+    };
+
+    /**
+     * @brief The %state_scale class is the expression of the product of an expression by a scalar
+     *
+     * The scalar is either a floating point number or of the type of the components (e.g. a polynomial).
+     */
+    template < class S, class E >
+    class state_scale: public state_expression< state_scale<S, E> >
+    {
+
+    public:
+        typedef typename E::value_type value_type;
+
+        state_scale(const S &s, const E &e): m_s(s), m_e(e){}
+
+        value_type operator[](const unsigned int &i) const{
+            return m_s * m_e[i];
+        }
+
+        unsigned int size() const{
+            return m_e.size();
+        }
+
+    private:
+        const S m_s;
+        typename state_operand<E>::type m_e;
+    };
+
+    /**
+     * @brief The %is_state_scalar class tells whether S can multiply an expression with components of type T
+     */
+    template < class S, class T >
+    struct is_state_scalar
+    {
+        static const bool value = std::is_arithmetic<S>::value || std::is_same<S, T>::value;
+    };
+
+    template < class E1, class E2 >
+    state_sum<E1, E2> operator+(const state_expression<E1> &e1, const state_expression<E2> &e2){
+        return state_sum<E1, E2>(e1.derived(), e2.derived());
+    }
+
+    template < class E1, class E2 >
+    state_difference<E1, E2> operator-(const state_expression<E1> &e1, const state_expression<E2> &e2){
+        return state_difference<E1, E2>(e1.derived(), e2.derived());
+    }
+
+    template < class S, class E >
+    typename std::enable_if<is_state_scalar<S, typename E::value_type>::value, state_scale<S, E> >::type operator*(const S &s, const state_expression<E> &e){
+        return state_scale<S, E>(s, e.derived());
+    }
+
+    template < class S, class E >
+    typename std::enable_if<is_state_scalar<S, typename E::value_type>::value, state_scale<S, E> >::type operator*(const state_expression<E> &e, const S &s){
+        return state_scale<S, E>(s, e.derived());
+    }
+
+    template < class E >
+    state_scale<double, E> operator-(const state_expression<E> &e){
+        return state_scale<double, E>(-1.0, e.derived());
+    }
+
+    /**
+     * @brief make_state_expression wraps a state so that it can be used in an expression
+     * @param x state
+     * @return expression referencing the state
+     */
+    template < class State >
+    state_terminal<State> make_state_expression(const State &x){
+        return state_terminal<State>(x);
+    }
+
+    /**
+     * @brief state_assign evaluates an expression into a state in one single loop
+     * @param[out] x state, resized if needed
+     * @param[in] e expression
+     */
+    template < class State, class E >
+    SMARTMATH_STRONG_INLINE void state_assign(State &x, const state_expression<E> &e){
+        const E &expr = e.derived();
+        const unsigned int n = expr.size();
+        if(x.size() != n)
+            state_traits<State>::resize(x, n);
+        for(unsigned int i = 0; i < n; i++)
+            x[i] = expr[i];
+    }
+
+    /**
+     * @brief The %state_vector class is a state vector on which arithmetic builds expression templates
+     *
+     * It can be used as state type by the dynamics and the integrators, e.g. vanderpol<double, state_vector<double> >, and inside user-defined dynamics to write fused updates:
+     * dx = a * x + b * y;
+     */
+    template < class T >
+    class state_vector: public state_expression< state_vector<T> >
+    {
+
+    public:
+        typedef T value_type;
+
+        /**
+         * @brief state_vector constructor
+         * @param n number of components
+         * @param value value of the components
+         */
+        explicit state_vector(const unsigned int &n = 0, const T &value = T()): m_x(n, value){}
+
+        /**
+         * @brief state_vector constructor from a std::vector
+         * @param x components
+         */
+        state_vector(const std::vector<T> &x): m_x(x){}
+
+        /**
+         * @brief state_vector constructor from a list of components
+         * @param x components
+         */
+        state_vector(std::initializer_list<T> x): m_x(x){}
+
+        /**
+         * @brief state_vector constructor from an expression, evaluated in one single loop
+         * @param e expression
+         */
+        template < class E >
+        state_vector(const state_expression<E> &e): m_x(){
+            state_assign(*this, e);
+        }
+
+        /**
+         * @brief operator = evaluates an expression in one single loop
+         * @param e expression
+         * @return reference to the state
+         */
+        template < class E >
+        SMARTMATH_STRONG_INLINE state_vector &operator=(const state_expression<E> &e){
+            state_assign(*this, e);
+            return *this;
+        }
+
+        /**
+         * @brief operator += adds an expression in one single loop
+         * @param e expression
+         * @return reference to the state
+         */
+        template < class E >
+        SMARTMATH_STRONG_INLINE state_vector &operator+=(const state_expression<E> &e){
+            const E &expr = e.derived();
+            for(unsigned int i = 0; i < m_x.size(); i++)
+                m_x[i] += expr[i];
+            return *this;
+        }
+
+        /**
+         * @brief operator -= subtracts an expression in one single loop
+         * @param e expression
+         * @return reference to the state
+         */
+        template < class E >
+        SMARTMATH_STRONG_INLINE state_vector &operator-=(const state_expression<E> &e){
+            const E &expr = e.derived();
+            for(unsigned int i = 0; i < m_x.size(); i++)
+                m_x[i] -= expr[i];
+            return *this;
+        }
+
+        T &operator[](const unsigned int &i){
+            return m_x[i];
+        }
+
+        const T &operator[](const unsigned int &i) const{
+            return m_x[i];
+        }
+
+        unsigned int size() const{
+            return m_x.size();
+        }
+
+        void resize(const unsigned int &n){
+            m_x.resize(n);
+        }
+
+        T *data(){
+            return m_x.data();
+        }
+
+        const T *data() const{
+            return m_x.data();
+        }
+
+        typename std::vector<T>::iterator begin(){
+            return m_x.begin();
+        }
+
+        typename std::vector<T>::const_iterator begin() const{
+            return m_x.begin();
+        }
+
+        typename std::vector<T>::iterator end(){
+            return m_x.end();
+        }
+
+        typename std::vector<T>::const_iterator end() const{
+            return m_x.end();
+        }
+
+        /**
+         * @brief get_vector returns the components as a std::vector
+         * @return components
+         */
+        const std::vector<T> &get_vector() const{
+            return m_x;
+        }
+
+    private:
+        std::vector<T> m_x;
+    };
+
+    /**
+     * @brief Specialisation of %state_traits for state_vector
+     */
+    template < class T >
+    struct state_traits< state_vector<T> >
+    {
+        typedef T value_type;
+        typedef std::vector< state_vector<T> > history_type;
+        static const int dimension = -1;
+
+        /**
+         * @brief resize sets the dimension of a state
+         * @param[in,out] x state
+         * @param[in] n dimension
+         */
+        static void resize(state_vector<T> &x, const unsigned int &n){
+            x.resize(n);
+        }
+
+        /**
+         * @brief axpy performs the update y += a x
+         * @param[in,out] y state to be updated
+         * @param[in] a scalar factor
+         * @param[in] x increment
+         */
+        template < class S >
+        static void axpy(state_vector<T> &y, const S &a, const state_vector<T> &x){
+            y += a * x;
+        }
+    };
+
+}
+
+#endif // SMARTMATH_STATE_EXPRESSION_H
@@ -0,0 +1,151 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_STATE_TRAITS_H
+#define SMARTMATH_STATE_TRAITS_H
+
+#include <vector>
+#include <array>
+#include <cstddef>
+#include "../exception.h"
+/* Eigen triggers -Wint-in-bool-context with recent GCC */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wint-in-bool-context"
+#endif
+#include "../LinearAlgebra/Eigen/Core"
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace smartmath
+{
+
+    /**
+     * @brief The %state_traits class describes a type of state vector used by dynamics and integrators
+     *
+     * Integrators only require a state to be copyable, to be accessed with operator[] and to provide size() and data().
+     * The traits give in addition the scalar type, the dimension when known at compile time (-1 otherwise), the container used to store a trajectory, a way to resize a state and the update y += a x used in the integration steps.
+     * Heap-backed std::vector, fixed-size std::array and Eigen column vectors (fixed or dynamic size) are supported.
+     */
+    template < class State >
+    struct state_traits;
+
+    /**
+     * @brief Specialisation of %state_traits for std::vector (dimension known at run time)
+     */
+    template < class T, class Alloc >
+    struct state_traits< std::vector<T, Alloc> >
+    {
+        typedef T value_type;
+        typedef std::vector< std::vector<T, Alloc> > history_type;
+        static const int dimension = -1;
+
+        /**
+         * @brief resize sets the dimension of a state
+         * @param[in,out] x state
+         * @param[in] n dimension
+         */
+        static void resize(std::vector<T, Alloc> &x, const unsigned int &n){
+            x.resize(n);
+        }
+
+        /**
+         * @brief axpy performs the update y += a x
+         * @param[in,out] y state to be updated
+         * @param[in] a scalar factor
+         * @param[in] x increment
+         */
+        template < class S >
+        static void axpy(std::vector<T, Alloc> &y, const S &a, const std::vector<T, Alloc> &x){
+            for(unsigned int i = 0; i < y.size(); i++)
+                y[i] += a * x[i];
+        }
+    };
+
+    /**
+     * @brief Specialisation of %state_traits for std::array (dimension known at compile time)
+     */
+    template < class T, std::size_t N >
+    struct state_traits< std::array<T, N> >
+    {
+        typedef T value_type;
+        typedef std::vector< std::array<T, N> > history_type;
+        static const int dimension = N;
+
+        /**
+         * @brief resize checks the requested dimension of a state against the fixed one
+         * @param[in,out] x state
+         * @param[in] n dimension
+         */
+        static void resize(std::array<T, N> &x, const unsigned int &n){
+            if(n != N)
+                smartmath_throw("STATE_TRAITS: a fixed-size state cannot be resized");
+        }
+
+        /**
+         * @brief axpy performs the update y += a x
+         * @param[in,out] y state to be updated
+         * @param[in] a scalar factor
+         * @param[in] x increment
+         */
+        template < class S >
+        static void axpy(std::array<T, N> &y, const S &a, const std::array<T, N> &x){
+            for(unsigned int i = 0; i < y.size(); i++)
+                y[i] += a * x[i];
+        }
+    };
+
+    /**
+     * @brief Specialisation of %state_traits for Eigen column vectors
+     *
+     * The updates of the integration steps are Eigen expressions, vectorised when the scalar type allows it. Trajectories are stored with the aligned allocator required by fixed-size vectorisable Eigen types.
+     */
+    template < class T, int N, int Options, int MaxN >
+    struct state_traits< Eigen::Matrix<T, N, 1, Options, MaxN, 1> >
+    {
+        typedef Eigen::Matrix<T, N, 1, Options, MaxN, 1> state_type;
+        typedef T value_type;
+        typedef std::vector< state_type, Eigen::aligned_allocator<state_type> > history_type;
+        static const int dimension = N;
+
+        /**
+         * @brief resize sets the dimension of a state (only checks it for a fixed-size vector)
+         * @param[in,out] x state
+         * @param[in] n dimension
+         */
+        static void resize(state_type &x, const unsigned int &n){
+            if(N == Eigen::Dynamic)
+                x.resize(n);
+            else if(int(n) != N)
+                smartmath_throw("STATE_TRAITS: a fixed-size state cannot be resized");
+        }
+
+        /**
+         * @brief axpy performs the update y += a x
+         * @param[in,out] y state to be updated
+         * @param[in] a scalar factor
+         * @param[in] x increment
+         */
+        template < class S >
+        static void axpy(state_type &y, const S &a, const state_type &x){
+            y += a * x;
+        }
+    };
+
+    /**
+     * @brief state_history container used to store a trajectory made of states of type State
+     */
+    template < class State >
+    using state_history = typename state_traits<State>::history_type;
+
+}
+
+#endif // SMARTMATH_STATE_TRAITS_H
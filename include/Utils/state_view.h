@@ -0,0 +1,154 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_STATE_VIEW_H
+#define SMARTMATH_STATE_VIEW_H
+
+#include <type_traits>
+
+namespace smartmath
+{
+
+    /**
+     * @brief The %state_view class is a non-owning strided view on the components of a state vector
+     *
+     * A view is a pointer, a size and a stride. It can be built implicitly from any contiguous container providing data() and size() (std::vector, std::array, Eigen vectors) or on a part of it, e.g. one half of a Hamiltonian state.
+     * Writing through a view never allocates, which is why views are used for the outputs of the partial derivatives of Hamiltonian systems: the caller provides buffers of the correct size.
+     */
+    template < class T >
+    class state_view
+    {
+
+    public:
+        /**
+         * @brief state_view constructor from a pointer
+         * @param data pointer to the first component
+         * @param size number of components
+         * @param stride distance between two consecutive components
+         */
+        state_view(T *data, const unsigned int &size, const unsigned int &stride = 1): m_data(data), m_size(size), m_stride(stride){}
+
+        /**
+         * @brief state_view constructor from a contiguous container
+         * @param x container
+         */
+        template < class Container, class = typename std::enable_if<!std::is_same<Container, state_view<T> >::value>::type >
+        state_view(Container &x): m_data(x.data()), m_size(x.size()), m_stride(1){}
+
+        /**
+         * @brief operator [] access to a component
+         * @param i index of the component
+         * @return reference to the component
+         */
+        T &operator[](const unsigned int &i) const{
+            return m_data[i * m_stride];
+        }
+
+        /**
+         * @brief size returns the number of components
+         * @return size of the view
+         */
+        unsigned int size() const{
+            return m_size;
+        }
+
+        /**
+         * @brief stride returns the distance between two consecutive components
+         * @return stride of the view
+         */
+        unsigned int stride() const{
+            return m_stride;
+        }
+
+        /**
+         * @brief data returns a pointer to the first component
+         * @return pointer to the first component
+         */
+        T *data() const{
+            return m_data;
+        }
+
+    private:
+        T *m_data;
+        unsigned int m_size;
+        unsigned int m_stride;
+    };
+
+    /**
+     * @brief The %const_state_view class is a read-only non-owning strided view on the components of a state vector
+     */
+    template < class T >
+    class const_state_view
+    {
+
+    public:
+        /**
+         * @brief const_state_view constructor from a pointer
+         * @param data pointer to the first component
+         * @param size number of components
+         * @param stride distance between two consecutive components
+         */
+        const_state_view(const T *data, const unsigned int &size, const unsigned int &stride = 1): m_data(data), m_size(size), m_stride(stride){}
+
+        /**
+         * @brief const_state_view constructor from a mutable view
+         * @param x view
+         */
+        const_state_view(const state_view<T> &x): m_data(x.data()), m_size(x.size()), m_stride(x.stride()){}
+
+        /**
+         * @brief const_state_view constructor from a contiguous container
+         * @param x container
+         */
+        template < class Container >
+        const_state_view(const Container &x): m_data(x.data()), m_size(x.size()), m_stride(1){}
+
+        /**
+         * @brief operator [] access to a component
+         * @param i index of the component
+         * @return constant reference to the component
+         */
+        const T &operator[](const unsigned int &i) const{
+            return m_data[i * m_stride];
+        }
+
+        /**
+         * @brief size returns the number of components
+         * @return size of the view
+         */
+        unsigned int size() const{
+            return m_size;
+        }
+
+        /**
+         * @brief stride returns the distance between two consecutive components
+         * @return stride of the view
+         */
+        unsigned int stride() const{
+            return m_stride;
+        }
+
+        /**
+         * @brief data returns a pointer to the first component
+         * @return pointer to the first component
+         */
+        const T *data() const{
+            return m_data;
+        }
+
+    private:
+        const T *m_data;
+        unsigned int m_size;
+        unsigned int m_stride;
+    };
+
+}
+
+#endif // SMARTMATH_STATE_VIEW_H
@@ -0,0 +1,113 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_TRACE_H
+#define SMARTMATH_TRACE_H
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+#include "../exception.h"
+
+/* Trace points of the integrators:
+ * SMARTMATH_TRACE_SCOPE(name) records the duration of the enclosing scope under name, which must be a string literal.
+ * The trace points are compiled only if SMARTMATH_TRACE is defined (option SMARTMATH_TRACE of CMake) and expand to nothing otherwise. */
+#define SMARTMATH_TRACE_CONCAT_IMPL(a, b) a##b
+#define SMARTMATH_TRACE_CONCAT(a, b) SMARTMATH_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef SMARTMATH_TRACE
+#define SMARTMATH_TRACE_SCOPE(name) smartmath::trace_scope SMARTMATH_TRACE_CONCAT(smartmath_trace_scope_, __LINE__)(name)
+#else
+#define SMARTMATH_TRACE_SCOPE(name) ((void)0)
+#endif
+
+namespace smartmath
+{
+
+    /**
+     * @brief trace_clock returns the time used by the trace
+     * @return nanoseconds elapsed since the start of the program
+     */
+    int64_t trace_clock();
+
+    /**
+     * @brief trace_record appends a complete event to the trace buffer of the calling thread
+     *
+     * Each thread writes into its own buffer, taken at its first event, so that recording only takes a lock then. The buffer of an exited thread is reused by the next one, its events being kept,
+     * so that the memory is bounded by the number of threads tracing at the same time. The events are stored in chunks allocated as they are filled, and dropped once the buffer is full.
+     * @param[in] name name of the event, which must outlive the trace (string literal)
+     * @param[in] begin start of the event (see trace_clock)
+     * @param[in] end end of the event (see trace_clock)
+     */
+    void trace_record(const char *name, const int64_t &begin, const int64_t &end);
+
+    /**
+     * @brief trace_set_capacity sets the maximum number of events of the trace buffers created from now on
+     * @param[in] events number of events per thread (default 1048576)
+     */
+    void trace_set_capacity(const std::size_t &events);
+
+    /**
+     * @brief trace_clear discards the recorded events, which must not be done while another thread is recording
+     */
+    void trace_clear();
+
+    /**
+     * @brief trace_dropped returns the number of events dropped because a buffer was full
+     * @return number of events
+     */
+    std::size_t trace_dropped();
+
+    /**
+     * @brief trace_write writes the recorded events to a file in the Chrome trace event format (JSON), which can be opened with chrome://tracing or Perfetto
+     *
+     * The events recorded by other threads while writing may or may not be in the file.
+     * @param[in] filename path of the file, which is overwritten if it exists
+     * @return number of events written
+     */
+    std::size_t trace_write(const std::string &filename);
+
+    /**
+     * @brief The %trace_scope class records the duration between its construction and its destruction, used through SMARTMATH_TRACE_SCOPE
+     */
+    class trace_scope
+    {
+
+    public:
+        /**
+         * @brief trace_scope constructor starting the event
+         * @param name name of the event (string literal)
+         */
+        explicit trace_scope(const char *name): m_name(name), m_begin(trace_clock()){}
+
+        /**
+         * @brief ~trace_scope records the event
+         */
+        ~trace_scope(){
+            trace_record(m_name, m_begin, trace_clock());
+        }
+
+    private:
+        trace_scope(const trace_scope &);
+        trace_scope &operator=(const trace_scope &);
+
+        /**
+         * @brief m_name name of the event
+         */
+        const char *m_name;
+        /**
+         * @brief m_begin start of the event
+         */
+        int64_t m_begin;
+    };
+
+}
+
+#endif // SMARTMATH_TRACE_H
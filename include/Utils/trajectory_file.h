@@ -0,0 +1,503 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#ifndef SMARTMATH_TRAJECTORY_FILE_H
+#define SMARTMATH_TRAJECTORY_FILE_H
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstddef>
+#include <stdint.h>
+#include "../exception.h"
+#include "state_view.h"
+
+namespace smartmath
+{
+
+    /**
+     * @brief The %trajectory_header struct is the header at the beginning of a binary trajectory file
+     *
+     * A trajectory file is made of this header padded to trajectory_header::size bytes, followed by the block of the count states stored contiguously (dimension scalars each)
+     * and by the block of the count times stored as doubles. Both blocks start at an offset multiple of 64 bytes. All values are in the byte order of the machine that wrote the file.
+     * A file whose time offset is zero has not been closed properly, e.g. after a crash during the integration.
+     *
+     * When the file is compressed (codec different from zero), the block of states is a sequence of chunks of chunk_states states encoded with encode_trajectory_chunk(),
+     * and time_offset points to the index of the chunks instead: the offsets of the chunks followed by the end of the last one, as 64-bit integers.
+     */
+    struct trajectory_header
+    {
+        /**
+         * @brief size size in bytes of the header on disk, including the padding
+         */
+        static const std::size_t size = 64;
+        /**
+         * @brief current_version version of the format written by this library
+         */
+        static const uint32_t current_version = 1;
+
+        /**
+         * @brief magic identifier of the format "SMTRAJ" followed by two zeros
+         */
+        char magic[8];
+        /**
+         * @brief version version of the format
+         */
+        uint32_t version;
+        /**
+         * @brief scalar_type code of the scalar type of the states (4 for float, 8 for double)
+         */
+        uint32_t scalar_type;
+        /**
+         * @brief dimension number of scalars in a state
+         */
+        uint64_t dimension;
+        /**
+         * @brief count number of states in the file
+         */
+        uint64_t count;
+        /**
+         * @brief state_offset offset in bytes of the block of states
+         */
+        uint64_t state_offset;
+        /**
+         * @brief time_offset offset in bytes of the block of times
+         */
+        uint64_t time_offset;
+        /**
+         * @brief codec method of compression of the states (0 for none, see %trajectory_codec)
+         */
+        uint32_t codec;
+        /**
+         * @brief chunk_states number of states per chunk of a compressed file
+         */
+        uint32_t chunk_states;
+        /**
+         * @brief tolerance maximum absolute error on the states of a file compressed with quantisation
+         */
+        double tolerance;
+    };
+
+    /**
+     * @brief The %trajectory_codec struct selects the compression of a trajectory file
+     *
+     * Trajectories are encoded by chunks of chunk_states states, each state being predicted from the two previous ones of the chunk by linear extrapolation.
+     * The lossless method stores the exclusive or of the bits of each scalar and of its prediction without its leading zero bytes, as in the FPC and Gorilla schemes.
+     * The quantised method stores the difference to the prediction as an integer number of 2 tolerance, so that each scalar is recovered with an absolute error at most tolerance.
+     * In both cases the times are encoded losslessly. Smooth trajectories typically take a fraction of their raw size, at the cost of losing the random access without decoding.
+     */
+    struct trajectory_codec
+    {
+        /**
+         * @brief methods of compression
+         */
+        enum method_type {
+            none = 0,
+            lossless = 1,
+            quantised = 2
+        };
+
+        trajectory_codec(const method_type &m = none, const double &tol = 0.0, const unsigned int &chunk = 4096): method(m), tolerance(tol), chunk_states(chunk){}
+
+        /**
+         * @brief method method of compression
+         */
+        method_type method;
+        /**
+         * @brief tolerance maximum absolute error on each scalar of the states for the quantised method
+         */
+        double tolerance;
+        /**
+         * @brief chunk_states number of states per chunk
+         */
+        unsigned int chunk_states;
+    };
+
+    /**
+     * @brief encode_trajectory_chunk compresses consecutive states and appends them to a buffer
+     * @param[in] codec compression (not none)
+     * @param[in] dimension number of scalars in a state
+     * @param[in] scalar_type code of the scalar type of the states
+     * @param[in] count number of states, at most codec.chunk_states
+     * @param[in] t pointer to the count times
+     * @param[in] x pointer to the count states stored contiguously
+     * @param[in,out] out buffer to which the encoded chunk is appended
+     */
+    void encode_trajectory_chunk(const trajectory_codec &codec, const std::size_t &dimension, const uint32_t &scalar_type, const std::size_t &count,
+                                 const double *t, const void *x, std::vector<char> &out);
+
+    /**
+     * @brief decode_trajectory_chunk decompresses a chunk encoded with encode_trajectory_chunk()
+     *
+     * A chunk holding more states than capacity is rejected with an exception before anything is written.
+     * @param[in] codec compression used to encode the chunk
+     * @param[in] dimension number of scalars in a state
+     * @param[in] scalar_type code of the scalar type of the states
+     * @param[in] data first byte of the chunk
+     * @param[in] length number of bytes available from data
+     * @param[in] capacity number of states (and times) for which t and x have room, at most codec.chunk_states
+     * @param[out] t pointer to room for capacity times (NULL to skip the times)
+     * @param[out] x pointer to room for capacity states (NULL to skip the states)
+     * @return number of states in the chunk
+     */
+    std::size_t decode_trajectory_chunk(const trajectory_codec &codec, const std::size_t &dimension, const uint32_t &scalar_type,
+                                        const char *data, const std::size_t &length, const std::size_t &capacity, double *t, void *x);
+
+    /**
+     * @brief The %trajectory_scalar struct gives the code of a scalar type in a trajectory file (only float and double are supported)
+     */
+    template < class T >
+    struct trajectory_scalar;
+
+    template <>
+    struct trajectory_scalar<float>
+    {
+        enum { code = 4 };
+    };
+
+    template <>
+    struct trajectory_scalar<double>
+    {
+        enum { code = 8 };
+    };
+
+    /**
+     * @brief The %trajectory_file_writer class writes a binary trajectory file as a stream of states
+     *
+     * The states are written to disk through a large buffer as they are appended, so that the memory used does not depend on the length of the trajectory apart from the times (one double per state),
+     * which are kept in memory and written as a contiguous block by close(). The header is updated by close() as well.
+     * With a compression codec, the states and times are gathered in a chunk which is encoded and written once full, so that only the index of the chunks is kept until close().
+     */
+    class trajectory_file_writer
+    {
+
+    public:
+        /**
+         * @brief trajectory_file_writer constructor opening the file
+         * @param filename path of the file, which is overwritten if it exists
+         * @param dimension number of scalars in a state
+         * @param scalar_type code of the scalar type of the states
+         * @param buffer_size size in bytes of the write buffer
+         * @param codec compression of the states
+         */
+        trajectory_file_writer(const std::string &filename, const std::size_t &dimension, const uint32_t &scalar_type, const std::size_t &buffer_size = 1 << 20,
+                               const trajectory_codec &codec = trajectory_codec());
+
+        /**
+         * @brief ~trajectory_file_writer closes the file if close() has not been called
+         */
+        ~trajectory_file_writer();
+
+        /**
+         * @brief append writes a state at the end of the trajectory
+         * @param[in] t time
+         * @param[in] x pointer to the dimension scalars of the state at time t
+         */
+        void append(const double &t, const void *x);
+
+        /**
+         * @brief append writes a block of consecutive states at the end of the trajectory
+         * @param[in] t pointer to the count times
+         * @param[in] x pointer to the count states stored contiguously
+         * @param[in] count number of states
+         */
+        void append(const double *t, const void *x, const std::size_t &count);
+
+        /**
+         * @brief close writes the times and the header and closes the file
+         */
+        void close();
+
+        /**
+         * @brief get_count returns the number of states appended so far
+         * @return number of states
+         */
+        std::size_t get_count() const{
+            return m_count;
+        }
+
+        /**
+         * @brief get_dimension returns the number of scalars in a state
+         * @return dimension
+         */
+        std::size_t get_dimension() const{
+            return m_dimension;
+        }
+
+    private:
+        trajectory_file_writer(const trajectory_file_writer &);
+        trajectory_file_writer &operator=(const trajectory_file_writer &);
+
+        /**
+         * @brief pad writes zeros up to the next multiple of 64 bytes
+         * @return true if the padding has been written
+         */
+        bool pad();
+
+        /**
+         * @brief write_chunk encodes and writes the current chunk of a compressed file
+         */
+        void write_chunk();
+
+        /**
+         * @brief m_filename path of the file
+         */
+        std::string m_filename;
+        /**
+         * @brief m_file file being written (NULL once closed)
+         */
+        FILE *m_file;
+        /**
+         * @brief m_buffer write buffer of the file
+         */
+        std::vector<char> m_buffer;
+        /**
+         * @brief m_dimension number of scalars in a state
+         */
+        std::size_t m_dimension;
+        /**
+         * @brief m_scalar_type code of the scalar type
+         */
+        uint32_t m_scalar_type;
+        /**
+         * @brief m_position current position in the file
+         */
+        uint64_t m_position;
+        /**
+         * @brief m_count number of states appended
+         */
+        std::size_t m_count;
+        /**
+         * @brief m_times times of the appended states (of the current chunk for a compressed file)
+         */
+        std::vector<double> m_times;
+        /**
+         * @brief m_codec compression of the states
+         */
+        trajectory_codec m_codec;
+        /**
+         * @brief m_chunk states of the current chunk of a compressed file
+         */
+        std::vector<char> m_chunk;
+        /**
+         * @brief m_encoded encoded chunk
+         */
+        std::vector<char> m_encoded;
+        /**
+         * @brief m_chunk_offsets offsets of the chunks written
+         */
+        std::vector<uint64_t> m_chunk_offsets;
+    };
+
+    /**
+     * @brief The %trajectory_file_reader class maps a binary trajectory file in memory
+     *
+     * The file is mapped read-only with mmap (read in memory on platforms without it) and its blocks are accessed in place: no state is parsed nor copied,
+     * and only the pages actually accessed are loaded by the operating system. The pointers returned are valid as long as the reader exists.
+     * The times of a compressed file are decoded when it is opened, and its states one chunk at a time when they are accessed: a pointer to a state is then only valid until a state of another chunk is accessed,
+     * and a reader of a compressed file must not be shared between threads.
+     */
+    class trajectory_file_reader
+    {
+
+    public:
+        /**
+         * @brief trajectory_file_reader constructor mapping the file and checking its header
+         * @param filename path of the file
+         */
+        trajectory_file_reader(const std::string &filename);
+
+        /**
+         * @brief ~trajectory_file_reader unmaps the file
+         */
+        ~trajectory_file_reader();
+
+        /**
+         * @brief get_header returns the header of the file
+         * @return header
+         */
+        const trajectory_header &get_header() const{
+            return m_header;
+        }
+
+        /**
+         * @brief size returns the number of states in the file
+         * @return number of states
+         */
+        std::size_t size() const{
+            return m_header.count;
+        }
+
+        /**
+         * @brief dimension returns the number of scalars in a state
+         * @return dimension
+         */
+        std::size_t dimension() const{
+            return m_header.dimension;
+        }
+
+        /**
+         * @brief times returns the block of times
+         * @return pointer to the size() times
+         */
+        const double *times() const{
+            if(m_header.codec != trajectory_codec::none)
+                return m_times.empty() ? NULL : &m_times[0];
+            return reinterpret_cast<const double *>(m_data + m_header.time_offset);
+        }
+
+        /**
+         * @brief states returns the block of states
+         * @return pointer to the first scalar of the first state (NULL for a compressed file)
+         */
+        const void *states() const{
+            if(m_header.codec != trajectory_codec::none)
+                return NULL;
+            return m_data + m_header.state_offset;
+        }
+
+        /**
+         * @brief is_compressed tells whether the states of the file are compressed
+         * @return true if the file is compressed
+         */
+        bool is_compressed() const{
+            return m_header.codec != trajectory_codec::none;
+        }
+
+        /**
+         * @brief state_data returns a state, decoding its chunk if the file is compressed
+         * @param i index of the state
+         * @return pointer to the first scalar of the i-th state
+         */
+        const void *state_data(const std::size_t &i) const;
+
+    private:
+        trajectory_file_reader(const trajectory_file_reader &);
+        trajectory_file_reader &operator=(const trajectory_file_reader &);
+
+        /**
+         * @brief check_chunks checks the index of a compressed file and decodes its times
+         * @return error message (empty if the file is valid)
+         */
+        std::string check_chunks();
+
+        /**
+         * @brief m_header header of the file
+         */
+        trajectory_header m_header;
+        /**
+         * @brief m_data first byte of the file in memory
+         */
+        const char *m_data;
+        /**
+         * @brief m_length length of the file in bytes
+         */
+        std::size_t m_length;
+        /**
+         * @brief m_copy content of the file on platforms without mmap
+         */
+        std::vector<char> m_copy;
+        /**
+         * @brief m_times decoded times of a compressed file
+         */
+        std::vector<double> m_times;
+        /**
+         * @brief m_chunk decoded states of the last chunk accessed
+         */
+        mutable std::vector<char> m_chunk;
+        /**
+         * @brief m_chunk_index index of the decoded chunk (-1 if none)
+         */
+        mutable std::size_t m_chunk_index;
+    };
+
+    /**
+     * @brief The %trajectory_writer class writes a trajectory of states with scalars of type T
+     */
+    template < class T >
+    class trajectory_writer: public trajectory_file_writer
+    {
+
+    public:
+        /**
+         * @brief trajectory_writer constructor opening the file
+         * @param filename path of the file, which is overwritten if it exists
+         * @param dimension number of scalars in a state
+         * @param buffer_size size in bytes of the write buffer
+         * @param codec compression of the states
+         */
+        trajectory_writer(const std::string &filename, const std::size_t &dimension, const std::size_t &buffer_size = 1 << 20, const trajectory_codec &codec = trajectory_codec()):
+            trajectory_file_writer(filename, dimension, trajectory_scalar<T>::code, buffer_size, codec){}
+
+        /**
+         * @brief append writes a state at the end of the trajectory
+         * @param[in] t time
+         * @param[in] x contiguous state at time t (std::vector, std::array or Eigen vector)
+         */
+        template < class State >
+        void append(const double &t, const State &x){
+            /* checked at every level since a shorter state would be read past its end */
+            if(std::size_t(x.size()) != get_dimension())
+                smartmath_throw("TRAJECTORY_WRITER: the state dimension does not match the one of the file");
+            trajectory_file_writer::append(t, static_cast<const void *>(x.data()));
+        }
+    };
+
+    /**
+     * @brief The %trajectory_reader class gives access to the states with scalars of type T of a mapped trajectory file
+     */
+    template < class T >
+    class trajectory_reader: public trajectory_file_reader
+    {
+
+    public:
+        /**
+         * @brief trajectory_reader constructor mapping the file and checking its scalar type
+         * @param filename path of the file
+         */
+        trajectory_reader(const std::string &filename): trajectory_file_reader(filename){
+            if(get_header().scalar_type != trajectory_scalar<T>::code)
+                smartmath_throw("TRAJECTORY_READER: the scalar type of the file does not match the requested one");
+        }
+
+        /**
+         * @brief time returns a time of the trajectory
+         * @param i index of the state
+         * @return time of the i-th state
+         */
+        double time(const std::size_t &i) const{
+            return times()[i];
+        }
+
+        /**
+         * @brief state returns a read-only view on a state of the trajectory, without copy if the file is not compressed
+         * @param i index of the state
+         * @return view on the i-th state
+         */
+        const_state_view<T> state(const std::size_t &i) const{
+            return const_state_view<T>(static_cast<const T *>(state_data(i)), dimension());
+        }
+
+        /**
+         * @brief copy_state copies a state of the trajectory in a container
+         * @param[in] i index of the state
+         * @param[out] x state (std::vector, std::array or Eigen vector of the right dimension)
+         */
+        template < class State >
+        void copy_state(const std::size_t &i, State &x) const{
+            const T *xi = static_cast<const T *>(state_data(i));
+            for(std::size_t j = 0; j < dimension(); j++)
+                x[j] = xi[j];
+        }
+    };
+
+}
+
+#endif // SMARTMATH_TRAJECTORY_FILE_H
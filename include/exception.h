@@ -22,6 +22,23 @@
 
 #define smartmath_throw(s) SMARTMATH_EX_THROW(s)
 
+/* Level of the sanity checks on inputs:
+ * SMARTMATH_CHECK_FULL checks every evaluation of a dynamics and every integration step,
+ * SMARTMATH_CHECK_ENTRY only checks at the entry of the integrate methods,
+ * SMARTMATH_CHECK_NONE removes the checks.
+ * The default is full checks unless NDEBUG is defined. */
+#define SMARTMATH_CHECK_NONE 0
+#define SMARTMATH_CHECK_ENTRY 1
+#define SMARTMATH_CHECK_FULL 2
+
+#ifndef SMARTMATH_CHECK_LEVEL
+#ifdef NDEBUG
+#define SMARTMATH_CHECK_LEVEL SMARTMATH_CHECK_ENTRY
+#else
+#define SMARTMATH_CHECK_LEVEL SMARTMATH_CHECK_FULL
+#endif
+#endif
+
 namespace smartmath{
 
 class smartmath_exception: public std::exception {
@@ -0,0 +1,210 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#include "../../include/Utils/trace.h"
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+namespace smartmath {
+namespace {
+
+    /* complete event of the trace */
+    struct trace_event
+    {
+        const char *name;
+        int64_t begin;
+        int64_t end;
+    };
+
+    /* number of events of the chunks of the buffers, allocated on demand */
+    const std::size_t trace_chunk = 4096;
+
+    /* events of one thread at a time: only the owner thread writes, the size being published after the event (and the chunk holding it).
+     * The buffer of an exited thread is reused by the next thread recording its first event, the events of each owner being kept. */
+    struct trace_buffer
+    {
+        trace_buffer(const std::size_t &capacity): chunks((capacity + trace_chunk - 1) / trace_chunk, NULL), capacity(capacity), size(0), dropped(0), in_use(false){}
+
+        ~trace_buffer(){
+            for(std::size_t k = 0; k < chunks.size(); k++)
+                delete[] chunks[k];
+        }
+
+        trace_event &operator[](const std::size_t &i) const{
+            return chunks[i / trace_chunk][i % trace_chunk];
+        }
+
+        std::vector<trace_event *> chunks;
+        std::size_t capacity;
+        std::atomic<std::size_t> size;
+        std::atomic<std::size_t> dropped;
+        /* owners of the buffer (index of their first event and thread number) and whether the last one is alive, guarded by trace_mutex */
+        std::vector<std::pair<std::size_t, unsigned int> > owners;
+        bool in_use;
+    };
+
+    const std::chrono::steady_clock::time_point trace_origin = std::chrono::steady_clock::now();
+
+    std::atomic<std::size_t> trace_capacity(std::size_t(1) << 20);
+
+    /* buffers of all the threads, kept after the threads exit so that their events can be written */
+    std::mutex trace_mutex;
+    std::vector<trace_buffer *> trace_buffers;
+    unsigned int trace_threads = 0;
+
+    /* buffer of the calling thread, released when the thread exits */
+    struct trace_owner
+    {
+        trace_owner(): buffer(NULL){}
+
+        ~trace_owner(){
+            if(buffer != NULL)
+            {
+                std::lock_guard<std::mutex> lock(trace_mutex);
+                buffer->in_use = false;
+            }
+        }
+
+        trace_buffer *buffer;
+    };
+
+    thread_local trace_owner trace_local;
+
+    trace_buffer *local_buffer(){
+        if(trace_local.buffer == NULL)
+        {
+            std::lock_guard<std::mutex> lock(trace_mutex);
+            trace_buffer *buffer = NULL;
+            for(std::size_t k = 0; (k < trace_buffers.size()) && (buffer == NULL); k++)
+            {
+                if(!trace_buffers[k]->in_use)
+                    buffer = trace_buffers[k];
+            }
+            if(buffer == NULL)
+            {
+                buffer = new trace_buffer(trace_capacity.load(std::memory_order_relaxed));
+                trace_buffers.push_back(buffer);
+            }
+            buffer->in_use = true;
+            buffer->owners.push_back(std::make_pair(buffer->size.load(std::memory_order_relaxed), ++trace_threads));
+            trace_local.buffer = buffer;
+        }
+        return trace_local.buffer;
+    }
+
+    /* writes a string as a JSON string */
+    void write_json_string(std::FILE *file, const char *s){
+        std::fputc('"', file);
+        for(; *s != '\0'; s++)
+        {
+            if(*s == '"' || *s == '\\')
+                std::fputc('\\', file);
+            if((unsigned char)(*s) >= 0x20)
+                std::fputc(*s, file);
+        }
+        std::fputc('"', file);
+    }
+
+}
+
+    int64_t trace_clock(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_origin).count();
+    }
+
+    void trace_record(const char *name, const int64_t &begin, const int64_t &end){
+        trace_buffer *buffer = local_buffer();
+        const std::size_t n = buffer->size.load(std::memory_order_relaxed);
+        if(n == buffer->capacity)
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        trace_event *&chunk = buffer->chunks[n / trace_chunk];
+        if(chunk == NULL)
+            chunk = new trace_event[trace_chunk];
+        trace_event &event = (*buffer)[n];
+        event.name = name;
+        event.begin = begin;
+        event.end = end;
+        buffer->size.store(n + 1, std::memory_order_release);
+    }
+
+    void trace_set_capacity(const std::size_t &events){
+        if(events == 0)
+            smartmath_throw("TRACE: the capacity of the buffers needs to be positive");
+        trace_capacity.store(events, std::memory_order_relaxed);
+    }
+
+    void trace_clear(){
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        for(std::size_t k = 0; k < trace_buffers.size(); k++)
+        {
+            trace_buffer &buffer = *trace_buffers[k];
+            buffer.size.store(0, std::memory_order_release);
+            buffer.dropped.store(0, std::memory_order_relaxed);
+            if(buffer.in_use)
+                buffer.owners.erase(buffer.owners.begin(), buffer.owners.end() - 1);
+            else
+                buffer.owners.clear();
+            if(!buffer.owners.empty())
+                buffer.owners[0].first = 0;
+        }
+    }
+
+    std::size_t trace_dropped(){
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        std::size_t dropped = 0;
+        for(std::size_t k = 0; k < trace_buffers.size(); k++)
+            dropped += trace_buffers[k]->dropped.load(std::memory_order_relaxed);
+        return dropped;
+    }
+
+    std::size_t trace_write(const std::string &filename){
+        std::FILE *file = std::fopen(filename.c_str(), "w");
+        if(file == NULL)
+            smartmath_throw("TRACE: cannot open " + filename);
+
+        std::size_t written = 0, dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(trace_mutex);
+            std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+            for(std::size_t k = 0; k < trace_buffers.size(); k++)
+            {
+                const trace_buffer &buffer = *trace_buffers[k];
+                const std::size_t n = buffer.size.load(std::memory_order_acquire);
+                std::size_t owner = 0;
+                for(std::size_t i = 0; i < n; i++)
+                {
+                    while((owner + 1 < buffer.owners.size()) && (buffer.owners[owner + 1].first <= i))
+                        owner++;
+                    const trace_event &event = buffer[i];
+                    std::fputs(written == 0 ? "\n{\"name\":" : ",\n{\"name\":", file);
+                    write_json_string(file, event.name);
+                    /* timestamps and durations are in microseconds */
+                    std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer.owners[owner].second, double(event.begin) / 1000.0, double(event.end - event.begin) / 1000.0);
+                    written++;
+                }
+                dropped += buffer.dropped.load(std::memory_order_relaxed);
+            }
+        }
+        std::fprintf(file, "\n],\"otherData\":{\"dropped_events\":\"%lu\"}}\n", (unsigned long)dropped);
+
+        if(std::fclose(file) != 0)
+            smartmath_throw("TRACE: cannot write " + filename);
+
+        return written;
+    }
+
+}
@@ -0,0 +1,607 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+#include "../../include/Utils/trajectory_file.h"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace smartmath {
+namespace {
+
+    const char trajectory_magic[8] = {'S', 'M', 'T', 'R', 'A', 'J', '\0', '\0'};
+
+    /* scalar size in bytes from the code of the header */
+    std::size_t scalar_size(const uint32_t &scalar_type){
+        if(scalar_type != 4 && scalar_type != 8)
+            smartmath_throw("TRAJECTORY_FILE: unknown scalar type");
+        return scalar_type;
+    }
+
+    /* unsigned integer with the bits of a scalar */
+    template < class S > struct scalar_word;
+    template <> struct scalar_word<float> { typedef uint32_t type; };
+    template <> struct scalar_word<double> { typedef uint64_t type; };
+
+    template < class S >
+    typename scalar_word<S>::type to_word(const S &x){
+        typename scalar_word<S>::type w;
+        std::memcpy(&w, &x, sizeof(S));
+        return w;
+    }
+
+    template < class S >
+    S from_word(const typename scalar_word<S>::type &w){
+        S x;
+        std::memcpy(&x, &w, sizeof(S));
+        return x;
+    }
+
+    /* prediction of the j-th scalar of the i-th state of a chunk by linear extrapolation of the two previous states (2 a is exact, so that the result does not depend on the contraction into a fused multiply-add) */
+    template < class S >
+    S predict(const S *v, const std::size_t &i, const std::size_t &j, const std::size_t &dimension){
+        if(i >= 2)
+            return S(2) * v[(i - 1) * dimension + j] - v[(i - 2) * dimension + j];
+        if(i == 1)
+            return v[j];
+        return S(0);
+    }
+
+    /* sequential reading of an encoded chunk with bounds checks */
+    struct chunk_input
+    {
+        chunk_input(const char *data, const std::size_t &length): m_data(reinterpret_cast<const unsigned char *>(data)), m_length(length), m_position(0){}
+
+        const unsigned char *take(const std::size_t &n){
+            if(n > m_length - m_position)
+                smartmath_throw("TRAJECTORY_CODEC: truncated chunk");
+            const unsigned char *p = m_data + m_position;
+            m_position += n;
+            return p;
+        }
+
+        uint64_t bytes(const std::size_t &n){
+            const unsigned char *p = take(n);
+            uint64_t w = 0;
+            for(std::size_t k = 0; k < n; k++)
+                w |= uint64_t(p[k]) << (8 * k);
+            return w;
+        }
+
+        uint64_t varint(){
+            uint64_t w = 0;
+            for(unsigned int shift = 0; shift < 64; shift += 7)
+            {
+                const unsigned char c = *take(1);
+                w |= uint64_t(c & 0x7f) << shift;
+                if(!(c & 0x80))
+                    return w;
+            }
+            smartmath_throw("TRAJECTORY_CODEC: invalid integer in chunk");
+        }
+
+        const unsigned char *m_data;
+        std::size_t m_length;
+        std::size_t m_position;
+    };
+
+    void put_bytes(std::vector<char> &out, const uint64_t &w, const std::size_t &n){
+        for(std::size_t k = 0; k < n; k++)
+            out.push_back(char((w >> (8 * k)) & 0xff));
+    }
+
+    void put_varint(std::vector<char> &out, uint64_t w){
+        while(w >= 0x80)
+        {
+            out.push_back(char((w & 0x7f) | 0x80));
+            w >>= 7;
+        }
+        out.push_back(char(w));
+    }
+
+    /* lossless coding: for each state, one nibble per scalar with the number of leading zero bytes of the exclusive or with the prediction, followed by the remaining bytes */
+    template < class S >
+    void encode_lossless(const S *v, const std::size_t &count, const std::size_t &dimension, std::vector<char> &out){
+        typedef typename scalar_word<S>::type word;
+        const std::size_t nbytes = sizeof(S);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            const std::size_t header = out.size();
+            out.resize(header + (dimension + 1) / 2, 0);
+            for(std::size_t j = 0; j < dimension; j++)
+            {
+                const word x = to_word(v[i * dimension + j]) ^ to_word(predict(v, i, j, dimension));
+                std::size_t zeros = 0;
+                while(zeros < nbytes && ((x >> (8 * (nbytes - 1 - zeros))) & 0xff) == 0)
+                    zeros++;
+                out[header + j / 2] |= char(zeros << (4 * (j % 2)));
+                put_bytes(out, x, nbytes - zeros);
+            }
+        }
+    }
+
+    template < class S >
+    void decode_lossless(chunk_input &in, S *v, const std::size_t &count, const std::size_t &dimension){
+        typedef typename scalar_word<S>::type word;
+        const std::size_t nbytes = sizeof(S);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            const unsigned char *header = in.take((dimension + 1) / 2);
+            for(std::size_t j = 0; j < dimension; j++)
+            {
+                const std::size_t zeros = (header[j / 2] >> (4 * (j % 2))) & 0xf;
+                if(zeros > nbytes)
+                    smartmath_throw("TRAJECTORY_CODEC: invalid header in chunk");
+                const word x = word(in.bytes(nbytes - zeros));
+                v[i * dimension + j] = from_word<S>(x ^ to_word(predict(v, i, j, dimension)));
+            }
+        }
+    }
+
+    /* reconstruction of a quantised scalar, with an explicit fused multiply-add so that the encoder and the decoder agree bit for bit */
+    template < class S >
+    S dequantise(const int64_t &q, const double &step, const S &prediction){
+        return S(std::fma(double(q), step, double(prediction)));
+    }
+
+    /* quantised coding: for each scalar, the zigzag-encoded number of steps from the prediction plus one, or zero followed by the raw scalar when the error bound cannot be met */
+    template < class S >
+    void encode_quantised(const S *v, const std::size_t &count, const std::size_t &dimension, const double &tolerance, std::vector<char> &out){
+        const double step = 2.0 * tolerance;
+        std::vector<S> r(count * dimension);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            for(std::size_t j = 0; j < dimension; j++)
+            {
+                const std::size_t k = i * dimension + j;
+                const S prediction = predict(&r[0], i, j, dimension);
+                const double q = (double(v[k]) - double(prediction)) / step;
+                if(std::fabs(q) < 4.0e15)
+                {
+                    const int64_t qi = int64_t(std::floor(q + 0.5));
+                    const S rk = dequantise(qi, step, prediction);
+                    if(std::fabs(double(rk) - double(v[k])) <= tolerance)
+                    {
+                        put_varint(out, ((uint64_t(qi) << 1) ^ uint64_t(qi >> 63)) + 1);
+                        r[k] = rk;
+                        continue;
+                    }
+                }
+                put_varint(out, 0);
+                put_bytes(out, to_word(v[k]), sizeof(S));
+                r[k] = v[k];
+            }
+        }
+    }
+
+    template < class S >
+    void decode_quantised(chunk_input &in, S *v, const std::size_t &count, const std::size_t &dimension, const double &tolerance){
+        const double step = 2.0 * tolerance;
+        for(std::size_t i = 0; i < count; i++)
+        {
+            for(std::size_t j = 0; j < dimension; j++)
+            {
+                const std::size_t k = i * dimension + j;
+                const uint64_t u = in.varint();
+                if(u == 0)
+                    v[k] = from_word<S>(typename scalar_word<S>::type(in.bytes(sizeof(S))));
+                else
+                {
+                    const uint64_t z = u - 1;
+                    const int64_t qi = int64_t(z >> 1) ^ -int64_t(z & 1);
+                    v[k] = dequantise(qi, step, predict(v, i, j, dimension));
+                }
+            }
+        }
+    }
+
+    template < class S >
+    void encode_states(const trajectory_codec &codec, const std::size_t &dimension, const std::size_t &count, const S *x, std::vector<char> &out){
+        if(codec.method == trajectory_codec::lossless)
+            encode_lossless(x, count, dimension, out);
+        else
+            encode_quantised(x, count, dimension, codec.tolerance, out);
+    }
+
+    template < class S >
+    void decode_states(const trajectory_codec &codec, chunk_input &in, const std::size_t &dimension, const std::size_t &count, S *x){
+        if(codec.method == trajectory_codec::lossless)
+            decode_lossless(in, x, count, dimension);
+        else
+            decode_quantised(in, x, count, dimension, codec.tolerance);
+    }
+
+    /* checks of the parameters of a codec */
+    void check_codec(const trajectory_codec &codec){
+        if(codec.method != trajectory_codec::lossless && codec.method != trajectory_codec::quantised)
+            smartmath_throw("TRAJECTORY_CODEC: unknown compression method");
+        if(codec.chunk_states == 0)
+            smartmath_throw("TRAJECTORY_CODEC: the number of states per chunk needs to be positive");
+        if(codec.method == trajectory_codec::quantised && !(codec.tolerance > 0.0 && codec.tolerance < HUGE_VAL))
+            smartmath_throw("TRAJECTORY_CODEC: the tolerance of the quantisation needs to be positive and finite");
+    }
+
+}
+}
+
+void smartmath::encode_trajectory_chunk(const trajectory_codec &codec, const std::size_t &dimension, const uint32_t &scalar_type, const std::size_t &count,
+                                        const double *t, const void *x, std::vector<char> &out){
+
+    check_codec(codec);
+    if(count > codec.chunk_states)
+        smartmath_throw("TRAJECTORY_CODEC: too many states for one chunk");
+
+    const std::size_t start = out.size();
+    put_bytes(out, count, 4);
+    put_bytes(out, 0, 4);
+    encode_lossless(t, count, 1, out);
+    const uint64_t time_bytes = out.size() - start - 8;
+    for(std::size_t k = 0; k < 4; k++)
+        out[start + 4 + k] = char((time_bytes >> (8 * k)) & 0xff);
+
+    if(scalar_size(scalar_type) == sizeof(double))
+        encode_states(codec, dimension, count, static_cast<const double *>(x), out);
+    else
+        encode_states(codec, dimension, count, static_cast<const float *>(x), out);
+}
+
+std::size_t smartmath::decode_trajectory_chunk(const trajectory_codec &codec, const std::size_t &dimension, const uint32_t &scalar_type,
+                                               const char *data, const std::size_t &length, const std::size_t &capacity, double *t, void *x){
+
+    check_codec(codec);
+    chunk_input in(data, length);
+    const std::size_t count = in.bytes(4);
+    const std::size_t time_bytes = in.bytes(4);
+    if(count > codec.chunk_states || count > capacity)
+        smartmath_throw("TRAJECTORY_CODEC: too many states in chunk");
+
+    if(t != NULL)
+    {
+        chunk_input times(data + 8, std::min(time_bytes, length - 8));
+        decode_lossless(times, t, count, 1);
+    }
+    in.take(time_bytes);
+
+    if(x != NULL)
+    {
+        if(scalar_size(scalar_type) == sizeof(double))
+            decode_states(codec, in, dimension, count, static_cast<double *>(x));
+        else
+            decode_states(codec, in, dimension, count, static_cast<float *>(x));
+    }
+
+    return count;
+}
+
+smartmath::trajectory_file_writer::trajectory_file_writer(const std::string &filename, const std::size_t &dimension, const uint32_t &scalar_type, const std::size_t &buffer_size,
+                                                          const trajectory_codec &codec):
+    m_filename(filename), m_file(NULL), m_buffer(buffer_size), m_dimension(dimension), m_scalar_type(scalar_type), m_position(0), m_count(0), m_codec(codec){
+
+    scalar_size(scalar_type);
+    if(dimension == 0)
+        smartmath_throw("TRAJECTORY_WRITER: the state dimension needs to be positive");
+    if(codec.method != trajectory_codec::none)
+    {
+        check_codec(codec);
+        m_times.reserve(codec.chunk_states);
+        m_chunk.reserve(codec.chunk_states * dimension * scalar_type);
+    }
+
+    m_file = fopen(filename.c_str(), "wb");
+    if(m_file == NULL)
+        smartmath_throw("TRAJECTORY_WRITER: cannot open " + filename);
+    if(buffer_size > 0)
+        setvbuf(m_file, &m_buffer[0], _IOFBF, buffer_size);
+
+    /* placeholder header with a null time offset, overwritten by close() */
+    char header[trajectory_header::size];
+    std::memset(header, 0, trajectory_header::size);
+    trajectory_header *placeholder = reinterpret_cast<trajectory_header *>(header);
+    std::memcpy(placeholder->magic, trajectory_magic, sizeof(placeholder->magic));
+    placeholder->version = trajectory_header::current_version;
+    placeholder->scalar_type = scalar_type;
+    placeholder->dimension = dimension;
+    placeholder->state_offset = trajectory_header::size;
+    if(fwrite(header, 1, trajectory_header::size, m_file) != trajectory_header::size)
+    {
+        fclose(m_file);
+        m_file = NULL;
+        smartmath_throw("TRAJECTORY_WRITER: cannot write the header of " + filename);
+    }
+    m_position = trajectory_header::size;
+}
+
+smartmath::trajectory_file_writer::~trajectory_file_writer(){
+    if(m_file != NULL)
+    {
+        try
+        {
+            close();
+        }
+        catch(const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+}
+
+void smartmath::trajectory_file_writer::append(const double &t, const void *x){
+
+    if(m_file == NULL)
+        smartmath_throw("TRAJECTORY_WRITER: the file " + m_filename + " is closed");
+
+    const std::size_t bytes = m_dimension * scalar_size(m_scalar_type);
+    if(m_codec.method != trajectory_codec::none)
+    {
+        const char *xc = static_cast<const char *>(x);
+        m_chunk.insert(m_chunk.end(), xc, xc + bytes);
+        m_times.push_back(t);
+        m_count++;
+        if(m_times.size() == m_codec.chunk_states)
+            write_chunk();
+        return;
+    }
+
+    if(fwrite(x, 1, bytes, m_file) != bytes)
+        smartmath_throw("TRAJECTORY_WRITER: cannot write to " + m_filename);
+    m_position += bytes;
+    m_times.push_back(t);
+    m_count++;
+}
+
+void smartmath::trajectory_file_writer::append(const double *t, const void *x, const std::size_t &count){
+
+    if(m_file == NULL)
+        smartmath_throw("TRAJECTORY_WRITER: the file " + m_filename + " is closed");
+
+    if(m_codec.method != trajectory_codec::none)
+    {
+        const std::size_t bytes = m_dimension * scalar_size(m_scalar_type);
+        for(std::size_t i = 0; i < count; i++)
+            append(t[i], static_cast<const char *>(x) + i * bytes);
+        return;
+    }
+
+    const std::size_t bytes = count * m_dimension * scalar_size(m_scalar_type);
+    if(fwrite(x, 1, bytes, m_file) != bytes)
+        smartmath_throw("TRAJECTORY_WRITER: cannot write to " + m_filename);
+    m_position += bytes;
+    m_times.insert(m_times.end(), t, t + count);
+    m_count += count;
+}
+
+void smartmath::trajectory_file_writer::write_chunk(){
+
+    if(m_times.empty())
+        return;
+
+    m_encoded.clear();
+    encode_trajectory_chunk(m_codec, m_dimension, m_scalar_type, m_times.size(), &m_times[0], &m_chunk[0], m_encoded);
+    if(fwrite(&m_encoded[0], 1, m_encoded.size(), m_file) != m_encoded.size())
+        smartmath_throw("TRAJECTORY_WRITER: cannot write to " + m_filename);
+    m_chunk_offsets.push_back(m_position);
+    m_position += m_encoded.size();
+    m_times.clear();
+    m_chunk.clear();
+}
+
+bool smartmath::trajectory_file_writer::pad(){
+    static const char zeros[64] = {0};
+    const std::size_t padding = (64 - m_position % 64) % 64;
+    m_position += padding;
+    return fwrite(zeros, 1, padding, m_file) == padding;
+}
+
+void smartmath::trajectory_file_writer::close(){
+
+    if(m_file == NULL)
+        return;
+
+    trajectory_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, trajectory_magic, sizeof(header.magic));
+    header.version = trajectory_header::current_version;
+    header.scalar_type = m_scalar_type;
+    header.dimension = m_dimension;
+    header.count = m_count;
+    header.state_offset = trajectory_header::size;
+
+    bool ok = true;
+    if(m_codec.method != trajectory_codec::none)
+    {
+        header.codec = m_codec.method;
+        header.chunk_states = m_codec.chunk_states;
+        header.tolerance = m_codec.tolerance;
+        try
+        {
+            write_chunk();
+        }
+        catch(const std::exception &)
+        {
+            ok = false;
+        }
+        m_chunk_offsets.push_back(m_position);
+    }
+
+    ok = ok && pad();
+    header.time_offset = m_position;
+
+    if(m_codec.method != trajectory_codec::none)
+        ok = ok && (fwrite(&m_chunk_offsets[0], sizeof(uint64_t), m_chunk_offsets.size(), m_file) == m_chunk_offsets.size());
+    else if(ok && m_count > 0)
+        ok = (fwrite(&m_times[0], sizeof(double), m_count, m_file) == m_count);
+    if(ok)
+        ok = (fseek(m_file, 0, SEEK_SET) == 0) && (fwrite(&header, sizeof(header), 1, m_file) == 1);
+    ok = (fclose(m_file) == 0) && ok;
+    m_file = NULL;
+
+    std::vector<double>().swap(m_times);
+    std::vector<char>().swap(m_chunk);
+    std::vector<uint64_t>().swap(m_chunk_offsets);
+    if(!ok)
+        smartmath_throw("TRAJECTORY_WRITER: cannot finalise " + m_filename);
+}
+
+smartmath::trajectory_file_reader::trajectory_file_reader(const std::string &filename): m_data(NULL), m_length(0), m_chunk_index(std::size_t(-1)){
+
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        smartmath_throw("TRAJECTORY_READER: cannot open " + filename);
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        smartmath_throw("TRAJECTORY_READER: cannot read the size of " + filename);
+    }
+    m_length = info.st_size;
+    if(m_length < trajectory_header::size)
+    {
+        ::close(fd);
+        smartmath_throw("TRAJECTORY_READER: " + filename + " is too short to be a trajectory file");
+    }
+    void *data = mmap(NULL, m_length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        smartmath_throw("TRAJECTORY_READER: cannot map " + filename);
+    m_data = static_cast<const char *>(data);
+#else
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(file == NULL)
+        smartmath_throw("TRAJECTORY_READER: cannot open " + filename);
+    fseek(file, 0, SEEK_END);
+    m_length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    m_copy.resize(m_length);
+    const bool ok = (m_length > 0) && (fread(&m_copy[0], 1, m_length, file) == m_length);
+    fclose(file);
+    if(!ok || m_length < trajectory_header::size)
+        smartmath_throw("TRAJECTORY_READER: cannot read " + filename);
+    m_data = &m_copy[0];
+#endif
+
+    std::memcpy(&m_header, m_data, sizeof(m_header));
+
+    std::string error;
+    if(std::memcmp(m_header.magic, trajectory_magic, sizeof(trajectory_magic)) != 0)
+        error = " is not a trajectory file";
+    else if(m_header.version != trajectory_header::current_version)
+        error = " has an unsupported version";
+    else if(m_header.scalar_type != 4 && m_header.scalar_type != 8)
+        error = " has an unknown scalar type";
+    else if(m_header.time_offset == 0)
+        error = " has not been closed properly";
+    else if(m_header.codec != trajectory_codec::none)
+        error = check_chunks();
+    /* the dimension is bounded by the length of the file before the size of a state is formed, so that the products below cannot wrap */
+    else if(m_header.state_offset % 64 != 0 || m_header.time_offset % 64 != 0
+            || m_header.dimension == 0 || m_header.state_offset > m_length
+            || (m_header.count > 0 && (m_header.dimension > (m_length - m_header.state_offset) / m_header.scalar_type
+                                       || m_header.count > (m_length - m_header.state_offset) / (m_header.dimension * m_header.scalar_type)))
+            || m_header.state_offset + m_header.count * m_header.dimension * m_header.scalar_type > m_header.time_offset
+            || m_header.time_offset > m_length
+            || m_header.count > (m_length - m_header.time_offset) / sizeof(double))
+        error = " is truncated or corrupted";
+
+    if(!error.empty())
+    {
+#ifndef _WIN32
+        munmap(const_cast<char *>(m_data), m_length);
+#endif
+        smartmath_throw("TRAJECTORY_READER: " + filename + error);
+    }
+}
+
+smartmath::trajectory_file_reader::~trajectory_file_reader(){
+#ifndef _WIN32
+    if(m_data != NULL)
+        munmap(const_cast<char *>(m_data), m_length);
+#endif
+}
+
+std::string smartmath::trajectory_file_reader::check_chunks(){
+
+    const trajectory_codec codec(trajectory_codec::method_type(m_header.codec), m_header.tolerance, m_header.chunk_states);
+    try
+    {
+        check_codec(codec);
+    }
+    catch(const std::exception &)
+    {
+        return " has an unknown compression";
+    }
+
+    /* every encoded time takes at least one byte and every encoded state at least half a byte per scalar, which bounds the count and the dimension
+     * (hence the size of the decoded states) before anything is allocated */
+    if(m_header.dimension == 0 || m_header.count > m_length || m_header.count > 2 * m_length / m_header.dimension)
+        return " is truncated or corrupted";
+    const uint64_t chunks = (m_header.count + codec.chunk_states - 1) / codec.chunk_states;
+    if(m_header.state_offset > m_header.time_offset || m_header.time_offset % 64 != 0
+       || m_header.time_offset > m_length || chunks + 1 > (m_length - m_header.time_offset) / sizeof(uint64_t))
+        return " is truncated or corrupted";
+
+    const uint64_t *offsets = reinterpret_cast<const uint64_t *>(m_data + m_header.time_offset);
+    if(offsets[0] != m_header.state_offset || offsets[chunks] > m_header.time_offset)
+        return " is truncated or corrupted";
+
+    /* the times are decoded once, the states on demand */
+    m_times.resize(m_header.count);
+    try
+    {
+        for(uint64_t k = 0; k < chunks; k++)
+        {
+            if(offsets[k + 1] < offsets[k])
+                return " is truncated or corrupted";
+            /* the last chunk only has room for the remaining times */
+            const std::size_t expected = std::min<uint64_t>(codec.chunk_states, m_header.count - k * codec.chunk_states);
+            const std::size_t n = decode_trajectory_chunk(codec, m_header.dimension, m_header.scalar_type, m_data + offsets[k], offsets[k + 1] - offsets[k],
+                                                          expected, &m_times[k * codec.chunk_states], NULL);
+            if(n != expected)
+                return " is truncated or corrupted";
+        }
+    }
+    catch(const std::exception &)
+    {
+        return " is truncated or corrupted";
+    }
+
+    return "";
+}
+
+const void *smartmath::trajectory_file_reader::state_data(const std::size_t &i) const{
+
+    const std::size_t bytes = m_header.dimension * m_header.scalar_type;
+    if(m_header.codec == trajectory_codec::none)
+        return m_data + m_header.state_offset + i * bytes;
+
+    const std::size_t chunk = i / m_header.chunk_states;
+    if(chunk != m_chunk_index)
+    {
+        const trajectory_codec codec(trajectory_codec::method_type(m_header.codec), m_header.tolerance, m_header.chunk_states);
+        const uint64_t *offsets = reinterpret_cast<const uint64_t *>(m_data + m_header.time_offset);
+        /* the chunk holds at most the states of the file, bounded when the file was opened */
+        const std::size_t states = std::min<uint64_t>(codec.chunk_states, m_header.count);
+        m_chunk.resize(states * bytes);
+        m_chunk_index = std::size_t(-1);
+        decode_trajectory_chunk(codec, m_header.dimension, m_header.scalar_type, m_data + offsets[chunk], offsets[chunk + 1] - offsets[chunk], states, NULL, &m_chunk[0]);
+        m_chunk_index = chunk;
+    }
+
+    return &m_chunk[(i - chunk * m_header.chunk_states) * bytes];
+}
@@ -0,0 +1,224 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+/*
+-------Copyright (C) 2017 University of Strathclyde and Authors-------
+------------ e-mail: annalisa.riccardi@strath.ac.uk ------------------
+------------ e-mail: carlos.ortega@strath.ac.uk ----------------------
+--------- Author: Annalisa Riccardi and Carlos Ortega Absil ----------
+*/
+
+/* Round trip and malformed input checks of the compression of trajectory files.
+ *
+ * A one-day spaceflight orbit (rk4, 2e5 steps, dimension 7) is written raw, lossless and quantised at 1e-6:
+ * the lossless file decodes bit for bit and takes at most 50% of the raw size, the quantised one is within the tolerance and takes at most 25%.
+ * Chunks announcing more states than the room given to the decoder, in memory or in a file, must be rejected before anything is written,
+ * as well as headers whose dimension makes the size of the states wrap around, and states of the wrong dimension given to the writers. */
+
+#include "../../include/smartmath.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace smartmath;
+using namespace smartmath::integrator;
+using namespace smartmath::dynamics;
+
+int failures = 0;
+
+#define CHECK(condition) \
+    do { if(!(condition)) { std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; failures++; } } while(0)
+
+#define CHECK_THROWS(statement) \
+    do { bool thrown = false; try { statement; } catch(const std::exception &) { thrown = true; } \
+         if(!thrown) { std::cerr << __FILE__ << ":" << __LINE__ << ": no exception: " #statement << std::endl; failures++; } } while(0)
+
+long file_size(const std::string &filename){
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(file == NULL)
+        return -1;
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+void write_orbit(const std::string &filename, const trajectory_codec &codec){
+    std::vector<double> param(10, 0.0);
+    param[5] = 7000.0;
+    spaceflight<double> dyn(param);
+    rk4<double> propagator(&dyn);
+    const std::vector<double> x0 = {7.0e6, 0.0, 0.0, 0.0, 7546.0, 100.0, 1000.0};
+
+    trajectory_writer<double> writer(filename, 7, 1 << 20, codec);
+    trajectory_observer<double> observer(writer);
+    propagator.integrate(0.0, 86400.0, 200000, x0, observer);
+}
+
+void check_orbit(){
+    write_orbit("test_codec_raw.traj", trajectory_codec());
+    write_orbit("test_codec_lossless.traj", trajectory_codec(trajectory_codec::lossless));
+    write_orbit("test_codec_quantised.traj", trajectory_codec(trajectory_codec::quantised, 1.0e-6));
+
+    const double raw = file_size("test_codec_raw.traj");
+    CHECK(file_size("test_codec_lossless.traj") <= 0.50 * raw);
+    CHECK(file_size("test_codec_quantised.traj") <= 0.25 * raw);
+
+    trajectory_reader<double> r("test_codec_raw.traj"), l("test_codec_lossless.traj"), q("test_codec_quantised.traj");
+    CHECK(l.is_compressed() && q.is_compressed() && !r.is_compressed());
+    CHECK(l.size() == r.size() && q.size() == r.size());
+
+    bool identical = true, times = true;
+    double error = 0.0;
+    for(std::size_t i = 0; i < r.size(); i++)
+    {
+        times = times && (l.time(i) == r.time(i)) && (q.time(i) == r.time(i));
+        const_state_view<double> x = r.state(i), xl = l.state(i);
+        for(std::size_t j = 0; j < 7; j++)
+            identical = identical && (std::memcmp(&xl[j], &x[j], sizeof(double)) == 0);
+        const_state_view<double> xq = q.state(i);
+        for(std::size_t j = 0; j < 7; j++)
+            error = std::max(error, std::fabs(xq[j] - x[j]));
+    }
+    CHECK(identical);
+    CHECK(times);
+    CHECK(error <= 1.0e-6);
+}
+
+void check_float(){
+    /* single precision, special values, a partial last chunk and access in reverse order */
+    {
+        trajectory_writer<float> writer("test_codec_float.traj", 3, 1 << 20, trajectory_codec(trajectory_codec::lossless, 0.0, 7));
+        std::vector<float> x(3);
+        for(int i = 0; i < 100; i++)
+        {
+            x[0] = std::sin(0.1f * float(i));
+            x[1] = float(i);
+            x[2] = (i % 2 == 0) ? NAN : -INFINITY;
+            writer.append(0.25 * i, x);
+        }
+    }
+    trajectory_reader<float> reader("test_codec_float.traj");
+    CHECK(reader.size() == 100);
+    for(int i = 99; i >= 0; i--)
+    {
+        const_state_view<float> x = reader.state(i);
+        CHECK(x[0] == std::sin(0.1f * float(i)) && x[1] == float(i) && reader.time(i) == 0.25 * i);
+        CHECK((i % 2 == 0) ? std::isnan(x[2]) : (x[2] == -INFINITY));
+    }
+}
+
+void check_malformed_chunks(){
+    const trajectory_codec codec(trajectory_codec::lossless, 0.0, 10);
+    std::vector<double> t(10), x(20);
+    for(unsigned int i = 0; i < 10; i++)
+    {
+        t[i] = i;
+        x[2 * i] = std::cos(0.1 * i);
+        x[2 * i + 1] = std::sin(0.1 * i);
+    }
+    std::vector<char> chunk;
+    encode_trajectory_chunk(codec, 2, 8, 10, &t[0], &x[0], chunk);
+
+    std::vector<double> t2(10), x2(20);
+    CHECK(decode_trajectory_chunk(codec, 2, 8, &chunk[0], chunk.size(), 10, &t2[0], &x2[0]) == 10);
+    CHECK(t2 == t && x2 == x);
+
+    /* a chunk larger than the room given is rejected before anything is written */
+    std::vector<double> small(5, -1.0);
+    CHECK_THROWS(decode_trajectory_chunk(codec, 2, 8, &chunk[0], chunk.size(), 5, &small[0], NULL));
+    CHECK(small == std::vector<double>(5, -1.0));
+    CHECK_THROWS(decode_trajectory_chunk(trajectory_codec(trajectory_codec::lossless, 0.0, 8), 2, 8, &chunk[0], chunk.size(), 8, &t2[0], NULL));
+    CHECK_THROWS(decode_trajectory_chunk(codec, 2, 8, &chunk[0], chunk.size() / 2, 10, &t2[0], &x2[0]));
+    CHECK_THROWS(encode_trajectory_chunk(codec, 2, 8, 11, &t[0], &x[0], chunk));
+
+    /* a file whose last chunk announces a full chunk instead of the remaining states */
+    {
+        trajectory_writer<double> writer("test_codec_malformed.traj", 2, 1 << 20, trajectory_codec(trajectory_codec::lossless, 0.0, 16));
+        std::vector<double> y(2);
+        for(unsigned int i = 0; i < 20; i++)
+        {
+            y[0] = std::cos(0.1 * i);
+            y[1] = std::sin(0.1 * i);
+            writer.append(double(i), y);
+        }
+    }
+    uint64_t last = 0;
+    {
+        trajectory_reader<double> reader("test_codec_malformed.traj");
+        CHECK(reader.size() == 20);
+        /* the index of the chunks holds their offsets: the second one is the last chunk */
+        FILE *file = fopen("test_codec_malformed.traj", "rb");
+        CHECK(file != NULL);
+        fseek(file, long(reader.get_header().time_offset + sizeof(uint64_t)), SEEK_SET);
+        CHECK(fread(&last, sizeof(uint64_t), 1, file) == 1);
+        fclose(file);
+    }
+    FILE *file = fopen("test_codec_malformed.traj", "r+b");
+    CHECK(file != NULL);
+    const unsigned char count[4] = {16, 0, 0, 0};
+    fseek(file, long(last), SEEK_SET);
+    CHECK(fwrite(count, 1, 4, file) == 4);
+    fclose(file);
+    CHECK_THROWS(trajectory_reader<double>("test_codec_malformed.traj"));
+
+}
+
+void patch_dimension(const std::string &filename, const uint64_t &dimension){
+    FILE *file = fopen(filename.c_str(), "r+b");
+    CHECK(file != NULL);
+    fseek(file, long(offsetof(trajectory_header, dimension)), SEEK_SET);
+    CHECK(fwrite(&dimension, sizeof(uint64_t), 1, file) == 1);
+    fclose(file);
+}
+
+void check_malformed_headers(){
+    /* 2^61 scalars of 8 bytes wrap around to a state of 0 bytes */
+    const uint64_t huge = uint64_t(1) << 61;
+    const char *names[2] = {"test_codec_header_raw.traj", "test_codec_header_lossless.traj"};
+    const trajectory_codec codecs[2] = {trajectory_codec(), trajectory_codec(trajectory_codec::lossless)};
+    for(int k = 0; k < 2; k++)
+    {
+        {
+            trajectory_writer<double> writer(names[k], 3, 1 << 20, codecs[k]);
+            std::vector<double> x(3, 1.0);
+            for(int i = 0; i < 10; i++)
+                writer.append(double(i), x);
+
+            /* a state of the wrong dimension is never read */
+            CHECK_THROWS(writer.append(10.0, std::vector<double>(2, 1.0)));
+        }
+        patch_dimension(names[k], huge);
+        CHECK_THROWS(trajectory_reader<double>(std::string(names[k])));
+        patch_dimension(names[k], huge + 1);
+        CHECK_THROWS(trajectory_reader<double>(std::string(names[k])));
+    }
+
+    {
+        async_trajectory_writer<double> writer("test_codec_header_async.traj", 3);
+        CHECK_THROWS(writer.append(0.0, std::vector<double>(2, 1.0)));
+    }
+
+    for(const char *name: {"test_codec_raw.traj", "test_codec_lossless.traj", "test_codec_quantised.traj", "test_codec_float.traj", "test_codec_malformed.traj",
+                           "test_codec_header_raw.traj", "test_codec_header_lossless.traj", "test_codec_header_async.traj"})
+        std::remove(name);
+}
+
+int main(){
+
+    check_orbit();
+    check_float();
+    check_malformed_chunks();
+    check_malformed_headers();
+
+    if(failures > 0)
+    {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "trajectory codec: all checks passed" << std::endl;
+
+    return 0;
+}